@@ -26,6 +26,9 @@
 #include "WebHandler.h"
 #include "DbgPrint.h"
 #include "RecoveryMode.h"
+#include "JsonWriter.h"
+#include "CborWriter.h"
+#include "EventLog.h"
 
 API::API()
 {
@@ -33,212 +36,270 @@ API::API()
 
 // ++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
 // Display JSON Object - Send everytime when connect to API
-void API::displayObj(JsonObject &jObj)
+void API::displayObj(ApiWriter &writer)
 {
-  jObj["updname"] = gDisplay->getUpdateName();
-  jObj["orientation"] = (uint16_t)gDisplay->getOrientation();
+  writer.addString("updname", gDisplay->getUpdateName());
+  writer.addUInt("orientation", gDisplay->getOrientation());
 }
 
 // ++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
 // Device JSON Object - Send everytime when connect to API
-void API::deviceObj(JsonObject &jObj)
+void API::deviceObj(ApiWriter &writer)
 {
 
-  jObj["device"] = gSystem->getDeviceName();
-  jObj["serial"] = gSystem->getSerialNumber();
-  jObj["cpu"] = gSystem->getCpuName();
-  jObj["flash_size"] = gSystem->getFlashSize();
+  writer.addString("device", gSystem->getDeviceName());
+  writer.addString("serial", gSystem->getSerialNumber());
+  writer.addString("cpu", gSystem->getCpuName());
+  writer.addUInt("flash_size", gSystem->getFlashSize());
 
-  if (gSystem->item.read(ItemNvsKeys::kItem) != "")
-    jObj["item"] = gSystem->item.read(ItemNvsKeys::kItem);
+  String item = gSystem->item.read(ItemNvsKeys::kItem);
+  if (item != "")
+    writer.addString("item", item);
 
-  jObj["hw_version"] = String("v") + String(gSystem->getHardwareVersion());
+  writer.addString("hw_version", String("v") + String(gSystem->getHardwareVersion()));
 
-  jObj["sw_version"] = FIRMWAREVERSION;
-  jObj["api_version"] = SERVERAPIVERSION;
-  jObj["language"] = gSystem->getLanguage();
+  writer.addString("sw_version", FIRMWAREVERSION);
+  writer.addString("api_version", SERVERAPIVERSION);
+  writer.addString("language", gSystem->getLanguage());
 }
 
 // ++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
 // System JSON Object
-void API::systemObj(JsonObject &jObj, bool settings)
+void API::systemObj(ApiWriter &writer, bool settings)
 {
+  char buffer[12];
 
-  jObj["time"] = String(now());
-  jObj["unit"] = String((char)gSystem->temperatures.getUnit());
+  snprintf(buffer, sizeof(buffer), "%lu", (unsigned long)now());
+  writer.addString("time", buffer);
+  snprintf(buffer, sizeof(buffer), "%c", (char)gSystem->temperatures.getUnit());
+  writer.addString("unit", buffer);
 
   if (!settings)
   {
     if (gSystem->battery)
     {
-      jObj["soc"] = gSystem->battery->percentage;
-      jObj["charge"] = gSystem->battery->isCharging();
+      writer.addInt("soc", gSystem->battery->percentage);
+      writer.addBool("charge", gSystem->battery->isCharging());
     }
-    jObj["rssi"] = gSystem->wlan.getRssi();
-    jObj["online"] = gSystem->cloud.state;
+    writer.addInt("rssi", gSystem->wlan.getRssi());
+    writer.addUInt("online", gSystem->cloud.state);
   }
   else
   {
-    jObj["ap"] = gSystem->wlan.getAccessPointName();
-    jObj["host"] = gSystem->wlan.getHostName();
-    jObj["language"] = gSystem->getLanguage();
-    jObj["version"] = FIRMWAREVERSION;
-    jObj["getupdate"] = gSystem->otaUpdate.getVersion();
-    jObj["autoupd"] = gSystem->otaUpdate.getAutoUpdate();
-    jObj["prerelease"] = gSystem->otaUpdate.getPrerelease();
-    jObj["crashreport"] = gSystem->getCrashReport();
-    jObj["hwversion"] = String("V") + String(gSystem->getHardwareVersion());
+    writer.addString("ap", gSystem->wlan.getAccessPointName());
+    writer.addString("host", gSystem->wlan.getHostName());
+    writer.addString("language", gSystem->getLanguage());
+    writer.addString("version", FIRMWAREVERSION);
+    writer.addString("getupdate", gSystem->otaUpdate.getVersion());
+    writer.addBool("autoupd", gSystem->otaUpdate.getAutoUpdate());
+    writer.addBool("prerelease", gSystem->otaUpdate.getPrerelease());
+    writer.addBool("crashreport", gSystem->getCrashReport());
+    writer.addString("hwversion", String("V") + String(gSystem->getHardwareVersion()));
   }
 }
 
 // ++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
-// Channel JSON Array
-void API::channelAry(JsonArray &jAry, int cc)
+// Channel JSON Object
+void API::channelObj(ApiWriter &writer, uint8_t index, bool custom)
 {
+  TemperatureBase *temperature = gSystem->temperatures[index];
 
-  int i = 0;
-  if (cc < gSystem->temperatures.count())
-    i = cc - 1; // nur ein Channel
+  if (NULL == temperature)
+    return;
 
-  for (i; i < cc; i++)
+  channelValueObj(writer, index, custom, limit_float(temperature->getValue(), index), temperature->isConnected());
+}
+
+// channel settings with the given value, also used for buffered cloud samples
+void API::channelValueObj(ApiWriter &writer, uint8_t index, bool custom, float value, boolean connected)
+{
+  TemperatureBase *temperature = gSystem->temperatures[index];
+
+  if (NULL == temperature)
+    return;
+
+  writer.beginObject();
+  writer.addUInt("number", index + 1u);
+  writer.addString("name", temperature->getName());
+  writer.addUInt("typ", temperature->getType());
+
+  // custom cloud wants null for inactive channels
+  if (custom && (INACTIVEVALUE == value))
+    writer.addNull("temp");
+  else
+    writer.addFloat("temp", value);
+
+  writer.addFloat("min", temperature->getMinValue());
+  writer.addFloat("max", temperature->getMaxValue());
+  writer.addUInt("alarm", (uint8_t)temperature->getAlarmSetting());
+  writer.addString("color", temperature->getColor());
+  writer.addBool("fixed", temperature->isFixedSensor());
+  writer.addBool("connected", connected);
+
+  if (custom)
   {
-    TemperatureBase *temperature = gSystem->temperatures[i];
-    if (temperature != NULL)
-    {
-      JsonObject &data = jAry.createNestedObject();
-      data["number"] = i + 1;
-      data["name"] = temperature->getName();
-      data["typ"] = temperature->getType();
-      data["temp"] = limit_float(temperature->getValue(), i);
-      data["min"] = temperature->getMinValue();
-      data["max"] = temperature->getMaxValue();
-      data["alarm"] = (uint8_t)temperature->getAlarmSetting();
-      data["color"] = temperature->getColor();
-      data["fixed"] = temperature->isFixedSensor();
-      data["connected"] = temperature->isConnected();
-    }
+    char unit[2] = {(char)gSystem->temperatures.getUnit(), '\0'};
+    writer.addString("unit", unit);
   }
+
+  writer.endObject();
+}
+
+void API::channelAry(ApiWriter &writer, bool custom)
+{
+  for (uint8_t i = 0u; i < gSystem->temperatures.count(); i++)
+    channelObj(writer, i, custom);
 }
 
 // ++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
 // Pitmaster Types JSON Array
-void API::pitTyp(JsonObject &jObj)
+void API::pitTyp(ApiWriter &writer)
 {
 
-  JsonArray &_typ = jObj.createNestedArray("type");
-  _typ.add("off");
-  _typ.add("manual");
-  _typ.add("auto");
+  writer.beginArray("type");
+  writer.addString(NULL, "off");
+  writer.addString(NULL, "manual");
+  writer.addString(NULL, "auto");
+  writer.endArray();
 }
 
 // ++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
-// Pitmaster JSON Array
-void API::pitAry(JsonArray &jAry, int cc)
+// Pitmaster JSON Object
+void API::pitObj(ApiWriter &writer, uint8_t index)
+{
+  Pitmaster *pm = gSystem->pitmasters[index];
+
+  if (NULL == pm)
+    return;
+
+  pitValueObj(writer, index, (uint8_t)pm->getValue(), pm->getTargetTemperature(), pm->getType());
+}
+
+// pitmaster settings with the given output, also used for buffered cloud samples
+void API::pitValueObj(ApiWriter &writer, uint8_t index, uint8_t value, float set, uint8_t type)
 {
+  const char *sc[2] = {"#ff0000", "#FE2EF7"};
+  const char *vc[2] = {"#000000", "#848484"};
 
-  String sc[2] = {"#ff0000", "#FE2EF7"};
-  String vc[2] = {"#000000", "#848484"};
+  Pitmaster *pm = gSystem->pitmasters[index];
 
-  for (uint8_t i = 0u; i < cc; i++)
+  if (NULL == pm)
+    return;
+
+  writer.beginObject();
+  writer.addUInt("id", index);
+  writer.addUInt("channel", TemperatureGrp::getIndex(pm->getAssignedTemperature()) + 1u);
+  writer.addUInt("pid", pm->getAssignedProfile()->id);
+  writer.addUInt("value", value);
+  writer.addFloat("set", set);
+  switch (type)
   {
-    Pitmaster *pm = gSystem->pitmasters[i];
-    if (pm)
-    {
-      JsonObject &ma = jAry.createNestedObject();
-      ma["id"] = i;
-      ma["channel"] = TemperatureGrp::getIndex(pm->getAssignedTemperature()) + 1u;
-      ma["pid"] = pm->getAssignedProfile()->id;
-      ma["value"] = (uint8_t)pm->getValue();
-      ma["set"] = pm->getTargetTemperature();
-      switch (pm->getType())
-      {
-      case pm_off:
-        ma["typ"] = "off";
-        break;
-      case pm_manual:
-        ma["typ"] = "manual";
-        break;
-      case pm_auto:
-        ma["typ"] = "auto";
-        break;
-      }
-      switch (pm->getTypeLast())
-      {
-      case pm_manual:
-        ma["typ_last"] = "manual";
-        break;
-      case pm_auto:
-        ma["typ_last"] = "auto";
-        break;
-      }
-      ma["set_color"] = sc[i];
-      ma["value_color"] = vc[i];
-    }
+  case pm_off:
+    writer.addString("typ", "off");
+    break;
+  case pm_manual:
+    writer.addString("typ", "manual");
+    break;
+  case pm_auto:
+    writer.addString("typ", "auto");
+    break;
   }
+  switch (pm->getTypeLast())
+  {
+  case pm_manual:
+    writer.addString("typ_last", "manual");
+    break;
+  case pm_auto:
+    writer.addString("typ_last", "auto");
+    break;
+  }
+  writer.addString("set_color", (index < 2u) ? sc[index] : "");
+  writer.addString("value_color", (index < 2u) ? vc[index] : "");
+  writer.endObject();
+}
+
+// ++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+// Pitmaster JSON Array
+void API::pitAry(ApiWriter &writer)
+{
+  for (uint8_t i = 0u; i < gSystem->pitmasters.count(); i++)
+    pitObj(writer, i);
+}
+
+// ++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+// PID JSON Object
+void API::pidObj(ApiWriter &writer, uint8_t index)
+{
+  PitmasterProfile *profile = gSystem->getPitmasterProfile(index);
+
+  if (NULL == profile)
+    return;
+
+  writer.beginObject();
+  writer.addString("name", profile->name);
+  writer.addUInt("id", profile->id);
+  writer.addUInt("aktor", profile->actuator);
+  writer.addFloat("Kp", limit_float(profile->kp, -1));
+  writer.addFloat("Ki", limit_float(profile->ki, -1));
+  writer.addFloat("Kd", limit_float(profile->kd, -1));
+  writer.addFloat("DCmmin", profile->dcmin);
+  writer.addFloat("DCmmax", profile->dcmax);
+  writer.addUInt("opl", profile->opl);
+  writer.addFloat("SPmin", profile->spmin);
+  writer.addFloat("SPmax", profile->spmax);
+  writer.addUInt("link", profile->link);
+  writer.addUInt("tune", profile->autotune); // noch nicht im EE gespeichert
+  writer.addUInt("jp", profile->jumppw);
+  writer.endObject();
 }
 
 // ++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
 // PID JSON Array
-void API::pidAry(JsonArray &jAry, int cc)
-{
-  for (int i = 0; i < gSystem->getPitmasterProfileCount(); i++)
-  { // pidsize
-    PitmasterProfile *profile = gSystem->getPitmasterProfile(i);
-
-    JsonObject &_pid = jAry.createNestedObject();
-    _pid["name"] = profile->name;
-    _pid["id"] = profile->id;
-    _pid["aktor"] = profile->actuator;
-    _pid["Kp"] = limit_float(profile->kp, -1);
-    _pid["Ki"] = limit_float(profile->ki, -1);
-    _pid["Kd"] = limit_float(profile->kd, -1);
-    _pid["DCmmin"] = profile->dcmin;
-    _pid["DCmmax"] = profile->dcmax;
-    _pid["opl"] = profile->opl;
-    _pid["SPmin"] = profile->spmin;
-    _pid["SPmax"] = profile->spmax;
-    _pid["link"] = profile->link;
-    _pid["tune"] = profile->autotune; // noch nicht im EE gespeichert
-    _pid["jp"] = profile->jumppw;
-  }
+void API::pidAry(ApiWriter &writer)
+{
+  for (uint8_t i = 0u; i < gSystem->getPitmasterProfileCount(); i++)
+    pidObj(writer, i);
 }
 
 // ++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
 // IoT JSON Object
-void API::iotObj(JsonObject &jObj)
+void API::iotObj(ApiWriter &writer)
 {
   MqttConfig mqttConfig = gSystem->mqtt.getConfig();
   CloudConfig cloudConfig = gSystem->cloud.getConfig();
-  jObj["PMQhost"] = String(mqttConfig.host);
-  jObj["PMQport"] = mqttConfig.port;
-  jObj["PMQuser"] = String(mqttConfig.user);
-  jObj["PMQpass"] = String(mqttConfig.password);
-  jObj["PMQqos"] = mqttConfig.QoS;
-  jObj["PMQon"] = mqttConfig.enabled;
-  jObj["PMQint"] = mqttConfig.interval;
-  jObj["CLon"] = cloudConfig.cloudEnabled;
-  jObj["CLtoken"] = cloudConfig.cloudToken;
-  jObj["CLint"] = cloudConfig.cloudInterval;
-  jObj["CLurl"] = "cloud.wlanthermo.de/index.html";
-
-  jObj["CCLon"] = cloudConfig.customEnabled;
-  jObj["CCLint"] = cloudConfig.customInterval;
-  jObj["CCLurl"] = cloudConfig.customUrl;
+  writer.addString("PMQhost", mqttConfig.host);
+  writer.addUInt("PMQport", mqttConfig.port);
+  writer.addString("PMQuser", mqttConfig.user);
+  writer.addString("PMQpass", mqttConfig.password);
+  writer.addUInt("PMQqos", mqttConfig.QoS);
+  writer.addBool("PMQon", mqttConfig.enabled);
+  writer.addInt("PMQint", mqttConfig.interval);
+  writer.addBool("PMQcbor", mqttConfig.cbor);
+  writer.addBool("CLon", cloudConfig.cloudEnabled);
+  writer.addString("CLtoken", cloudConfig.cloudToken);
+  writer.addUInt("CLint", cloudConfig.cloudInterval);
+  writer.addBool("CLdelta", cloudConfig.cloudDelta);
+  writer.addString("CLurl", "cloud.wlanthermo.de/index.html");
+
+  writer.addBool("CCLon", cloudConfig.customEnabled);
+  writer.addUInt("CCLint", cloudConfig.customInterval);
+  writer.addString("CCLurl", cloudConfig.customUrl);
+  writer.addBool("CLadapt", cloudConfig.adaptiveInterval);
+  writer.addUInt("CLfloor", cloudConfig.intervalFloor);
+  writer.addUInt("CLceil", cloudConfig.intervalCeiling);
 }
 
 // ++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
 // Notification JSON Object
-void API::notificationObj(JsonObject &jObj)
+void API::notificationObj(ApiWriter &writer)
 {
   PushTelegramType pushTelegram = gSystem->notification.getTelegramConfig();
   PushPushoverType pushPushover = gSystem->notification.getPushoverConfig();
   PushAppType pushApp = gSystem->notification.getAppConfig();
   NotificationData notificationData = gSystem->notification.getNotificationData();
 
-  JsonObject &_message = jObj.createNestedObject("message");
-  JsonArray &_services = jObj.createNestedArray("services");
-
-  _message["type"] = (uint32_t)notificationData.type;
+  writer.beginObject("message");
+  writer.addUInt("type", (uint32_t)notificationData.type);
 
   // Handle test message
   if (NotificationType::Test == notificationData.type)
@@ -269,34 +330,40 @@ void API::notificationObj(JsonObject &jObj)
   else if ((NotificationType::LowerLimit == notificationData.type) ||
            (NotificationType::UpperLimit == notificationData.type))
   {
-    _message["channel"] = (uint32_t)notificationData.channel;
-    _message["unit"] = String((char)gSystem->temperatures.getUnit());
+    char unit[2] = {(char)gSystem->temperatures.getUnit(), '\0'};
+    writer.addUInt("channel", (uint32_t)notificationData.channel);
+    writer.addString("unit", unit);
     TemperatureBase *temperature = gSystem->temperatures[notificationData.channel];
 
     if (temperature)
     {
-      _message["temp"] = (int)temperature->getValue();
-      _message["limit"] = (NotificationType::LowerLimit == notificationData.type) ? temperature->getMinValue() : temperature->getMaxValue();
+      writer.addInt("temp", (int)temperature->getValue());
+      writer.addFloat("limit", (NotificationType::LowerLimit == notificationData.type) ? temperature->getMinValue() : temperature->getMaxValue());
     }
   }
 
+  writer.endObject();
+  writer.beginArray("services");
+
   if (pushTelegram.enabled)
   {
-    JsonObject &_telegram = _services.createNestedObject();
-    _telegram["service"] = "telegram";
-    _telegram["token"] = String(pushTelegram.token);
-    _telegram["chat_id"] = String(pushTelegram.chatId);
+    writer.beginObject();
+    writer.addString("service", "telegram");
+    writer.addString("token", pushTelegram.token);
+    writer.addString("chat_id", pushTelegram.chatId);
+    writer.endObject();
   }
 
   if (pushPushover.enabled)
   {
-    JsonObject &_pushover = _services.createNestedObject();
-    _pushover["service"] = "pushover";
-    _pushover["token"] = String(pushPushover.token);
-    _pushover["user_key"] = String(pushPushover.userKey);
-    _pushover["priority"] = pushPushover.priority;
-    _pushover["retry"] = pushPushover.retry;
-    _pushover["expire"] = pushPushover.expire;
+    writer.beginObject();
+    writer.addString("service", "pushover");
+    writer.addString("token", pushPushover.token);
+    writer.addString("user_key", pushPushover.userKey);
+    writer.addUInt("priority", pushPushover.priority);
+    writer.addUInt("retry", pushPushover.retry);
+    writer.addUInt("expire", pushPushover.expire);
+    writer.endObject();
   }
 
   if (pushApp.enabled)
@@ -305,262 +372,566 @@ void API::notificationObj(JsonObject &jObj)
     {
       if (strlen(pushApp.devices[i].token) > 0u)
       {
-        JsonObject &_app = _services.createNestedObject();
-        _app["service"] = "app";
-        _app["token"] = String(pushApp.devices[i].token);
-        _app["device_id"] = DeviceId::get();
-        _app["sound"] = gSystem->notification.getNotificationSound(pushApp.devices[i].sound);
+        writer.beginObject();
+        writer.addString("service", "app");
+        writer.addString("token", pushApp.devices[i].token);
+        writer.addString("device_id", DeviceId::get());
+        writer.addString("sound", gSystem->notification.getNotificationSound(pushApp.devices[i].sound));
+        writer.endObject();
       }
     }
   }
+
+  writer.endArray();
 }
 
 // ++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
 // Crash JSON Object
-void API::crashObj(JsonObject &jObj)
+void API::crashObj(ApiWriter &writer)
 {
-  jObj["reset_reason"] = gSystem->getResetReason(0u) + String(";") + gSystem->getResetReason(1u);
-  jObj["reset_counter"] = RecoveryMode::getResetCounter();
+  writer.addString("reset_reason", gSystem->getResetReason(0u) + String(";") + gSystem->getResetReason(1u));
+  writer.addUInt("reset_counter", RecoveryMode::getResetCounter());
 }
 
 // ++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
 // Update JSON Object
-void API::updateObj(JsonObject &jObj)
+void API::updateObj(ApiWriter &writer)
 {
-  jObj["prerelease"] = gSystem->otaUpdate.getPrerelease();
+  String requestedFile = gSystem->otaUpdate.getRequestedFile();
+
+  // include also preleases for file request
+  writer.addBool("prerelease", (requestedFile != "") ? true : gSystem->otaUpdate.getPrerelease());
 
   // nach einer bestimmten Version fragen
   if (gSystem->otaUpdate.getRequestedVersion() != "false")
-    jObj["version"] = gSystem->otaUpdate.getRequestedVersion();
+    writer.addString("version", gSystem->otaUpdate.getRequestedVersion());
 
-  if (gSystem->otaUpdate.getRequestedFile() != "")
-  {
-    jObj["file"] = gSystem->otaUpdate.getRequestedFile();
-    // include also preleases for file request
-    jObj["prerelease"] = true;
-  }
+  if (requestedFile != "")
+    writer.addString("file", requestedFile);
 
   if (gSystem->otaUpdate.getForceFlag())
-    jObj["force"] = gSystem->otaUpdate.getForceFlag();
+    writer.addBool("force", gSystem->otaUpdate.getForceFlag());
 }
 
 // ++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
 // URL JSON Object
-void API::urlObj(JsonObject &jObj)
+void API::urlObj(ApiWriter &writer)
 {
 
   /*
   for (int i = 0; i < NUMITEMS(serverurl); i++) {
   
-    JsonObject& _obj = jObj.createNestedObject(serverurl[i].typ);
-    _obj["host"] =  serverurl[i].host;
-    _obj["page"] =  serverurl[i].page;
+    writer.beginObject(serverurl[i].typ);
+    writer.addString("host", serverurl[i].host);
+    writer.addString("page", serverurl[i].page);
+    writer.endObject();
   }
 */
 }
 
+ApiCounts API::getCounts()
+{
+  ApiCounts counts;
+
+  counts.channels = gSystem->temperatures.count();
+  counts.pitmasters = gSystem->pitmasters.count();
+  counts.profiles = gSystem->getPitmasterProfileCount();
+
+  return counts;
+}
+
 // ++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
-// DATA JSON Object
-void API::dataObj(JsonObject &jObj, bool cloud)
+// DATA JSON Object - one part per channel and pitmaster
+boolean API::dataPart(ApiWriter &writer, uint16_t part, bool cloud, const ApiCounts &counts)
 {
+  uint8_t channelCount = counts.channels;
+  uint8_t pitmasterCount = counts.pitmasters;
+
   // SYSTEM
-  JsonObject &_system = jObj.createNestedObject("system");
-  systemObj(_system);
+  if (0u == part)
+  {
+    writer.beginObject("system");
+    systemObj(writer);
+    writer.endObject();
+    writer.beginArray("channel");
+    return true;
+  }
+  part--;
 
   // CHANNEL
-  JsonArray &_channel = jObj.createNestedArray("channel");
-  channelAry(_channel, gSystem->temperatures.count());
-
-  //JsonObject& _master = jObj.createNestedObject("pitmaster");
+  if (part < channelCount)
+  {
+    channelObj(writer, part);
+    return true;
+  }
+  part -= channelCount;
 
   // PITMASTER  (Cloud kann noch kein Array verarbeiten)
-  if (cloud)
+  if (0u == part)
+  {
+    writer.endArray();
+
+    if (cloud)
+    {
+      writer.beginArray("pitmaster");
+    }
+    else
+    {
+      writer.beginObject("pitmaster");
+      pitTyp(writer);
+      writer.beginArray("pm");
+    }
+    return true;
+  }
+  part--;
+
+  if (part < pitmasterCount)
   {
-    JsonArray &_master = jObj.createNestedArray("pitmaster");
-    pitAry(_master, gSystem->pitmasters.count());
+    pitObj(writer, part);
+    return true;
   }
-  else
+  part -= pitmasterCount;
+
+  if (0u == part)
   {
-    JsonObject &_master = jObj.createNestedObject("pitmaster");
-    pitTyp(_master);
-    JsonArray &_pit = _master.createNestedArray("pm");
-    pitAry(_pit, gSystem->pitmasters.count());
+    writer.endArray();
+
+    if (!cloud)
+      writer.endObject();
+
+    return true;
   }
+
+  return false;
 }
 
 // ++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
-// SETTINGS JSON Object
-void API::settingsObj(JsonObject &jObj)
+// DATA JSON Object
+void API::dataObj(ApiWriter &writer, bool cloud)
+{
+  ApiCounts counts = getCounts();
+
+  for (uint16_t part = 0u; dataPart(writer, part, cloud, counts); part++)
+    ;
+}
+
+// ++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+// SETTINGS JSON Object - one part per sensor type and pid profile
+boolean API::settingsPart(ApiWriter &writer, uint16_t part, const ApiCounts &counts)
 {
+  uint8_t profileCount = counts.profiles;
+
   // SYSTEM
-  JsonObject &_system = jObj.createNestedObject("system");
-  systemObj(_system, true);
+  if (0u == part)
+  {
+    writer.beginObject("system");
+    systemObj(writer, true);
+    writer.endObject();
 
-  JsonArray &_hw = jObj.createNestedArray("hardware");
-  _hw.add(String("V") + String(gSystem->getHardwareVersion()));
+    writer.beginArray("hardware");
+    writer.addString(NULL, String("V") + String(gSystem->getHardwareVersion()));
+    writer.endArray();
 
-  JsonObject &api = jObj.createNestedObject("api");
-  api["version"] = GUIAPIVERSION;
+    writer.beginObject("api");
+    writer.addString("version", GUIAPIVERSION);
+    writer.endObject();
+
+    writer.beginArray("sensors");
+    return true;
+  }
+  part--;
 
   // SENSORS
-  JsonArray &_sensorsArray = jObj.createNestedArray("sensors");
-  for (uint8_t i = 0; i < NUM_OF_TYPES; i++)
+  if (part < NUM_OF_TYPES)
   {
-    JsonObject &_sensorObject = _sensorsArray.createNestedObject();
-    _sensorObject["type"] = (uint8_t)sensorTypeInfo[i].type;
-    _sensorObject["name"] = sensorTypeInfo[i].name;
-    _sensorObject["fixed"] = sensorTypeInfo[i].fixed;
+    writer.beginObject();
+    writer.addUInt("type", (uint8_t)sensorTypeInfo[part].type);
+    writer.addString("name", sensorTypeInfo[part].name);
+    writer.addBool("fixed", sensorTypeInfo[part].fixed);
+    writer.endObject();
+    return true;
   }
+  part -= NUM_OF_TYPES;
 
   // FEATURES
-  JsonObject &_features = jObj.createNestedObject("features");
-  _features["bluetooth"] = (gSystem->bluetooth) ? (gSystem->bluetooth->isBuiltIn()) : false;
-  _features["pitmaster"] = (boolean)(gSystem->pitmasters.count() > 0u);
+  if (0u == part)
+  {
+    writer.endArray();
+
+    writer.beginObject("features");
+    writer.addBool("bluetooth", (gSystem->bluetooth) ? (gSystem->bluetooth->isBuiltIn()) : false);
+    writer.addBool("pitmaster", (boolean)(counts.pitmasters > 0u));
+    writer.endObject();
+
+    writer.beginArray("pid");
+    return true;
+  }
+  part--;
 
   // PID-PROFILS
-  JsonArray &_pid = jObj.createNestedArray("pid");
-  pidAry(_pid, gSystem->pitmasters.count());
+  if (part < profileCount)
+  {
+    pidObj(writer, part);
+    return true;
+  }
+  part -= profileCount;
 
   // AKTORS
-  JsonArray &_aktor = jObj.createNestedArray("aktor");
-  _aktor.add("SSR");
-  _aktor.add("FAN");
-  _aktor.add("SERVO");
-  if (gSystem->getSupportDamper())
+  if (0u == part)
   {
-    _aktor.add("DAMPER");
-  }
+    writer.endArray();
 
-  // DISPLAY
-  JsonObject &_display = jObj.createNestedObject("display");
-  displayObj(_display);
+    writer.beginArray("aktor");
+    writer.addString(NULL, "SSR");
+    writer.addString(NULL, "FAN");
+    writer.addString(NULL, "SERVO");
+    if (gSystem->getSupportDamper())
+    {
+      writer.addString(NULL, "DAMPER");
+    }
+    writer.endArray();
+
+    // DISPLAY
+    writer.beginObject("display");
+    displayObj(writer);
+    writer.endObject();
+    return true;
+  }
+  part--;
 
   // IOT
-  JsonObject &_iot = jObj.createNestedObject("iot");
-  iotObj(_iot);
+  if (0u == part)
+  {
+    writer.beginObject("iot");
+    iotObj(writer);
+    writer.endObject();
+    return true;
+  }
+
+  return false;
+}
+
+// ++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+// SETTINGS JSON Object
+void API::settingsObj(ApiWriter &writer)
+{
+  ApiCounts counts = getCounts();
+
+  for (uint16_t part = 0u; settingsPart(writer, part, counts); part++)
+    ;
 }
 
 // ++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
 // CLOUD JSON Object - Level 1
-void API::cloudObj(JsonObject &jObj)
+void API::cloudObj(ApiWriter &writer)
 {
   CloudConfig cloudConfig = gSystem->cloud.getConfig();
 
-  jObj["task"] = "save";
-  jObj["api_token"] = cloudConfig.cloudToken;
+  writer.addString("task", "save");
+  writer.addString("api_token", cloudConfig.cloudToken);
 
-  JsonArray &data = jObj.createNestedArray("data");
+  writer.beginArray("data");
   // aktuelle Werte
-  JsonObject &_obj = data.createNestedObject();
-  dataObj(_obj, true);
+  writer.beginObject();
+  dataObj(writer, true);
+  writer.endObject();
+  writer.endArray();
 }
 
 // ++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
-// CUSTOM JSON Object - Level 1
-void API::customObj(JsonObject &jObj)
+// DATA JSON Object of a buffered cloud sample, delta only with the values
+void API::cloudSampleObj(ApiWriter &writer, CloudSample *sample, boolean delta)
 {
-  CloudConfig cloudConfig = gSystem->cloud.getConfig();
+  char buffer[12];
+  uint8_t channelCount = min(sample->channelCount, gSystem->temperatures.count());
+  uint8_t pitmasterCount = min(sample->pitmasterCount, gSystem->pitmasters.count());
 
-  jObj["version"] = 1;
-  jObj["interval"] = cloudConfig.customInterval;
+  writer.beginObject("system");
+  snprintf(buffer, sizeof(buffer), "%lu", (unsigned long)sample->time);
+  writer.addString("time", buffer);
 
-  // CHANNEL
-  JsonArray &_channel = jObj.createNestedArray("channel");
-  channelAry(_channel, gSystem->temperatures.count());
+  if (!delta)
+  {
+    snprintf(buffer, sizeof(buffer), "%c", (char)gSystem->temperatures.getUnit());
+    writer.addString("unit", buffer);
+  }
+
+  if (sample->soc != CLOUD_SAMPLE_NO_BATTERY)
+  {
+    writer.addInt("soc", sample->soc);
+    writer.addBool("charge", sample->charge);
+  }
+  writer.addInt("rssi", sample->rssi);
+  writer.addUInt("online", gSystem->cloud.state);
+  writer.endObject();
 
-  for (JsonArray::iterator it = _channel.begin(); it != _channel.end(); ++it)
+  writer.beginArray("channel");
+  for (uint8_t i = 0u; i < channelCount; i++)
   {
-    JsonObject &_currentChannel = it->asObject();
+    float value = (CLOUD_SAMPLE_INACTIVE == sample->temperatures[i]) ? INACTIVEVALUE : (sample->temperatures[i] / 10.0f);
 
-    _currentChannel["unit"] = String((char)gSystem->temperatures.getUnit());
-    
-    if(INACTIVEVALUE == _currentChannel["temp"])
+    if (delta)
+    {
+      writer.beginObject();
+      writer.addUInt("number", i + 1u);
+      writer.addFloat("temp", value);
+      writer.addBool("connected", (sample->connected >> i) & 1u);
+      writer.endObject();
+    }
+    else
     {
-      _currentChannel["temp"] = (char*)0;
+      channelValueObj(writer, i, false, value, (sample->connected >> i) & 1u);
     }
   }
-}
+  writer.endArray();
 
+  writer.beginArray("pitmaster");
+  for (uint8_t i = 0u; i < pitmasterCount; i++)
+  {
+    CloudSamplePitmaster *pm = &sample->pitmasters[i];
+
+    if (delta)
+    {
+      writer.beginObject();
+      writer.addUInt("id", i);
+      writer.addUInt("value", pm->value);
+      writer.addFloat("set", pm->set / 10.0f);
+      writer.addString("typ", (pm_auto == pm->type) ? "auto" : ((pm_manual == pm->type) ? "manual" : "off"));
+      writer.endObject();
+    }
+    else
+    {
+      pitValueObj(writer, i, pm->value, pm->set / 10.0f, pm->type);
+    }
+  }
+  writer.endArray();
+}
 
 // ++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
-// Hauptprogramm API - JSON Generator
-String API::apiData(int typ)
+// CLOUD JSON document with several samples, without print only the length is calculated.
+// With a settings hash the server keeps the last full snapshot and a delta
+// document only carries the values, device info and channel settings are left out.
+size_t API::cloudBatchWrite(Print *print, CloudSample *samples, uint16_t count, uint32_t settingsHash, boolean delta)
 {
+  JsonWriter writer(print);
+  CloudConfig cloudConfig = gSystem->cloud.getConfig();
+  char buffer[9];
 
-  DynamicJsonBuffer jsonBuffer;
-  JsonObject &root = jsonBuffer.createObject();
-
-  if ((APIDATA == typ) || (APICUSTOM == typ))
-  { //  || typ == APISETTINGS
-    // interne Kommunikation mit dem Webinterface
-    // oder custom cloud
-  }
+  writer.beginObject();
+  writer.beginObject("device");
+  if (delta)
+    writer.addString("serial", gSystem->getSerialNumber());
   else
+    deviceObj(writer);
+  writer.endObject();
+
+  writer.beginObject("cloud");
+  writer.addString("task", "save");
+  writer.addString("api_token", cloudConfig.cloudToken);
+
+  if (settingsHash != 0u)
   {
-    JsonObject &device = root.createNestedObject("device");
-    deviceObj(device);
+    snprintf(buffer, sizeof(buffer), "%08x", (unsigned int)settingsHash);
+    writer.addString("settings", buffer);
+    writer.addBool("delta", delta);
   }
 
-  switch (typ)
+  writer.beginArray("data");
+  for (uint16_t i = 0u; i < count; i++)
   {
+    writer.beginObject();
+    cloudSampleObj(writer, &samples[i], delta);
+    writer.endObject();
+  }
+  writer.endArray();
+  writer.endObject();
+  writer.endObject();
+
+  return writer.getLength();
+}
+
+// ++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+// Hash of everything a cloud delta leaves out, the values are rendered as constants
+uint32_t API::cloudSettingsHash()
+{
+  ApiHashPrint hashPrint;
+  JsonWriter writer(&hashPrint);
+  char unit[2] = {(char)gSystem->temperatures.getUnit(), '\0'};
+
+  writer.beginObject();
+  deviceObj(writer);
+  writer.addString("unit", unit);
+
+  writer.beginArray("channel");
+  for (uint8_t i = 0u; i < gSystem->temperatures.count(); i++)
+    channelValueObj(writer, i, false, INACTIVEVALUE, false);
+  writer.endArray();
+
+  writer.beginArray("pitmaster");
+  for (uint8_t i = 0u; i < gSystem->pitmasters.count(); i++)
+    pitValueObj(writer, i, 0u, 0.0f, pm_off);
+  writer.endArray();
+  writer.endObject();
+
+  // 0 stands for no hash
+  return max(hashPrint.getHash(), (uint32_t)1u);
+}
+
+// ++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+// CUSTOM JSON Object - Level 1
+void API::customObj(ApiWriter &writer)
+{
+  CloudConfig cloudConfig = gSystem->cloud.getConfig();
 
-  case NOAPI:
+  writer.addUInt("version", 1u);
+  writer.addUInt("interval", cloudConfig.customInterval);
+
+  // CHANNEL
+  writer.beginArray("channel");
+  channelAry(writer, true);
+  writer.endArray();
+}
+
+// ++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+// Hauptprogramm API - JSON Generator
+// Writes one part of the document, returns false after the last part
+boolean API::apiPart(ApiWriter &writer, int typ, uint16_t part, const ApiCounts &counts)
+{
+  if (NOAPI == typ)
+    return false;
+
+  if (0u == part)
   {
-    return "";
+    writer.beginObject();
+
+    if ((APIDATA == typ) || (APICUSTOM == typ))
+    { //  || typ == APISETTINGS
+      // interne Kommunikation mit dem Webinterface
+      // oder custom cloud
+    }
+    else
+    {
+      writer.beginObject("device");
+      deviceObj(writer);
+      writer.endObject();
+    }
+
+    return true;
   }
+  part--;
 
-  case APIUPDATE:
+  boolean pending = false;
+
+  switch (typ)
   {
-    JsonObject &update = root.createNestedObject("update");
-    updateObj(update);
 
-    JsonObject &url = root.createNestedObject("url");
-    urlObj(url);
+  case APIUPDATE:
+  {
+    if (0u == part)
+    {
+      writer.beginObject("update");
+      updateObj(writer);
+      writer.endObject();
+
+      writer.beginObject("url");
+      urlObj(writer);
+      writer.endObject();
+      pending = true;
+    }
     break;
   }
 
   case APICLOUD:
   {
-    JsonObject &cloud = root.createNestedObject("cloud");
-    cloudObj(cloud);
+    if (0u == part)
+    {
+      writer.beginObject("cloud");
+      cloudObj(writer);
+      writer.endObject();
+      pending = true;
+    }
     break;
   }
 
   case APICUSTOM:
   {
-    customObj(root);
+    if (0u == part)
+    {
+      customObj(writer);
+      pending = true;
+    }
     break;
   }
 
   case APIDATA:
   {
-    dataObj(root, false);
+    pending = dataPart(writer, part, false, counts);
     break;
   }
 
   case APISETTINGS:
   {
-    settingsObj(root);
+    pending = settingsPart(writer, part, counts);
     break;
   }
 
   case APINOTIFICATION:
   {
-    JsonObject &note = root.createNestedObject("notification_v2");
-    notificationObj(note);
+    if (0u == part)
+    {
+      writer.beginObject("notification_v2");
+      notificationObj(writer);
+      writer.endObject();
+      pending = true;
+    }
     break;
   }
 
   case APICRASHREPORT:
   {
-    JsonObject &crash = root.createNestedObject("crash_report");
-    crashObj(crash);
+    if (0u == part)
+    {
+      writer.beginObject("crash_report");
+      crashObj(writer);
+      writer.endObject();
+      pending = true;
+    }
     break;
   }
   }
 
+  if (!pending)
+    writer.endObject();
+
+  return pending;
+}
+
+// ++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+// Writes the complete document, without print only the length is calculated
+size_t API::apiWrite(Print *print, int typ, ApiFormat format)
+{
+  JsonWriter jsonWriter(print);
+  CborWriter cborWriter(print);
+  ApiWriter &writer = (ApiFormat::Cbor == format) ? (ApiWriter &)cborWriter : (ApiWriter &)jsonWriter;
+  ApiCounts counts = getCounts();
+  uint16_t part = 0u;
+
+  while (apiPart(writer, typ, part++, counts))
+    ;
+
+  return writer.getLength();
+}
+
+// ++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+// Document as String, reserved in one piece to avoid fragmentation
+String API::apiData(int typ)
+{
   String jsonStr;
-  root.printTo(jsonStr);
+  JsonStringPrint print(&jsonStr);
+
+  // a few bytes more, values can change between both runs
+  jsonStr.reserve(apiWrite(NULL, typ) + 16u);
+  apiWrite(&print, typ);
 
   return jsonStr;
 }
@@ -587,4 +958,114 @@ float API::limit_float(float f, int i)
     f = f / 100;
   }
   return f;
-}
\ No newline at end of file
+}
+// ++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+// Compare the String based document with the chunked stream and JSON with CBOR
+void API::benchmark(Print *print)
+{
+  const int typs[] = {APIDATA, APISETTINGS};
+  const char *names[] = {"data", "settings"};
+  uint8_t chunk[128];
+
+  for (uint8_t i = 0u; i < sizeof(typs) / sizeof(typs[0]); i++)
+  {
+    uint32_t stringHeap, stringTime;
+    size_t stringLength;
+
+    {
+      uint32_t heapBefore = ESP.getFreeHeap();
+      uint32_t start = micros();
+      String jsonStr = apiData(typs[i]);
+      stringTime = micros() - start;
+      stringHeap = heapBefore - ESP.getFreeHeap();
+      stringLength = jsonStr.length();
+    }
+
+    uint32_t streamHeap = 0u;
+    size_t streamLength = 0u;
+    size_t length;
+    uint32_t heapBefore = ESP.getFreeHeap();
+    uint32_t start = micros();
+    ApiStream *stream = new ApiStream(typs[i]);
+
+    while ((length = stream->read(chunk, sizeof(chunk))) > 0u)
+    {
+      streamLength += length;
+      streamHeap = max(streamHeap, heapBefore - ESP.getFreeHeap());
+    }
+
+    uint32_t streamTime = micros() - start;
+    delete stream;
+
+    print->printf("%-8s string: %u bytes, %u bytes heap, %u us | stream: %u bytes, %u bytes heap, %u us\n",
+                  names[i], stringLength, stringHeap, stringTime, streamLength, streamHeap, streamTime);
+
+    start = micros();
+    size_t jsonLength = apiWrite(NULL, typs[i], ApiFormat::Json);
+    uint32_t jsonTime = micros() - start;
+    start = micros();
+    size_t cborLength = apiWrite(NULL, typs[i], ApiFormat::Cbor);
+    uint32_t cborTime = micros() - start;
+
+    print->printf("%-8s json: %u bytes, %u us | cbor: %u bytes, %u us\n",
+                  names[i], jsonLength, jsonTime, cborLength, cborTime);
+  }
+}
+
+ApiStream::ApiStream(int typ, ApiFormat format)
+{
+  if (ApiFormat::Cbor == format)
+    this->writer = new CborWriter(&this->pending);
+  else
+    this->writer = new JsonWriter(&this->pending);
+
+  this->typ = typ;
+  this->counts = API::getCounts();
+  this->part = 0u;
+  this->done = false;
+  this->pending.reserve(API_STREAM_PART_SIZE);
+  this->pendingIndex = 0u;
+}
+
+ApiStream::~ApiStream()
+{
+  delete this->writer;
+}
+
+size_t ApiStream::read(uint8_t *buffer, size_t maxLen)
+{
+  size_t length = 0u;
+
+  // a part without all of its bytes must never be sent
+  if (this->pending.hasFailed())
+    return 0u;
+
+  while (length < maxLen)
+  {
+    if (this->pendingIndex >= this->pending.getSize())
+    {
+      if (this->done)
+        break;
+
+      // keeps the reserved buffer
+      this->pending.clear();
+      this->pendingIndex = 0u;
+      this->done = !API::apiPart(*this->writer, this->typ, this->part++, this->counts);
+
+      if (this->pending.hasFailed())
+      {
+        Log.error("API stream: no memory for part %d" CR, this->part - 1u);
+        return 0u;
+      }
+
+      continue;
+    }
+
+    size_t copyLength = min(this->pending.getSize() - this->pendingIndex, maxLen - length);
+    memcpy(&buffer[length], this->pending.getData() + this->pendingIndex, copyLength);
+    this->pendingIndex += copyLength;
+    length += copyLength;
+  }
+
+  return length;
+}
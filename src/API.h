@@ -21,33 +21,78 @@
 #pragma once
 
 #include <Arduino.h>
-#include <ArduinoJson.h>
+#include "ApiWriter.h"
+#include "CloudBuffer.h"
+
+// reserved size for one part of a chunked document
+#define API_STREAM_PART_SIZE 512u
+
+// element counts of a chunked document, read once when it starts so devices
+// that appear or disappear meanwhile can't shift the parts
+typedef struct
+{
+  uint8_t channels;
+  uint8_t pitmasters;
+  uint8_t profiles;
+} ApiCounts;
 
 class API
 {
 public:
   API();
-  static void displayObj(JsonObject &jObj);
-  static void deviceObj(JsonObject &jObj);
-  static void systemObj(JsonObject &jObj, bool settings = false);
-  static void channelAry(JsonArray &jAry, int cc);
-  static void pitTyp(JsonObject &jObj);
-  static void pitAry(JsonArray &jAry, int cc);
-  static void pidAry(JsonArray &jAry, int cc);
-  static void iotObj(JsonObject &jObj);
-  static void extObj(JsonObject &jObj);
-  static void updateObj(JsonObject &jObj);
-  static void alexaObj(JsonObject &jObj);
-  static void urlObj(JsonObject &jObj);
-  static void dataObj(JsonObject &jObj, bool cloud);
-  static void settingsObj(JsonObject &jObj);
-  static void cloudObj(JsonObject &jObj);
-  static void customObj(JsonObject &jObj);
-  static void notificationObj(JsonObject &jObj);
-  static void crashObj(JsonObject &jObj);
+  static void displayObj(ApiWriter &writer);
+  static void deviceObj(ApiWriter &writer);
+  static void systemObj(ApiWriter &writer, bool settings = false);
+  static void channelObj(ApiWriter &writer, uint8_t index, bool custom = false);
+  static void channelValueObj(ApiWriter &writer, uint8_t index, bool custom, float value, boolean connected);
+  static void channelAry(ApiWriter &writer, bool custom = false);
+  static void pitTyp(ApiWriter &writer);
+  static void pitObj(ApiWriter &writer, uint8_t index);
+  static void pitValueObj(ApiWriter &writer, uint8_t index, uint8_t value, float set, uint8_t type);
+  static void pitAry(ApiWriter &writer);
+  static void pidObj(ApiWriter &writer, uint8_t index);
+  static void pidAry(ApiWriter &writer);
+  static void iotObj(ApiWriter &writer);
+  static void updateObj(ApiWriter &writer);
+  static void urlObj(ApiWriter &writer);
+  static ApiCounts getCounts();
+  static boolean dataPart(ApiWriter &writer, uint16_t part, bool cloud, const ApiCounts &counts);
+  static void dataObj(ApiWriter &writer, bool cloud);
+  static boolean settingsPart(ApiWriter &writer, uint16_t part, const ApiCounts &counts);
+  static void settingsObj(ApiWriter &writer);
+  static void cloudObj(ApiWriter &writer);
+  static void cloudSampleObj(ApiWriter &writer, CloudSample *sample, boolean delta = false);
+  static size_t cloudBatchWrite(Print *print, CloudSample *samples, uint16_t count, uint32_t settingsHash = 0u, boolean delta = false);
+  static uint32_t cloudSettingsHash();
+  static void customObj(ApiWriter &writer);
+  static void notificationObj(ApiWriter &writer);
+  static void crashObj(ApiWriter &writer);
+  static boolean apiPart(ApiWriter &writer, int typ, uint16_t part, const ApiCounts &counts);
+  static size_t apiWrite(Print *print, int typ, ApiFormat format = ApiFormat::Json);
   static String apiData(int typ);
   static float limit_float(float f, int i);
+  static void benchmark(Print *print);
 
 private:
 
 };
+
+// JSON/CBOR generator for chunked responses, the document is produced part by part
+// so only the biggest part (one channel, one pid profile, ...) is held in RAM
+class ApiStream
+{
+public:
+  ApiStream(int typ, ApiFormat format = ApiFormat::Json);
+  ~ApiStream();
+  size_t read(uint8_t *buffer, size_t maxLen);
+  boolean hasFailed() { return this->pending.hasFailed(); };
+
+private:
+  ApiWriter *writer;
+  int typ;
+  ApiCounts counts;
+  uint16_t part;
+  boolean done;
+  ApiBufferPrint pending;
+  size_t pendingIndex;
+};
@@ -0,0 +1,250 @@
+/*************************************************** 
+    Copyright (C) 2020  Martin Koerner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    
+    HISTORY: Please refer Github History
+    
+****************************************************/
+#include "ApiCache.h"
+#include "API.h"
+#include "system/SystemBase.h"
+#include "JsonWriter.h"
+#include "CborWriter.h"
+
+std::atomic<uint32_t> ApiCache::version(0u);
+ApiCache *ApiCache::first = NULL;
+
+ApiCache::ApiCache(int typ, ApiFormat format, const char *name)
+{
+  this->typ = typ;
+  this->format = format;
+  this->name = name;
+  this->bodyVersion = 0u;
+  this->bodyTime = 0u;
+  this->renderCount = 0u;
+  memset(&this->stats, 0, sizeof(this->stats));
+  this->next = first;
+  first = this;
+}
+
+void ApiCache::init()
+{
+  gSystem->temperatures.registerCallback(ApiCache::temperatureCb, NULL);
+
+  for (uint8_t i = 0; i < gSystem->pitmasters.count(); i++)
+  {
+    Pitmaster *pitmaster = gSystem->pitmasters[i];
+    if (pitmaster != NULL)
+    {
+      pitmaster->registerCallback(ApiCache::pitmasterCb, NULL);
+    }
+  }
+
+  Settings::onWrite(ApiCache::settingsCb);
+}
+
+void ApiCache::temperatureCb(uint8_t index, TemperatureBase *temperature, boolean settingsChanged, void *userData)
+{
+  invalidate();
+}
+
+void ApiCache::pitmasterCb(Pitmaster *pitmaster, boolean settingsChanged, void *userData)
+{
+  invalidate();
+}
+
+void ApiCache::settingsCb(SettingsNvsKeys key)
+{
+  invalidate();
+}
+
+boolean ApiCache::acceptsCbor(AsyncWebServerRequest *request)
+{
+  return request->hasHeader("Accept") && (request->header("Accept").indexOf(API_CACHE_CONTENT_TYPE_CBOR) >= 0);
+}
+
+const char *ApiCache::getContentType()
+{
+  return (ApiFormat::Cbor == this->format) ? API_CACHE_CONTENT_TYPE_CBOR : API_CACHE_CONTENT_TYPE_JSON;
+}
+
+// only called from the web server task, no locking needed
+void ApiCache::handleRequest(AsyncWebServerRequest *request)
+{
+  uint32_t currentVersion = version;
+
+  if ((!this->body) || (this->bodyVersion != currentVersion) || ((millis() - this->bodyTime) >= API_CACHE_MAX_AGE))
+  {
+    render(currentVersion);
+  }
+  else
+  {
+    this->stats.hits++;
+  }
+
+  // not enough heap for the cached document, stream it instead
+  if (!this->body)
+  {
+    std::shared_ptr<ApiStream> stream(new ApiStream(this->typ, this->format));
+
+    request->send(request->beginChunkedResponse(getContentType(), [stream, request](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+      size_t length = stream->read(buffer, maxLen);
+
+      // close without the last chunk, so the client sees an incomplete response
+      if (stream->hasFailed())
+        request->client()->close();
+
+      return length;
+    }));
+    return;
+  }
+
+  AsyncWebServerResponse *response;
+
+  if (request->hasHeader("If-None-Match") && (request->header("If-None-Match") == this->etag))
+  {
+    this->stats.notModified++;
+    response = request->beginResponse(304);
+  }
+  else
+  {
+    std::shared_ptr<ApiCacheBody> body = this->body;
+
+    response = request->beginResponse(getContentType(), body->getSize(), [body](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+      return body->read(buffer, maxLen, index);
+    });
+  }
+
+  response->addHeader("ETag", this->etag);
+  response->addHeader("Cache-Control", "no-cache");
+  response->addHeader("Vary", "Accept");
+  request->send(response);
+}
+
+void ApiCache::render(uint32_t currentVersion)
+{
+  uint32_t start = micros();
+  std::shared_ptr<ApiCacheBody> newBody(new ApiCacheBody());
+  boolean success = newBody->render(this->typ, this->format);
+
+  uint32_t time = micros() - start;
+
+  this->stats.misses++;
+  this->stats.renderTimeLast = time;
+  this->stats.renderTimeMax = max(this->stats.renderTimeMax, time);
+  this->stats.renderTimeTotal += time;
+
+  // responses still in progress keep their own reference
+  this->body.reset();
+
+  // without heap the document is streamed uncached
+  if (success)
+  {
+    this->body = newBody;
+    this->bodyVersion = currentVersion;
+    this->bodyTime = millis();
+    this->etag = "\"" + String(this->typ) + "-" + String((uint8_t)this->format) + "-" + String(currentVersion, HEX) + "-" + String(++this->renderCount, HEX) + "\"";
+  }
+}
+
+ApiCacheBody::~ApiCacheBody()
+{
+  for (size_t i = 0u; i < this->parts.size(); i++)
+    delete this->parts[i];
+}
+
+boolean ApiCacheBody::render(int typ, ApiFormat format)
+{
+  JsonWriter jsonWriter(NULL);
+  CborWriter cborWriter(NULL);
+  ApiWriter &writer = (ApiFormat::Cbor == format) ? (ApiWriter &)cborWriter : (ApiWriter &)jsonWriter;
+  ApiCounts counts = API::getCounts();
+  boolean pending = true;
+
+  for (uint16_t index = 0u; pending; index++)
+  {
+    ApiBufferPrint *part = new ApiBufferPrint();
+
+    if ((NULL == part) || !part->reserve(API_STREAM_PART_SIZE))
+    {
+      delete part;
+      return false;
+    }
+
+    this->parts.push_back(part);
+    writer.setPrint(part);
+    pending = API::apiPart(writer, typ, index, counts);
+
+    if (part->hasFailed())
+      return false;
+
+    part->shrink();
+    this->size += part->getSize();
+  }
+
+  // every byte the writer produced has to be in the parts
+  return (writer.getLength() == this->size);
+}
+
+size_t ApiCacheBody::read(uint8_t *buffer, size_t maxLen, size_t index)
+{
+  size_t length = 0u;
+  size_t offset = 0u;
+
+  for (size_t i = 0u; (i < this->parts.size()) && (length < maxLen); i++)
+  {
+    ApiBufferPrint *part = this->parts[i];
+    size_t partSize = part->getSize();
+
+    if ((index + length) < (offset + partSize))
+    {
+      size_t partOffset = (index + length) - offset;
+      size_t copyLength = min(partSize - partOffset, maxLen - length);
+      memcpy(&buffer[length], part->getData() + partOffset, copyLength);
+      length += copyLength;
+    }
+
+    offset += partSize;
+  }
+
+  return length;
+}
+
+void ApiCache::printMetrics(MetricsWriter &writer)
+{
+  writer.family("wlanthermo_api_cache_hits_total", "counter", "API documents served from cache");
+  for (ApiCache *cache = first; cache != NULL; cache = cache->next)
+    writer.sample("wlanthermo_api_cache_hits_total").label("document", cache->name).value(cache->stats.hits);
+
+  writer.family("wlanthermo_api_cache_misses_total", "counter", "API documents rendered");
+  for (ApiCache *cache = first; cache != NULL; cache = cache->next)
+    writer.sample("wlanthermo_api_cache_misses_total").label("document", cache->name).value(cache->stats.misses);
+
+  writer.family("wlanthermo_api_cache_not_modified_total", "counter", "API requests answered with 304");
+  for (ApiCache *cache = first; cache != NULL; cache = cache->next)
+    writer.sample("wlanthermo_api_cache_not_modified_total").label("document", cache->name).value(cache->stats.notModified);
+
+  writer.family("wlanthermo_api_render_microseconds", "gauge", "API document render time");
+  for (ApiCache *cache = first; cache != NULL; cache = cache->next)
+  {
+    uint32_t average = (cache->stats.misses > 0u) ? (uint32_t)(cache->stats.renderTimeTotal / cache->stats.misses) : 0u;
+    writer.sample("wlanthermo_api_render_microseconds").label("document", cache->name).label("stat", "last").value(cache->stats.renderTimeLast);
+    writer.sample("wlanthermo_api_render_microseconds").label("document", cache->name).label("stat", "avg").value(average);
+    writer.sample("wlanthermo_api_render_microseconds").label("document", cache->name).label("stat", "max").value(cache->stats.renderTimeMax);
+  }
+
+  writer.family("wlanthermo_api_state_version", "counter", "Changes of channels, pitmasters and settings");
+  writer.sample("wlanthermo_api_state_version").value(getVersion());
+}
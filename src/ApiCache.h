@@ -0,0 +1,95 @@
+/*************************************************** 
+    Copyright (C) 2020  Martin Koerner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    
+    HISTORY: Please refer Github History
+    
+****************************************************/
+#pragma once
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include "Settings.h"
+#include "ApiWriter.h"
+#include "Metrics.h"
+
+// cached documents contain system values (time, rssi, ...) without change callback
+#define API_CACHE_MAX_AGE 10000u
+
+#define API_CACHE_CONTENT_TYPE_JSON "application/json"
+#define API_CACHE_CONTENT_TYPE_CBOR "application/cbor"
+
+typedef struct
+{
+  uint32_t hits;
+  uint32_t misses;
+  uint32_t notModified;
+  uint32_t renderTimeLast;
+  uint32_t renderTimeMax;
+  uint64_t renderTimeTotal;
+} ApiCacheStats;
+
+// Rendered document, kept in the parts of API::apiPart so no big contiguous heap block is needed
+class ApiCacheBody
+{
+public:
+  ApiCacheBody() { this->size = 0u; };
+  ~ApiCacheBody();
+  boolean render(int typ, ApiFormat format);
+  size_t getSize() { return this->size; };
+  size_t read(uint8_t *buffer, size_t maxLen, size_t index);
+
+private:
+  std::vector<ApiBufferPrint *> parts;
+  size_t size;
+};
+
+// Keeps the last rendered API document until the state version changes.
+// The version is bumped by the temperature, pitmaster and settings callbacks.
+class ApiCache
+{
+public:
+  ApiCache(int typ, ApiFormat format, const char *name);
+  void handleRequest(AsyncWebServerRequest *request);
+  ApiCacheStats getStats() { return this->stats; };
+  static void init();
+  static boolean acceptsCbor(AsyncWebServerRequest *request);
+  static void invalidate() { version++; };
+  static uint32_t getVersion() { return version; };
+  static void printMetrics(MetricsWriter &writer);
+
+private:
+  void render(uint32_t currentVersion);
+  static void temperatureCb(uint8_t index, class TemperatureBase *temperature, boolean settingsChanged, void *userData);
+  static void pitmasterCb(class Pitmaster *pitmaster, boolean settingsChanged, void *userData);
+  static void settingsCb(SettingsNvsKeys key);
+  const char *getContentType();
+  int typ;
+  ApiFormat format;
+  const char *name;
+  std::shared_ptr<ApiCacheBody> body;
+  String etag;
+  uint32_t bodyVersion;
+  uint32_t bodyTime;
+  uint32_t renderCount;
+  ApiCacheStats stats;
+  ApiCache *next;
+  static std::atomic<uint32_t> version;
+  // caches are static objects in other files, a plain pointer is initialized before them
+  static ApiCache *first;
+};
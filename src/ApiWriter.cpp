@@ -0,0 +1,79 @@
+/*************************************************** 
+    Copyright (C) 2020  Martin Koerner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    
+    HISTORY: Please refer Github History
+    
+****************************************************/
+#include "ApiWriter.h"
+
+boolean ApiBufferPrint::reserve(size_t capacity)
+{
+  if (capacity <= this->capacity)
+    return true;
+
+  uint8_t *newBuffer = (uint8_t *)realloc(this->buffer, capacity);
+
+  if (NULL == newBuffer)
+  {
+    this->failed = true;
+    return false;
+  }
+
+  this->buffer = newBuffer;
+  this->capacity = capacity;
+  return true;
+}
+
+// gives the unused part of the buffer back to the heap
+void ApiBufferPrint::shrink()
+{
+  if ((NULL == this->buffer) || (this->size >= this->capacity))
+    return;
+
+  uint8_t *newBuffer = (uint8_t *)realloc(this->buffer, max(this->size, (size_t)1u));
+
+  if (newBuffer != NULL)
+  {
+    this->buffer = newBuffer;
+    this->capacity = max(this->size, (size_t)1u);
+  }
+}
+
+size_t ApiBufferPrint::write(const uint8_t *data, size_t size)
+{
+  if ((this->size + size) > this->capacity)
+  {
+    // values can change between length calculation and writing
+    if (!reserve(this->size + size + 32u))
+      return 0u;
+  }
+
+  memcpy(&this->buffer[this->size], data, size);
+  this->size += size;
+
+  return size;
+}
+
+size_t ApiHashPrint::write(const uint8_t *data, size_t size)
+{
+  for (size_t i = 0u; i < size; i++)
+  {
+    this->hash ^= data[i];
+    this->hash *= 16777619u;
+  }
+
+  return size;
+}
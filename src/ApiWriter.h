@@ -0,0 +1,97 @@
+/*************************************************** 
+    Copyright (C) 2020  Martin Koerner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    
+    HISTORY: Please refer Github History
+    
+****************************************************/
+#pragma once
+
+#include <Arduino.h>
+
+enum class ApiFormat
+{
+  Json,
+  Cbor
+};
+
+// Common interface of the API document generators, the object builders in
+// API are written against it and produce JSON or CBOR with the same code.
+class ApiWriter
+{
+public:
+  ApiWriter(Print *print) { this->print = print; this->length = 0u; };
+  virtual ~ApiWriter(){};
+  void setPrint(Print *print) { this->print = print; };
+  virtual void beginObject(const char *key = NULL) = 0;
+  virtual void endObject() = 0;
+  virtual void beginArray(const char *key = NULL) = 0;
+  virtual void endArray() = 0;
+  virtual void addString(const char *key, const char *value) = 0;
+  void addString(const char *key, const String &value) { addString(key, value.c_str()); };
+  virtual void addInt(const char *key, int32_t value) = 0;
+  virtual void addUInt(const char *key, uint32_t value) = 0;
+  virtual void addBool(const char *key, boolean value) = 0;
+  virtual void addFloat(const char *key, float value, uint8_t digits = 2u) = 0;
+  virtual void addNull(const char *key) = 0;
+  // without a Print target only the length is counted
+  size_t getLength() { return this->length; };
+
+protected:
+  void writeBytes(const uint8_t *buffer, size_t size)
+  {
+    if (this->print != NULL)
+      this->print->write(buffer, size);
+
+    this->length += size;
+  };
+  Print *print;
+  size_t length;
+};
+
+// Collects a document in one heap buffer, also binary formats
+class ApiBufferPrint : public Print
+{
+public:
+  ApiBufferPrint() { this->buffer = NULL; this->size = 0u; this->capacity = 0u; this->failed = false; };
+  ~ApiBufferPrint() { free(this->buffer); };
+  boolean reserve(size_t capacity);
+  void shrink();
+  void clear() { this->size = 0u; this->failed = false; };
+  size_t write(uint8_t c) { return write(&c, 1u); };
+  size_t write(const uint8_t *data, size_t size);
+  const uint8_t *getData() { return this->buffer; };
+  size_t getSize() { return this->size; };
+  boolean hasFailed() { return this->failed; };
+
+private:
+  uint8_t *buffer;
+  size_t size;
+  size_t capacity;
+  boolean failed;
+};
+
+// FNV-1a hash of a document, detects changes without keeping a copy
+class ApiHashPrint : public Print
+{
+public:
+  ApiHashPrint() { this->hash = 2166136261u; };
+  size_t write(uint8_t c) { return write(&c, 1u); };
+  size_t write(const uint8_t *data, size_t size);
+  uint32_t getHash() { return this->hash; };
+
+private:
+  uint32_t hash;
+};
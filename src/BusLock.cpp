@@ -0,0 +1,120 @@
+/*************************************************** 
+    Copyright (C) 2020  Martin Koerner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    
+    HISTORY: Please refer Github History
+    
+****************************************************/
+#include "BusLock.h"
+#include <esp_timer.h>
+
+BusLock *BusLock::first = NULL;
+
+BusLock::BusLock(const char *name)
+{
+  this->name = name;
+  this->mutex = xSemaphoreCreateMutex();
+  this->pmHandle = NULL;
+  esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, name, &this->pmHandle);
+  this->lockTimestamp = 0u;
+  this->resetStats();
+  this->next = first;
+  first = this;
+}
+
+void BusLock::lock()
+{
+  esp_pm_lock_acquire(this->pmHandle);
+
+  uint32_t waitStart = esp_timer_get_time();
+
+  if (xSemaphoreTake(this->mutex, 0u) != pdTRUE)
+  {
+    xSemaphoreTake(this->mutex, portMAX_DELAY);
+    this->stats.contended++;
+  }
+
+  // the lock owner is the only writer of the statistics
+  this->lockTimestamp = esp_timer_get_time();
+  uint32_t waitTime = this->lockTimestamp - waitStart;
+  this->stats.waitMax = max(this->stats.waitMax, waitTime);
+  this->stats.waitTotal += waitTime;
+}
+
+void BusLock::release()
+{
+  uint32_t holdTime = (uint32_t)esp_timer_get_time() - this->lockTimestamp;
+  this->stats.last = holdTime;
+  this->stats.max = max(this->stats.max, holdTime);
+  this->stats.total += holdTime;
+  this->stats.count++;
+
+  xSemaphoreGive(this->mutex);
+  esp_pm_lock_release(this->pmHandle);
+}
+
+void BusLock::resetStats()
+{
+  memset(&this->stats, 0, sizeof(this->stats));
+}
+
+void BusLock::print(Print *print)
+{
+  for (BusLock *bus = first; bus != NULL; bus = bus->next)
+  {
+    BusLockStats stats = bus->stats;
+    print->printf("%s lock hold time: last %uus, max %uus, avg %uus (%u locks), wait: max %uus, avg %uus (%u contended)\n",
+                  bus->name, stats.last, stats.max, (stats.count > 0u) ? (uint32_t)(stats.total / stats.count) : 0u, stats.count,
+                  stats.waitMax, (stats.count > 0u) ? (uint32_t)(stats.waitTotal / stats.count) : 0u, stats.contended);
+  }
+}
+
+void BusLock::printMetrics(MetricsWriter &writer)
+{
+  writer.family("wlanthermo_bus_locks_total", "counter", "Bus locks taken");
+  for (BusLock *bus = first; bus != NULL; bus = bus->next)
+    writer.sample("wlanthermo_bus_locks_total").label("bus", bus->name).value(bus->stats.count);
+
+  writer.family("wlanthermo_bus_lock_contended_total", "counter", "Bus locks that had to wait for another task");
+  for (BusLock *bus = first; bus != NULL; bus = bus->next)
+    writer.sample("wlanthermo_bus_lock_contended_total").label("bus", bus->name).value(bus->stats.contended);
+
+  writer.family("wlanthermo_bus_lock_hold_microseconds", "gauge", "Bus lock hold time");
+  for (BusLock *bus = first; bus != NULL; bus = bus->next)
+  {
+    BusLockStats stats = bus->stats;
+    writer.sample("wlanthermo_bus_lock_hold_microseconds").label("bus", bus->name).label("stat", "last").value(stats.last);
+    writer.sample("wlanthermo_bus_lock_hold_microseconds").label("bus", bus->name).label("stat", "avg").value((stats.count > 0u) ? (uint32_t)(stats.total / stats.count) : 0u);
+    writer.sample("wlanthermo_bus_lock_hold_microseconds").label("bus", bus->name).label("stat", "max").value(stats.max);
+  }
+
+  writer.family("wlanthermo_bus_lock_wait_microseconds", "gauge", "Time waiting for a bus lock");
+  for (BusLock *bus = first; bus != NULL; bus = bus->next)
+  {
+    BusLockStats stats = bus->stats;
+    writer.sample("wlanthermo_bus_lock_wait_microseconds").label("bus", bus->name).label("stat", "avg").value((stats.count > 0u) ? (uint32_t)(stats.waitTotal / stats.count) : 0u);
+    writer.sample("wlanthermo_bus_lock_wait_microseconds").label("bus", bus->name).label("stat", "max").value(stats.waitMax);
+  }
+}
+
+void BusLock::resetAll()
+{
+  for (BusLock *bus = first; bus != NULL; bus = bus->next)
+    bus->resetStats();
+}
+
+BusLock gI2cBus("i2c0");
+BusLock gSpiBus("spi");
+BusLock gBleUartBus("ble_uart");
@@ -0,0 +1,64 @@
+/*************************************************** 
+    Copyright (C) 2020  Martin Koerner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    
+    HISTORY: Please refer Github History
+    
+****************************************************/
+#pragma once
+
+#include <Arduino.h>
+#include <esp_pm.h>
+#include "Metrics.h"
+
+typedef struct
+{
+  uint32_t last;      // us
+  uint32_t max;       // us
+  uint64_t total;     // us
+  uint32_t count;
+  uint32_t waitMax;   // us
+  uint64_t waitTotal; // us
+  uint32_t contended;
+} BusLockStats;
+
+// Lock for one physical bus. Also keeps the CPU out of light sleep while
+// the bus is used and records hold and wait times.
+class BusLock
+{
+public:
+  BusLock(const char *name);
+  void lock();
+  void release();
+  BusLockStats getStats() { return this->stats; };
+  void resetStats();
+  static void print(Print *print);
+  static void printMetrics(MetricsWriter &writer);
+  static void resetAll();
+
+private:
+  const char *name;
+  SemaphoreHandle_t mutex;
+  esp_pm_lock_handle_t pmHandle;
+  uint32_t lockTimestamp;
+  BusLockStats stats;
+  BusLock *next;
+  // locks are static objects, a plain pointer is initialized before them
+  static BusLock *first;
+};
+
+extern BusLock gI2cBus;
+extern BusLock gSpiBus;
+extern BusLock gBleUartBus;
@@ -0,0 +1,173 @@
+/*************************************************** 
+    Copyright (C) 2020  Martin Koerner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    
+    HISTORY: Please refer Github History
+    
+****************************************************/
+#include "CborWriter.h"
+
+#define CBOR_UNSIGNED 0u
+#define CBOR_NEGATIVE 1u
+#define CBOR_TEXT 3u
+#define CBOR_ARRAY 4u
+#define CBOR_MAP 5u
+
+#define CBOR_INDEFINITE 31u
+#define CBOR_FALSE 0xF4u
+#define CBOR_TRUE 0xF5u
+#define CBOR_NULL 0xF6u
+#define CBOR_FLOAT32 0xFAu
+#define CBOR_BREAK 0xFFu
+
+CborWriter::CborWriter(Print *print) : ApiWriter(print)
+{
+}
+
+void CborWriter::beginObject(const char *key)
+{
+  writeKey(key);
+  writeByte((CBOR_MAP << 5) | CBOR_INDEFINITE);
+}
+
+void CborWriter::endObject()
+{
+  writeByte(CBOR_BREAK);
+}
+
+void CborWriter::beginArray(const char *key)
+{
+  writeKey(key);
+  writeByte((CBOR_ARRAY << 5) | CBOR_INDEFINITE);
+}
+
+void CborWriter::endArray()
+{
+  writeByte(CBOR_BREAK);
+}
+
+void CborWriter::addString(const char *key, const char *value)
+{
+  writeKey(key);
+
+  if (NULL == value)
+    writeByte(CBOR_NULL);
+  else
+    writeText(value);
+}
+
+void CborWriter::addInt(const char *key, int32_t value)
+{
+  writeKey(key);
+
+  if (value < 0)
+    writeHead(CBOR_NEGATIVE, (uint32_t)(-(value + 1)));
+  else
+    writeHead(CBOR_UNSIGNED, (uint32_t)value);
+}
+
+void CborWriter::addUInt(const char *key, uint32_t value)
+{
+  writeKey(key);
+  writeHead(CBOR_UNSIGNED, value);
+}
+
+void CborWriter::addBool(const char *key, boolean value)
+{
+  writeKey(key);
+  writeByte(value ? CBOR_TRUE : CBOR_FALSE);
+}
+
+// digits are not needed, the float keeps its precision
+void CborWriter::addFloat(const char *key, float value, uint8_t digits)
+{
+  if (isnan(value) || isinf(value))
+  {
+    addNull(key);
+    return;
+  }
+
+  if ((value >= -2147483648.0f) && (value < 2147483648.0f) && (value == (float)(int32_t)value))
+  {
+    addInt(key, (int32_t)value);
+    return;
+  }
+
+  uint32_t raw;
+  memcpy(&raw, &value, sizeof(raw));
+
+  uint8_t buffer[5] = {CBOR_FLOAT32, (uint8_t)(raw >> 24), (uint8_t)(raw >> 16), (uint8_t)(raw >> 8), (uint8_t)raw};
+
+  writeKey(key);
+  writeBytes(buffer, sizeof(buffer));
+}
+
+void CborWriter::addNull(const char *key)
+{
+  writeKey(key);
+  writeByte(CBOR_NULL);
+}
+
+void CborWriter::writeKey(const char *key)
+{
+  if (key != NULL)
+    writeText(key);
+}
+
+void CborWriter::writeHead(uint8_t majorType, uint32_t value)
+{
+  uint8_t buffer[5];
+  uint8_t size;
+
+  majorType <<= 5;
+
+  if (value < 24u)
+  {
+    buffer[0] = majorType | value;
+    size = 1u;
+  }
+  else if (value <= 0xFFu)
+  {
+    buffer[0] = majorType | 24u;
+    buffer[1] = value;
+    size = 2u;
+  }
+  else if (value <= 0xFFFFu)
+  {
+    buffer[0] = majorType | 25u;
+    buffer[1] = value >> 8;
+    buffer[2] = value;
+    size = 3u;
+  }
+  else
+  {
+    buffer[0] = majorType | 26u;
+    buffer[1] = value >> 24;
+    buffer[2] = value >> 16;
+    buffer[3] = value >> 8;
+    buffer[4] = value;
+    size = 5u;
+  }
+
+  writeBytes(buffer, size);
+}
+
+void CborWriter::writeText(const char *str)
+{
+  size_t strLength = strlen(str);
+
+  writeHead(CBOR_TEXT, strLength);
+  writeBytes((const uint8_t *)str, strLength);
+}
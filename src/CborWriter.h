@@ -0,0 +1,49 @@
+/*************************************************** 
+    Copyright (C) 2020  Martin Koerner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    
+    HISTORY: Please refer Github History
+    
+****************************************************/
+#pragma once
+
+#include <Arduino.h>
+#include "ApiWriter.h"
+
+// CBOR (RFC 7049) generator with the same interface as JsonWriter.
+// Maps and arrays use indefinite length, so no element counts are needed
+// in advance. Integral float values are encoded as integers.
+class CborWriter : public ApiWriter
+{
+public:
+  CborWriter(Print *print = NULL);
+  using ApiWriter::addString;
+  void beginObject(const char *key = NULL);
+  void endObject();
+  void beginArray(const char *key = NULL);
+  void endArray();
+  void addString(const char *key, const char *value);
+  void addInt(const char *key, int32_t value);
+  void addUInt(const char *key, uint32_t value);
+  void addBool(const char *key, boolean value);
+  void addFloat(const char *key, float value, uint8_t digits = 2u);
+  void addNull(const char *key);
+
+private:
+  void writeKey(const char *key);
+  void writeHead(uint8_t majorType, uint32_t value);
+  void writeText(const char *str);
+  void writeByte(uint8_t value) { writeBytes(&value, 1u); };
+};
@@ -25,15 +25,17 @@
 #include "API.h"
 #include "WebHandler.h"
 #include "DbgPrint.h"
-#include "ArduinoLog.h"
+#include "EventLog.h"
 #include <SPIFFS.h>
-#include "ArduinoLog.h"
+#include "EventLog.h"
 
 // API
 #define APISERVER "api.wlanthermo.de"
 #define CHECKAPI "/"
 #define URL_FILE "/url.json"
 #define DEFAULT_INTERVAL 30u
+#define DEFAULT_INTERVAL_FLOOR 10u
+#define DEFAULT_INTERVAL_CEILING 300u
 #define TOKEN_BYTE_LENGTH 11u
 #define TOKEN_STRING_LENGTH ((2u * TOKEN_BYTE_LENGTH) + 1u)
 
@@ -47,21 +49,47 @@
 
 #define API_QUEUE_SIZE 5u
 
+// api, note and cloud host plus custom url
+#define CLOUD_CONNECTION_COUNT 4u
+
 enum
 {
   GETMETH,
   POSTMETH
 };
 
+enum
+{
+  BATCH_IDLE,
+  BATCH_SENDING,
+  BATCH_DONE,
+  BATCH_FAILED
+};
+
+// Print target for the request body
+class CloudRequestPrint : public Print
+{
+public:
+  CloudRequestPrint(xbuf *body) { this->body = body; };
+  size_t write(uint8_t c) { return this->body->write(&c, 1u); };
+  size_t write(const uint8_t *buffer, size_t size) { return this->body->write(buffer, size); };
+
+private:
+  xbuf *body;
+};
+
 uint8_t Cloud::serverurlCount = 3u;
 ServerData Cloud::serverurl[3] = {
     {APISERVER, CHECKAPI, "api"},
     {APISERVER, CHECKAPI, "note"},
     {APISERVER, CHECKAPI, "cloud"}};
 
-asyncHTTPrequest Cloud::apiClient = asyncHTTPrequest();
+CloudConnection Cloud::connections[CLOUD_CONNECTION_COUNT];
 QueueHandle_t Cloud::apiQueue = xQueueCreate(API_QUEUE_SIZE, sizeof(CloudRequest));
 bool Cloud::clientlog = false;
+volatile uint8_t Cloud::batchState = BATCH_IDLE;
+volatile boolean Cloud::resync = false;
+CloudStats Cloud::stats = {0u, 0u, 0u, 0u, 0u, 0u, 0u};
 
 enum
 {
@@ -97,56 +125,199 @@ Cloud::Cloud()
   config.cloudEnabled = false;
   config.cloudToken = createToken();
   config.cloudInterval = DEFAULT_INTERVAL;
+  config.cloudDelta = false;
   config.customEnabled = false;
   config.customInterval = DEFAULT_INTERVAL;
   config.customUrl = "";
-  cloudCounter = 0u;
-  customCounter = 0u;
+  config.adaptiveInterval = false;
+  config.intervalFloor = DEFAULT_INTERVAL_FLOOR;
+  config.intervalCeiling = DEFAULT_INTERVAL_CEILING;
+  batchCounter = 0u;
+  syncedHash = 0u;
+  batchHash = 0u;
   state = 0u;
 }
 
+// called every second, also without WiFi to buffer the cloud samples
 void Cloud::update()
 {
+  boolean connected = gSystem->wlan.isConnected();
+
   if (config.cloudEnabled)
   {
     // First get time from server before sending data
     // Also send crash report if enabled
     if (now() < 31536000)
     {
-      Cloud::sendAPI(NOAPI, APILINK);
-      if(gSystem->getCrashReport() && (RecoveryMode::getResetCounter() > 0u))
+      if (connected)
       {
-        Cloud::sendAPI(APICRASHREPORT, APILINK);
-        Log.error("Crash report sent!" CR);
+        Cloud::sendAPI(NOAPI, APILINK);
+        if(gSystem->getCrashReport() && (RecoveryMode::getResetCounter() > 0u))
+        {
+          Cloud::sendAPI(APICRASHREPORT, APILINK);
+          Log.error("Crash report sent!" CR);
+        }
       }
     }
-    else if (0u == cloudCounter)
+    else if (cloudScheduler.update(config.cloudInterval, config.adaptiveInterval, config.intervalFloor, config.intervalCeiling))
     {
-      cloudCounter = config.cloudInterval;
-      Cloud::sendAPI(APICLOUD, CLOUDLINK);
+      captureSample(&sample);
+      buffer.add(&sample);
     }
+
+    if (connected)
+      sendBatch();
   }
   else
   {
     gSystem->cloud.state = 0;
   }
 
-  if (config.customEnabled && config.customUrl.length() > 0u)
+  if (connected)
   {
-    if (0u == customCounter)
+    if (config.customEnabled && config.customUrl.length() > 0u)
     {
-      customCounter = config.customInterval;
-      Cloud::sendAPI(APICUSTOM, CUSTOMLINK);
+      if (customScheduler.update(config.customInterval, config.adaptiveInterval, config.intervalFloor, config.intervalCeiling))
+      {
+        Cloud::sendAPI(APICUSTOM, CUSTOMLINK);
+      }
     }
+
+    handleQueue();
   }
 
-  handleQueue();
+  if (batchCounter)
+    batchCounter--;
+}
 
-  if (cloudCounter)
-    cloudCounter--;
+void Cloud::captureSample(CloudSample *sample)
+{
+  TemperatureGrp &temperatures = gSystem->temperatures;
+  PitmasterGrp &pitmasters = gSystem->pitmasters;
+
+  memset(sample, 0, sizeof(CloudSample));
+  sample->time = now();
+  sample->rssi = gSystem->wlan.getRssi();
+  sample->soc = (gSystem->battery != NULL) ? gSystem->battery->percentage : CLOUD_SAMPLE_NO_BATTERY;
+  sample->charge = (gSystem->battery != NULL) ? gSystem->battery->isCharging() : false;
+  sample->channelCount = min(temperatures.count(), (uint8_t)CLOUD_SAMPLE_MAX_CHANNELS);
+  sample->pitmasterCount = min(pitmasters.count(), (uint8_t)CLOUD_SAMPLE_MAX_PITMASTERS);
+
+  for (uint8_t i = 0u; i < sample->channelCount; i++)
+  {
+    TemperatureBase *temperature = temperatures[i];
+    float value = (temperature != NULL) ? temperature->getValue() : INACTIVEVALUE;
+
+    sample->temperatures[i] = (INACTIVEVALUE == value) ? CLOUD_SAMPLE_INACTIVE : (int16_t)lroundf(value * 10.0f);
+
+    if ((temperature != NULL) && temperature->isConnected())
+      sample->connected |= (1u << i);
+  }
+
+  for (uint8_t i = 0u; i < sample->pitmasterCount; i++)
+  {
+    Pitmaster *pm = pitmasters[i];
 
-  if (customCounter)
-    customCounter--;
+    if (NULL == pm)
+      continue;
+
+    sample->pitmasters[i].value = (uint8_t)pm->getValue();
+    sample->pitmasters[i].set = (int16_t)lroundf(pm->getTargetTemperature() * 10.0f);
+    sample->pitmasters[i].type = pm->getType();
+  }
+}
+
+// uploads the buffered samples oldest first, one batch at a time
+void Cloud::sendBatch()
+{
+  if (BATCH_SENDING == batchState)
+    return;
+
+  if (BATCH_DONE == batchState)
+  {
+    buffer.commit();
+
+    // the server has got the full snapshot
+    if (batchHash != 0u)
+      syncedHash = batchHash;
+  }
+  else if (BATCH_FAILED == batchState)
+  {
+    // try again with the next sample
+    batchCounter = cloudScheduler.getInterval();
+  }
+
+  batchState = BATCH_IDLE;
+
+  // server lost the snapshot
+  if (resync)
+  {
+    resync = false;
+    syncedHash = 0u;
+  }
+
+  if ((batchCounter > 0u) || (0u == buffer.getCount()))
+    return;
+
+  // full snapshot once, afterwards only the values as long as the settings are the same
+  uint32_t settingsHash = config.cloudDelta ? API::cloudSettingsHash() : 0u;
+  boolean delta = (settingsHash != 0u) && (settingsHash == syncedHash);
+  batchHash = delta ? 0u : settingsHash;
+
+  // estimate the batch size with the current sample
+  size_t sampleSize = max(API::cloudBatchWrite(NULL, &sample, 1u, settingsHash, delta), (size_t)1u);
+  uint16_t maxCount = constrain(CLOUD_BATCH_MAX_BYTES / sampleSize, 1u, CLOUD_BATCH_MAX_SAMPLES);
+  uint16_t count = buffer.peek(batch, maxCount);
+
+  if (0u == count)
+  {
+    // only skipped or empty records
+    buffer.commit();
+    return;
+  }
+
+  xbuf *requestDataPointer = new xbuf();
+
+  if (requestDataPointer != NULL)
+  {
+    CloudRequestPrint print(requestDataPointer);
+    API::cloudBatchWrite(&print, batch, count, settingsHash, delta);
+    CloudRequest cloudRequest = {CLOUDLINK, requestDataPointer, true};
+    if (xQueueSend(apiQueue, &cloudRequest, 0u) != pdTRUE)
+    {
+      delete cloudRequest.requestData;
+      stats.queueFull++;
+      return;
+    }
+
+    batchState = BATCH_SENDING;
+  }
+}
+
+// upload size of the current values with and without delta mode
+void Cloud::benchmark(Print *print)
+{
+  const uint16_t counts[] = {1u, CLOUD_BATCH_MAX_SAMPLES};
+  CloudSample *samples = new CloudSample[CLOUD_BATCH_MAX_SAMPLES];
+  uint32_t settingsHash = API::cloudSettingsHash();
+
+  captureSample(&samples[0]);
+
+  for (uint8_t i = 1u; i < CLOUD_BATCH_MAX_SAMPLES; i++)
+    samples[i] = samples[0];
+
+  for (uint8_t i = 0u; i < sizeof(counts) / sizeof(counts[0]); i++)
+  {
+    uint16_t count = counts[i];
+    size_t plain = API::cloudBatchWrite(NULL, samples, count);
+    size_t full = API::cloudBatchWrite(NULL, samples, count, settingsHash, false);
+    size_t delta = API::cloudBatchWrite(NULL, samples, count, settingsHash, true);
+
+    print->printf("cloud batch %u samples: no hash %u bytes | full %u bytes | delta %u bytes (%u%%)\n",
+                  count, plain, full, delta, (full > 0u) ? (delta * 100u) / full : 0u);
+  }
+
+  delete[] samples;
 }
 
 String Cloud::newToken()
@@ -179,14 +350,18 @@ void Cloud::saveConfig()
   json["enabled"] = config.cloudEnabled;
   json["token"] = config.cloudToken;
   json["interval"] = config.cloudInterval;
+  json["delta"] = config.cloudDelta;
 
   json["customEnabled"] = config.customEnabled;
   json["customUrl"] = config.customUrl;
   json["customInterval"] = config.customInterval;
+  json["adaptive"] = config.adaptiveInterval;
+  json["floor"] = config.intervalFloor;
+  json["ceiling"] = config.intervalCeiling;
   Settings::write(kCloud, json);
 
   // trigger send after config update
-  cloudCounter = 0u;
+  cloudScheduler.trigger();
 }
 
 void Cloud::saveUrl()
@@ -224,6 +399,8 @@ void Cloud::loadConfig()
       config.cloudToken = json["token"].asString();
     if (json.containsKey("interval"))
       config.cloudInterval = json["interval"];
+    if (json.containsKey("delta"))
+      config.cloudDelta = json["delta"];
 
     if (json.containsKey("customEnabled"))
       config.customEnabled = json["customEnabled"];
@@ -231,6 +408,12 @@ void Cloud::loadConfig()
       config.customUrl = json["customUrl"].asString();
     if (json.containsKey("customInterval"))
       config.customInterval = json["customInterval"];
+    if (json.containsKey("adaptive"))
+      config.adaptiveInterval = json["adaptive"];
+    if (json.containsKey("floor"))
+      config.intervalFloor = json["floor"];
+    if (json.containsKey("ceiling"))
+      config.intervalCeiling = json["ceiling"];
   }
 
   File file = SPIFFS.open(URL_FILE, "r");
@@ -259,6 +442,10 @@ void Cloud::loadConfig()
 
     file.close();
   }
+
+  // nothing would ever upload the samples of a disabled cloud
+  if (config.cloudEnabled)
+    buffer.begin();
 }
 
 CloudConfig Cloud::getConfig()
@@ -271,8 +458,13 @@ void Cloud::setConfig(CloudConfig newConfig)
   // copy new config
   config = newConfig;
 
+  if (config.cloudEnabled)
+    buffer.begin();
+  else
+    buffer.end();
+
   // trigger send after config update
-  cloudCounter = 0u;
+  cloudScheduler.trigger();
 
   // save to NvM
   saveConfig();
@@ -340,7 +532,7 @@ tmElements_t *Cloud::string_to_tm(tmElements_t *tme, char *str)
 
 void Cloud::onReadyStateChange(void *optParm, asyncHTTPrequest *request, int readyState)
 {
-  boolean *requestDone = (boolean *)optParm;
+  CloudConnection *connection = (CloudConnection *)optParm;
   int responseCode;
 
   if (READY_STATE_DONE == readyState)
@@ -356,27 +548,86 @@ void Cloud::onReadyStateChange(void *optParm, asyncHTTPrequest *request, int rea
     }
     else
     {
+      stats.httpErrors++;
       Log.warning("API response HTTP code: %d" CR, responseCode);
     }
-    
-    *requestDone = true;
+
+    if (connection->reused)
+      stats.reusedLatency += request->elapsedTime();
+    else
+      stats.connectLatency += request->elapsedTime();
+
+    if (connection->batch)
+      batchState = (HTTP_STATUS_OK == responseCode) ? BATCH_DONE : BATCH_FAILED;
+
+    connection->lastResponse = millis();
+    connection->busy = false;
+  }
+}
+
+String Cloud::getHost(String url)
+{
+  int start = url.indexOf("://");
+  start = (start >= 0) ? (start + 3) : 0;
+
+  int end = start;
+  while ((end < (int)url.length()) && (url[end] != '/') && (url[end] != ':') && (url[end] != '?'))
+    end++;
+
+  return url.substring(start, end);
+}
+
+// the connection to a host is reused, asyncHTTPrequest keeps its TCP client while the server allows it
+CloudConnection *Cloud::getConnection(String host)
+{
+  CloudConnection *unused = NULL;
+  CloudConnection *oldest = NULL;
+
+  for (uint8_t i = 0u; i < CLOUD_CONNECTION_COUNT; i++)
+  {
+    CloudConnection *connection = &connections[i];
+
+    if (connection->host == host)
+      return connection;
+
+    if ((NULL == connection->client) && (NULL == unused))
+      unused = connection;
+    else if ((connection->client != NULL) && (false == connection->busy) &&
+             ((NULL == oldest) || ((int32_t)(connection->lastResponse - oldest->lastResponse) < 0)))
+      oldest = connection;
   }
+
+  CloudConnection *connection = (unused != NULL) ? unused : oldest;
+
+  if (NULL == connection)
+    return NULL;
+
+  // a client can only be kept for one host
+  delete connection->client;
+  connection->client = new asyncHTTPrequest();
+  connection->host = host;
+  connection->busy = false;
+  connection->lastResponse = 0u;
+
+  return connection;
 }
 
 // ++++++++++++++++++++++++++++++++++++++++++++++++++++++
 // Send to API
 void Cloud::sendAPI(int apiIndex, int urlIndex)
 {
-  String requestDataString = API::apiData(apiIndex);
-  char *requestDataPointer = new char[requestDataString.length() + 1u];
+  // the document is written in small segments, no contiguous buffer needed
+  xbuf *requestDataPointer = new xbuf();
   
   if(requestDataPointer != NULL)
   {
-    strcpy(requestDataPointer, requestDataString.c_str());
-    CloudRequest cloudRequest = {urlIndex, requestDataPointer};
+    CloudRequestPrint print(requestDataPointer);
+    API::apiWrite(&print, apiIndex);
+    CloudRequest cloudRequest = {urlIndex, requestDataPointer, false};
     if(xQueueSend(apiQueue, &cloudRequest, 0u) != pdTRUE)
     {
       delete cloudRequest.requestData;
+      stats.queueFull++;
       Log.warning("Cloud request queue full!" CR);
     }
   }
@@ -386,32 +637,71 @@ void Cloud::sendAPI(int apiIndex, int urlIndex)
 // Handle API queue
 void Cloud::handleQueue()
 {
-  static boolean requestDone = true;
-
   CloudRequest cloudRequest;
+  UBaseType_t pending = uxQueueMessagesWaiting(apiQueue);
 
-  if (requestDone)
+  // requests to different hosts run in parallel, requests to a busy host go back to the queue in their order
+  while ((pending-- > 0u) && (xQueueReceive(apiQueue, &cloudRequest, 0u) == pdTRUE))
   {
-    if (xQueueReceive(apiQueue, &cloudRequest, 0u) == pdFALSE)
-      return;
+    String url = (cloudRequest.urlIndex != CUSTOMLINK) ? String("http://" + serverurl[cloudRequest.urlIndex].host + "/") : config.customUrl;
+    CloudConnection *connection = getConnection(getHost(url));
+
+    if ((NULL == connection) || connection->busy)
+    {
+      if (xQueueSend(apiQueue, &cloudRequest, 0u) != pdTRUE)
+      {
+        if (cloudRequest.batch)
+          batchState = BATCH_FAILED;
+
+        delete cloudRequest.requestData;
+        stats.queueFull++;
+        Log.warning("Cloud request queue full!" CR);
+      }
+
+      continue;
+    }
 
-    requestDone = false;
+    connection->busy = true;
+    connection->batch = cloudRequest.batch;
 
     if (clientlog)
-      apiClient.setDebug(true);
+      connection->client->setDebug(true);
 
-    String url = (cloudRequest.urlIndex != CUSTOMLINK) ? String("http://" + serverurl[cloudRequest.urlIndex].host + "/") : config.customUrl;
+    connection->client->onReadyStateChange(Cloud::onReadyStateChange, connection);
+
+    if (false == connection->client->open("POST", url.c_str()))
+    {
+      // still connected to an old host, start with a new client
+      delete connection->client;
+      connection->client = new asyncHTTPrequest();
+      connection->client->onReadyStateChange(Cloud::onReadyStateChange, connection);
+      connection->client->open("POST", url.c_str());
+    }
+
+    // asyncHTTPrequest opens a request on a still connected client right away, a new connection opens asynchronously
+    connection->reused = (READY_STATE_OPENED == connection->client->readyState());
+
+    if (connection->reused)
+      stats.reused++;
+    else
+      stats.connections++;
 
-    apiClient.onReadyStateChange(Cloud::onReadyStateChange, &requestDone);
-    apiClient.open("POST", url.c_str());
-    apiClient.setReqHeader("Connection", "close");
-    apiClient.setReqHeader("User-Agent", "WLANThermo ESP32");
-    apiClient.setReqHeader("Content-Type", "application/json");
+    connection->client->setReqHeader("Connection", "keep-alive");
+    connection->client->setReqHeader("User-Agent", "WLANThermo ESP32");
+    connection->client->setReqHeader("Content-Type", "application/json");
 
     if(cloudRequest.urlIndex != CUSTOMLINK)
-      apiClient.setReqHeader("SN", gSystem->getSerialNumber().c_str());
-    
-    apiClient.send(cloudRequest.requestData);
+      connection->client->setReqHeader("SN", gSystem->getSerialNumber().c_str());
+
+    if (false == connection->client->send(cloudRequest.requestData, cloudRequest.requestData->available()))
+    {
+      if (connection->batch)
+        batchState = BATCH_FAILED;
+
+      connection->busy = false;
+    }
+
     delete cloudRequest.requestData;
+    stats.requests++;
   }
-}
\ No newline at end of file
+}
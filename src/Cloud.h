@@ -23,23 +23,56 @@
 #include <Arduino.h>
 #include <TimeLib.h>
 #include <asyncHTTPrequest.h>
+#include "CloudBuffer.h"
+#include "CloudScheduler.h"
+
+// samples per cloud upload, fewer when the document would get too big
+#define CLOUD_BATCH_MAX_SAMPLES 8u
+#define CLOUD_BATCH_MAX_BYTES 8192u
 
 typedef struct
 {
   bool cloudEnabled;
   String cloudToken;
   uint16_t cloudInterval;
+  bool cloudDelta;
   bool customEnabled;
   String customUrl;
   uint16_t customInterval;
+  bool adaptiveInterval;
+  uint16_t intervalFloor;
+  uint16_t intervalCeiling;
 } CloudConfig;
 
 typedef struct
 {
   uint8_t urlIndex;
-  const char* requestData;
+  xbuf* requestData;
+  boolean batch;
 } CloudRequest;
 
+typedef struct
+{
+  uint32_t requests;
+  uint32_t httpErrors;
+  uint32_t queueFull;
+  uint32_t connections;
+  uint32_t reused;
+  uint32_t connectLatency;
+  uint32_t reusedLatency;
+} CloudStats;
+
+// kept alive connection to one host, requests to a host are sent one after the other
+typedef struct
+{
+  asyncHTTPrequest *client;
+  String host;
+  volatile boolean busy;
+  boolean reused;
+  boolean batch;
+  uint32_t lastResponse;
+} CloudConnection;
+
 enum
 {
   NOAPI,
@@ -82,6 +115,13 @@ public:
   uint8_t state;
   static void checkAPI();
   static void sendAPI(int apiIndex, int urlIndex);
+  static CloudStats getStats() { return stats; };
+  static uint32_t getQueueDepth() { return uxQueueMessagesWaiting(apiQueue); };
+  CloudBuffer *getBuffer() { return &buffer; };
+  CloudScheduler *getCloudScheduler() { return &cloudScheduler; };
+  CloudScheduler *getCustomScheduler() { return &customScheduler; };
+  static void requestResync() { resync = true; };
+  void benchmark(Print *print);
 
   static uint8_t serverurlCount;
   static ServerData serverurl[]; // 0:api, 1: note, 2:cloud
@@ -90,12 +130,25 @@ public:
 private:
   String createToken();
   static void onReadyStateChange(void *optParm, asyncHTTPrequest *request, int readyState);
+  static CloudConnection *getConnection(String host);
+  static String getHost(String url);
   static void readUTCfromHeader(String payload);
   static tmElements_t *string_to_tm(tmElements_t *tme, char *str);
   void handleQueue();
+  void captureSample(CloudSample *sample);
+  void sendBatch();
   CloudConfig config;
-  static asyncHTTPrequest apiClient;
+  static CloudConnection connections[];
   static QueueHandle_t apiQueue;
-  uint16_t cloudCounter;
-  uint16_t customCounter;
+  static CloudStats stats;
+  CloudScheduler cloudScheduler;
+  uint16_t batchCounter;
+  CloudBuffer buffer;
+  CloudSample sample;
+  CloudSample batch[CLOUD_BATCH_MAX_SAMPLES];
+  static volatile uint8_t batchState;
+  static volatile boolean resync;
+  uint32_t syncedHash;
+  uint32_t batchHash;
+  CloudScheduler customScheduler;
 };
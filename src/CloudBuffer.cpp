@@ -0,0 +1,538 @@
+/*************************************************** 
+    Copyright (C) 2020  Martin Koerner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    
+    HISTORY: Please refer Github History
+    
+****************************************************/
+#include "CloudBuffer.h"
+#include "EventLog.h"
+#include <SPIFFS.h>
+#include <Preferences.h>
+
+#define CLOUD_BUFFER_FILE_PREFIX "/cloudq"
+#define CLOUD_BUFFER_NVS_NAMESPACE "cloudq"
+#define CLOUD_BUFFER_NVS_ACKED "acked"
+#define CLOUD_BUFFER_HEADER_SIZE sizeof(uint32_t)
+#define CLOUD_BUFFER_SAMPLE_HEADER_SIZE 13u
+#define CLOUD_BUFFER_MAX_RECORD (CLOUD_BUFFER_SAMPLE_HEADER_SIZE + (CLOUD_SAMPLE_MAX_CHANNELS * 2u) + (CLOUD_SAMPLE_MAX_PITMASTERS * 4u))
+#define CLOUD_BUFFER_MIN_TIME 1577836800u // 01.01.2020, time is not synchronized before
+#define CLOUD_BUFFER_CLOCK_TOLERANCE 300u // s, smaller time corrections only skip samples
+
+CloudBuffer::CloudBuffer()
+{
+  this->mutex = xSemaphoreCreateMutex();
+  this->ram = NULL;
+  this->ramHead = 0u;
+  this->ramUsed = 0u;
+  this->ramCount = 0u;
+  this->readSequence = 0u;
+  this->readOffset = CLOUD_BUFFER_HEADER_SIZE;
+  this->writeSequence = 0u;
+  this->writeSize = 0u;
+  this->fileCount = 0u;
+  this->newestTime = 0u;
+  this->ackedTime = 0u;
+  this->pendingCount = 0u;
+  this->pendingTime = 0u;
+  this->pendingFile = false;
+  this->pendingSequence = 0u;
+  this->pendingOffset = 0u;
+  this->pendingEnd = 0u;
+  memset(&this->stats, 0, sizeof(this->stats));
+}
+
+String CloudBuffer::getSegmentName(uint32_t sequence)
+{
+  return CLOUD_BUFFER_FILE_PREFIX + String(sequence % CLOUD_BUFFER_SEGMENTS) + ".bin";
+}
+
+// continue with the segments left from the last run, needs a mounted SPIFFS
+void CloudBuffer::begin()
+{
+  Preferences prefs;
+  boolean found = false;
+
+  xSemaphoreTake(this->mutex, portMAX_DELAY);
+
+  if (this->ram != NULL)
+  {
+    xSemaphoreGive(this->mutex);
+    return;
+  }
+
+  this->ram = (uint8_t *)(psramFound() ? ps_malloc(CLOUD_BUFFER_RAM_SIZE) : malloc(CLOUD_BUFFER_RAM_SIZE));
+  this->ramHead = 0u;
+  this->ramUsed = 0u;
+  this->ramCount = 0u;
+  this->fileCount = 0u;
+  this->readOffset = CLOUD_BUFFER_HEADER_SIZE;
+
+  // samples up to the acked time have already been uploaded, peek() skips them
+  prefs.begin(CLOUD_BUFFER_NVS_NAMESPACE, true);
+  this->ackedTime = max(this->ackedTime, prefs.getUInt(CLOUD_BUFFER_NVS_ACKED, 0u));
+  prefs.end();
+  this->newestTime = max(this->newestTime, this->ackedTime);
+
+  for (uint8_t slot = 0u; slot < CLOUD_BUFFER_SEGMENTS; slot++)
+  {
+    File file = SPIFFS.open(getSegmentName(slot));
+    uint32_t sequence;
+
+    if (file && (file.read((uint8_t *)&sequence, sizeof(sequence)) == sizeof(sequence)) && ((sequence % CLOUD_BUFFER_SEGMENTS) == slot))
+    {
+      if ((false == found) || (sequence < this->readSequence))
+        this->readSequence = sequence;
+
+      if ((false == found) || (sequence > this->writeSequence))
+      {
+        this->writeSequence = sequence;
+        this->writeSize = file.size();
+      }
+
+      found = true;
+    }
+
+    file.close();
+  }
+
+  if (found)
+  {
+    // files of an older run in between are skipped by their sequence
+    if ((this->writeSequence - this->readSequence) >= CLOUD_BUFFER_SEGMENTS)
+      this->readSequence = this->writeSequence - CLOUD_BUFFER_SEGMENTS + 1u;
+
+    for (uint32_t sequence = this->readSequence; sequence <= this->writeSequence; sequence++)
+      this->fileCount += countRecords(sequence, CLOUD_BUFFER_HEADER_SIZE, &this->newestTime);
+  }
+
+  xSemaphoreGive(this->mutex);
+
+  Log.notice("Cloud buffer: %d samples on SPIFFS" CR, this->fileCount);
+}
+
+// cloud disabled, the RAM samples are kept on SPIFFS for a later upload
+void CloudBuffer::end()
+{
+  xSemaphoreTake(this->mutex, portMAX_DELAY);
+  spill();
+  free(this->ram);
+  this->ram = NULL;
+  xSemaphoreGive(this->mutex);
+}
+
+void CloudBuffer::saveAckedTime()
+{
+  Preferences prefs;
+
+  prefs.begin(CLOUD_BUFFER_NVS_NAMESPACE, false);
+  prefs.putUInt(CLOUD_BUFFER_NVS_ACKED, this->ackedTime);
+  prefs.end();
+}
+
+uint8_t CloudBuffer::encode(CloudSample *sample, uint8_t *data)
+{
+  uint8_t channelCount = min(sample->channelCount, (uint8_t)CLOUD_SAMPLE_MAX_CHANNELS);
+  uint8_t pitmasterCount = min(sample->pitmasterCount, (uint8_t)CLOUD_SAMPLE_MAX_PITMASTERS);
+  uint8_t length = 0u;
+
+  memcpy(&data[length], &sample->time, sizeof(sample->time));
+  length += sizeof(sample->time);
+  data[length++] = (uint8_t)sample->rssi;
+  data[length++] = sample->soc;
+  data[length++] = sample->charge;
+  data[length++] = channelCount;
+  data[length++] = pitmasterCount;
+  memcpy(&data[length], &sample->connected, sizeof(sample->connected));
+  length += sizeof(sample->connected);
+  memcpy(&data[length], sample->temperatures, channelCount * sizeof(int16_t));
+  length += channelCount * sizeof(int16_t);
+  memcpy(&data[length], sample->pitmasters, pitmasterCount * sizeof(CloudSamplePitmaster));
+  length += pitmasterCount * sizeof(CloudSamplePitmaster);
+
+  return length;
+}
+
+boolean CloudBuffer::decode(const uint8_t *data, uint8_t length, CloudSample *sample)
+{
+  if (length < CLOUD_BUFFER_SAMPLE_HEADER_SIZE)
+    return false;
+
+  uint8_t channelCount = data[7];
+  uint8_t pitmasterCount = data[8];
+
+  if ((channelCount > CLOUD_SAMPLE_MAX_CHANNELS) || (pitmasterCount > CLOUD_SAMPLE_MAX_PITMASTERS) ||
+      (length != (CLOUD_BUFFER_SAMPLE_HEADER_SIZE + (channelCount * sizeof(int16_t)) + (pitmasterCount * sizeof(CloudSamplePitmaster)))))
+    return false;
+
+  memcpy(&sample->time, &data[0], sizeof(sample->time));
+  sample->rssi = (int8_t)data[4];
+  sample->soc = data[5];
+  sample->charge = data[6];
+  sample->channelCount = channelCount;
+  sample->pitmasterCount = pitmasterCount;
+  memcpy(&sample->connected, &data[9], sizeof(sample->connected));
+  memcpy(sample->temperatures, &data[CLOUD_BUFFER_SAMPLE_HEADER_SIZE], channelCount * sizeof(int16_t));
+  memcpy(sample->pitmasters, &data[CLOUD_BUFFER_SAMPLE_HEADER_SIZE + (channelCount * sizeof(int16_t))], pitmasterCount * sizeof(CloudSamplePitmaster));
+
+  return true;
+}
+
+// the clock went back or a future time was stored before, e.g. by a wrong RTC time
+void CloudBuffer::checkClock(uint32_t now)
+{
+  if ((now + CLOUD_BUFFER_CLOCK_TOLERANCE) >= this->newestTime)
+    return;
+
+  Log.warning("Cloud buffer: clock went back %u s" CR, this->newestTime - now);
+  this->newestTime = now - 1u;
+
+  if (this->ackedTime > this->newestTime)
+  {
+    this->ackedTime = this->newestTime;
+    saveAckedTime();
+  }
+}
+
+// ignores samples that are not newer than the last one, e.g. after a small time correction
+boolean CloudBuffer::add(CloudSample *sample)
+{
+  uint8_t data[CLOUD_BUFFER_MAX_RECORD];
+  boolean added = false;
+
+  xSemaphoreTake(this->mutex, portMAX_DELAY);
+
+  if (sample->time < CLOUD_BUFFER_MIN_TIME)
+  {
+    // a time before the synchronization would reset the clock check
+    this->stats.dropped++;
+    xSemaphoreGive(this->mutex);
+    return false;
+  }
+
+  checkClock(sample->time);
+
+  if (sample->time <= this->newestTime)
+  {
+    this->stats.duplicates++;
+  }
+  else if (this->ram != NULL)
+  {
+    uint8_t length = encode(sample, data);
+
+    if ((this->ramUsed + 1u + length) > CLOUD_BUFFER_RAM_SIZE)
+      spill();
+
+    uint32_t position = (this->ramHead + this->ramUsed) % CLOUD_BUFFER_RAM_SIZE;
+    this->ram[position] = length;
+
+    for (uint8_t i = 0u; i < length; i++)
+      this->ram[(position + 1u + i) % CLOUD_BUFFER_RAM_SIZE] = data[i];
+
+    this->ramUsed += 1u + length;
+    this->ramCount++;
+    this->newestTime = sample->time;
+    this->stats.added++;
+    added = true;
+  }
+
+  xSemaphoreGive(this->mutex);
+
+  return added;
+}
+
+// oldest samples first, they stay in the buffer until commit()
+uint16_t CloudBuffer::peek(CloudSample *samples, uint16_t maxCount)
+{
+  uint16_t count = 0u;
+
+  xSemaphoreTake(this->mutex, portMAX_DELAY);
+
+  this->pendingCount = 0u;
+  this->pendingTime = this->ackedTime;
+  this->pendingFile = false;
+
+  // the acked time of the last run can only be checked with a synchronized clock
+  uint32_t now = time(NULL);
+
+  if (now >= CLOUD_BUFFER_MIN_TIME)
+  {
+    checkClock(now);
+
+    if (this->fileCount > 0u)
+      count = peekFile(samples, maxCount);
+
+    if (false == this->pendingFile)
+      count = peekRam(samples, maxCount);
+  }
+
+  xSemaphoreGive(this->mutex);
+
+  return count;
+}
+
+uint16_t CloudBuffer::peekFile(CloudSample *samples, uint16_t maxCount)
+{
+  uint8_t data[CLOUD_BUFFER_MAX_RECORD];
+  uint8_t length;
+  uint16_t count = 0u;
+  File file;
+
+  // skip segments that are missing or belong to an older run
+  while (true)
+  {
+    uint32_t sequence = 0u;
+    file = SPIFFS.open(getSegmentName(this->readSequence));
+
+    if (file && (file.read((uint8_t *)&sequence, sizeof(sequence)) == sizeof(sequence)) && (sequence == this->readSequence))
+      break;
+
+    file.close();
+
+    if (this->readSequence == this->writeSequence)
+    {
+      this->fileCount = 0u;
+      this->writeSize = 0u;
+      this->readOffset = CLOUD_BUFFER_HEADER_SIZE;
+      return 0u;
+    }
+
+    this->readSequence++;
+    this->readOffset = CLOUD_BUFFER_HEADER_SIZE;
+  }
+
+  this->pendingFile = true;
+  this->pendingSequence = this->readSequence;
+  this->pendingOffset = this->readOffset;
+  this->pendingEnd = file.size();
+  file.seek(this->readOffset);
+
+  while ((count < maxCount) && (this->pendingOffset < this->pendingEnd))
+  {
+    // a record cut off by a reset ends the segment
+    if ((file.read(&length, 1u) != 1u) || (length > CLOUD_BUFFER_MAX_RECORD) || (file.read(data, length) != length))
+    {
+      this->pendingOffset = this->pendingEnd;
+      break;
+    }
+
+    this->pendingOffset += 1u + length;
+    this->pendingCount++;
+
+    if (decode(data, length, &samples[count]) && (samples[count].time > this->ackedTime))
+    {
+      this->pendingTime = samples[count].time;
+      count++;
+    }
+  }
+
+  file.close();
+
+  return count;
+}
+
+void CloudBuffer::readRam(uint32_t position, uint8_t *data, uint32_t size)
+{
+  for (uint32_t i = 0u; i < size; i++)
+    data[i] = this->ram[(position + i) % CLOUD_BUFFER_RAM_SIZE];
+}
+
+uint16_t CloudBuffer::peekRam(CloudSample *samples, uint16_t maxCount)
+{
+  uint8_t data[CLOUD_BUFFER_MAX_RECORD];
+  uint32_t position = this->ramHead;
+  uint16_t count = 0u;
+
+  this->pendingFile = false;
+
+  for (uint32_t i = 0u; (i < this->ramCount) && (count < maxCount); i++)
+  {
+    uint8_t length = this->ram[position % CLOUD_BUFFER_RAM_SIZE];
+    readRam(position + 1u, data, length);
+    position += 1u + length;
+    this->pendingCount++;
+
+    if (decode(data, length, &samples[count]) && (samples[count].time > this->ackedTime))
+    {
+      this->pendingTime = samples[count].time;
+      count++;
+    }
+  }
+
+  return count;
+}
+
+// removes the samples of the last peek() after a successful upload, also
+// needed when peek() returned nothing to remove skipped or empty records
+void CloudBuffer::commit()
+{
+  xSemaphoreTake(this->mutex, portMAX_DELAY);
+
+  // samples that were moved or dropped in between are skipped by their time,
+  // samples of a wrong clock don't move it ahead of the newest valid sample
+  uint32_t acked = min(this->pendingTime, this->newestTime);
+
+  if (acked > this->ackedTime)
+    this->ackedTime = acked;
+
+  if (this->pendingFile)
+  {
+    // only samples on SPIFFS survive a restart, RAM samples are removed right away
+    saveAckedTime();
+
+    if (this->pendingSequence == this->readSequence)
+    {
+      this->readOffset = this->pendingOffset;
+      this->fileCount -= min(this->pendingCount, this->fileCount);
+      this->stats.sent += this->pendingCount;
+
+      uint32_t end = (this->readSequence == this->writeSequence) ? this->writeSize : this->pendingEnd;
+
+      if (this->readOffset >= end)
+        removeReadSegment();
+    }
+  }
+  else
+  {
+    for (uint32_t i = 0u; (i < this->pendingCount) && (this->ramCount > 0u); i++)
+    {
+      uint8_t length = this->ram[this->ramHead];
+      this->ramHead = (this->ramHead + 1u + length) % CLOUD_BUFFER_RAM_SIZE;
+      this->ramUsed -= 1u + length;
+      this->ramCount--;
+      this->stats.sent++;
+    }
+  }
+
+  this->pendingCount = 0u;
+
+  xSemaphoreGive(this->mutex);
+}
+
+// moves the RAM content to SPIFFS before restart or deep sleep
+void CloudBuffer::flush()
+{
+  xSemaphoreTake(this->mutex, portMAX_DELAY);
+  spill();
+  xSemaphoreGive(this->mutex);
+}
+
+uint32_t CloudBuffer::getCount()
+{
+  return this->ramCount + this->fileCount;
+}
+
+uint32_t CloudBuffer::countRecords(uint32_t sequence, uint32_t offset, uint32_t *newestTime)
+{
+  uint8_t data[CLOUD_BUFFER_MAX_RECORD];
+  uint32_t fileSequence = 0u;
+  uint32_t count = 0u;
+  uint8_t length;
+  File file = SPIFFS.open(getSegmentName(sequence));
+
+  if (file && (file.read((uint8_t *)&fileSequence, sizeof(fileSequence)) == sizeof(fileSequence)) && (fileSequence == sequence))
+  {
+    file.seek(offset);
+
+    while ((file.read(&length, 1u) == 1u) && (length <= CLOUD_BUFFER_MAX_RECORD) && (file.read(data, length) == length))
+    {
+      uint32_t time;
+      memcpy(&time, data, sizeof(time));
+      count++;
+
+      if ((newestTime != NULL) && (time > *newestTime))
+        *newestTime = time;
+    }
+  }
+
+  file.close();
+
+  return count;
+}
+
+void CloudBuffer::removeReadSegment()
+{
+  SPIFFS.remove(getSegmentName(this->readSequence));
+
+  if (this->readSequence == this->writeSequence)
+  {
+    this->writeSequence++;
+    this->writeSize = 0u;
+    this->fileCount = 0u;
+  }
+
+  this->readSequence++;
+  this->readOffset = CLOUD_BUFFER_HEADER_SIZE;
+}
+
+// bounded memory: the oldest samples are given up first
+void CloudBuffer::dropOldestSegment()
+{
+  uint32_t count = countRecords(this->readSequence, this->readOffset, NULL);
+
+  this->stats.dropped += count;
+  this->fileCount -= min(count, this->fileCount);
+  removeReadSegment();
+  Log.warning("Cloud buffer full, %d samples dropped" CR, count);
+}
+
+void CloudBuffer::spill()
+{
+  if (0u == this->ramCount)
+    return;
+
+  // start the next segment when the current one is full
+  if ((this->writeSize > 0u) && ((this->writeSize + this->ramUsed) > CLOUD_BUFFER_SEGMENT_SIZE))
+  {
+    this->writeSequence++;
+    this->writeSize = 0u;
+  }
+
+  if ((this->writeSequence - this->readSequence) >= CLOUD_BUFFER_SEGMENTS)
+    dropOldestSegment();
+
+  File file = SPIFFS.open(getSegmentName(this->writeSequence), (0u == this->writeSize) ? FILE_WRITE : FILE_APPEND);
+
+  if (file)
+  {
+    if (0u == this->writeSize)
+    {
+      file.write((uint8_t *)&this->writeSequence, sizeof(this->writeSequence));
+      this->writeSize = CLOUD_BUFFER_HEADER_SIZE;
+    }
+
+    uint32_t firstPart = min(this->ramUsed, (uint32_t)(CLOUD_BUFFER_RAM_SIZE - this->ramHead));
+    file.write(&this->ram[this->ramHead], firstPart);
+    file.write(this->ram, this->ramUsed - firstPart);
+    file.close();
+
+    this->writeSize += this->ramUsed;
+    this->fileCount += this->ramCount;
+    this->stats.spilledBytes += this->ramUsed;
+  }
+  else
+  {
+    this->stats.dropped += this->ramCount;
+    Log.error("Cloud buffer: SPIFFS write failed, %d samples dropped" CR, this->ramCount);
+  }
+
+  this->ramHead = 0u;
+  this->ramUsed = 0u;
+  this->ramCount = 0u;
+
+  // a pending RAM batch is read again from SPIFFS, commit() skips it by time
+  if (false == this->pendingFile)
+    this->pendingCount = 0u;
+}
@@ -0,0 +1,114 @@
+/*************************************************** 
+    Copyright (C) 2020  Martin Koerner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    
+    HISTORY: Please refer Github History
+    
+****************************************************/
+#pragma once
+
+#include "Arduino.h"
+
+#define CLOUD_SAMPLE_MAX_CHANNELS 32u
+#define CLOUD_SAMPLE_MAX_PITMASTERS 2u
+#define CLOUD_SAMPLE_INACTIVE INT16_MIN
+#define CLOUD_SAMPLE_NO_BATTERY 0xFFu
+
+// RAM ring for the latest samples, older ones are moved to SPIFFS segments
+#define CLOUD_BUFFER_RAM_SIZE 4096u
+#define CLOUD_BUFFER_SEGMENT_SIZE 16384u
+#define CLOUD_BUFFER_SEGMENTS 4u
+
+typedef struct
+{
+  uint8_t value;
+  uint8_t type;
+  int16_t set; // * 10
+} CloudSamplePitmaster;
+
+// Values of one cloud upload, channel and pitmaster settings are taken
+// from the current configuration when the sample is sent
+typedef struct
+{
+  uint32_t time;
+  int8_t rssi;
+  uint8_t soc;
+  uint8_t charge;
+  uint8_t channelCount;
+  uint8_t pitmasterCount;
+  uint32_t connected;
+  int16_t temperatures[CLOUD_SAMPLE_MAX_CHANNELS]; // * 10
+  CloudSamplePitmaster pitmasters[CLOUD_SAMPLE_MAX_PITMASTERS];
+} CloudSample;
+
+typedef struct
+{
+  uint32_t added;
+  uint32_t duplicates;
+  uint32_t sent;
+  uint32_t dropped;
+  uint32_t spilledBytes;
+} CloudBufferStats;
+
+// Store and forward queue for cloud samples, oldest first. A RAM ring takes
+// new samples, when it is full its content is appended to the newest SPIFFS
+// segment. When all segments are used the oldest one is dropped.
+// Records are only removed by commit() after the upload has been confirmed.
+class CloudBuffer
+{
+public:
+  CloudBuffer();
+  void begin();
+  void end();
+  boolean add(CloudSample *sample);
+  uint16_t peek(CloudSample *samples, uint16_t maxCount);
+  void commit();
+  void flush();
+  uint32_t getCount();
+  CloudBufferStats getStats() { return this->stats; };
+  static uint8_t encode(CloudSample *sample, uint8_t *data);
+  static boolean decode(const uint8_t *data, uint8_t length, CloudSample *sample);
+
+private:
+  static String getSegmentName(uint32_t sequence);
+  uint32_t countRecords(uint32_t sequence, uint32_t offset, uint32_t *newestTime);
+  uint16_t peekFile(CloudSample *samples, uint16_t maxCount);
+  uint16_t peekRam(CloudSample *samples, uint16_t maxCount);
+  void readRam(uint32_t position, uint8_t *data, uint32_t size);
+  void spill();
+  void dropOldestSegment();
+  void removeReadSegment();
+  void saveAckedTime();
+  void checkClock(uint32_t now);
+  SemaphoreHandle_t mutex;
+  uint8_t *ram;
+  uint32_t ramHead;
+  uint32_t ramUsed;
+  uint32_t ramCount;
+  uint32_t readSequence;
+  uint32_t readOffset;
+  uint32_t writeSequence;
+  uint32_t writeSize;
+  uint32_t fileCount;
+  uint32_t newestTime;
+  uint32_t ackedTime;
+  uint32_t pendingCount;
+  uint32_t pendingTime;
+  boolean pendingFile;
+  uint32_t pendingSequence;
+  uint32_t pendingOffset;
+  uint32_t pendingEnd;
+  CloudBufferStats stats;
+};
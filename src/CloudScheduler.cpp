@@ -0,0 +1,141 @@
+/*************************************************** 
+    Copyright (C) 2020  Martin Koerner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    
+    HISTORY: Please refer Github History
+    
+****************************************************/
+#include "CloudScheduler.h"
+#include "system/SystemBase.h"
+
+CloudScheduler::CloudScheduler()
+{
+  for (uint8_t i = 0u; i < CLOUD_SAMPLE_MAX_CHANNELS; i++)
+    this->values[i] = INACTIVEVALUE;
+
+  this->connected = 0u;
+  this->alarms = 0u;
+  this->elapsed = 0u;
+  this->interval = 0u;
+  this->triggered = true;
+  this->uploads = 0u;
+}
+
+boolean CloudScheduler::update(uint16_t interval, boolean adaptive, uint16_t floor, uint16_t ceiling)
+{
+  boolean due = this->triggered;
+
+  if (this->elapsed < UINT16_MAX)
+    this->elapsed++;
+
+  if (!adaptive)
+  {
+    this->interval = interval;
+    due |= (this->elapsed >= this->interval);
+  }
+  else
+  {
+    boolean changed = false;
+    float delta = getMaxDelta(&changed);
+
+    floor = max(floor, (uint16_t)1u);
+    ceiling = max(ceiling, floor);
+    this->interval = constrain(this->interval, floor, ceiling);
+
+    if (this->elapsed >= this->interval)
+    {
+      // the gradient since the last upload decides about the next interval
+      float gradient = delta * 60.0f / this->elapsed;
+      this->interval = (changed || (gradient >= CLOUD_SCHEDULER_GRADIENT)) ? floor : (uint16_t)min((uint32_t)this->interval * 2u, (uint32_t)ceiling);
+      due = true;
+    }
+    else if ((changed || (delta >= CLOUD_SCHEDULER_STEP)) && (this->elapsed >= floor))
+    {
+      this->interval = floor;
+      due = true;
+    }
+  }
+
+  if (due)
+  {
+    snapshot();
+    this->elapsed = 0u;
+    this->triggered = false;
+    this->uploads++;
+  }
+
+  return due;
+}
+
+// biggest value change since the last upload, changed is set for a new alarm or connection state
+float CloudScheduler::getMaxDelta(boolean *changed)
+{
+  TemperatureGrp &temperatures = gSystem->temperatures;
+  uint8_t count = min(temperatures.count(), (uint8_t)CLOUD_SAMPLE_MAX_CHANNELS);
+  uint32_t connected = 0u;
+  uint32_t alarms = 0u;
+  float delta = 0.0f;
+
+  for (uint8_t i = 0u; i < count; i++)
+  {
+    TemperatureBase *temperature = temperatures[i];
+
+    if (NULL == temperature)
+      continue;
+
+    float value = temperature->getValue();
+
+    if (temperature->isConnected())
+      connected |= (1u << i);
+
+    if (temperature->getAlarmStatus() != NoAlarm)
+      alarms |= (1u << i);
+
+    if ((value != INACTIVEVALUE) && (this->values[i] != INACTIVEVALUE))
+      delta = max(delta, fabsf(value - this->values[i]));
+  }
+
+  *changed = (connected != this->connected) || (alarms != this->alarms);
+
+  return delta;
+}
+
+void CloudScheduler::snapshot()
+{
+  TemperatureGrp &temperatures = gSystem->temperatures;
+  uint8_t count = min(temperatures.count(), (uint8_t)CLOUD_SAMPLE_MAX_CHANNELS);
+
+  this->connected = 0u;
+  this->alarms = 0u;
+
+  for (uint8_t i = 0u; i < count; i++)
+  {
+    TemperatureBase *temperature = temperatures[i];
+
+    if (NULL == temperature)
+    {
+      this->values[i] = INACTIVEVALUE;
+      continue;
+    }
+
+    this->values[i] = temperature->getValue();
+
+    if (temperature->isConnected())
+      this->connected |= (1u << i);
+
+    if (temperature->getAlarmStatus() != NoAlarm)
+      this->alarms |= (1u << i);
+  }
+}
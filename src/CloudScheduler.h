@@ -0,0 +1,52 @@
+/*************************************************** 
+    Copyright (C) 2020  Martin Koerner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    
+    HISTORY: Please refer Github History
+    
+****************************************************/
+#pragma once
+
+#include "Arduino.h"
+#include "CloudBuffer.h"
+
+// change in the display unit per minute since the last upload, above it the floor interval is used
+#define CLOUD_SCHEDULER_GRADIENT 1.0f
+// change since the last upload that sends right away (e.g. lid opened)
+#define CLOUD_SCHEDULER_STEP 2.0f
+
+// Decides when the next upload of a stream is due, update() is called every second.
+// With adaptive intervals the interval drops to the floor while a channel moves
+// or changes its alarm state and doubles up to the ceiling while all values are flat.
+class CloudScheduler
+{
+public:
+  CloudScheduler();
+  boolean update(uint16_t interval, boolean adaptive, uint16_t floor, uint16_t ceiling);
+  void trigger() { this->triggered = true; };
+  uint16_t getInterval() { return this->interval; };
+  uint32_t getUploads() { return this->uploads; };
+
+private:
+  float getMaxDelta(boolean *changed);
+  void snapshot();
+  float values[CLOUD_SAMPLE_MAX_CHANNELS];
+  uint32_t connected;
+  uint32_t alarms;
+  uint16_t elapsed;
+  uint16_t interval;
+  boolean triggered;
+  uint32_t uploads;
+};
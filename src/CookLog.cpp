@@ -0,0 +1,503 @@
+/*************************************************** 
+    Copyright (C) 2020  Martin Koerner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    
+    HISTORY: Please refer Github History
+    
+****************************************************/
+
+#include "CookLog.h"
+#include "temperature/TemperatureBase.h"
+#include <rom/crc.h>
+
+#define COOKLOG_HEADER_BITS (sizeof(CookLogBlockHeader) * 8u)
+#define COOKLOG_NO_WINDOW 0xFFu
+
+union FloatBits
+{
+  float value;
+  uint32_t bits;
+};
+
+CookLogEncoder::CookLogEncoder(uint8_t *block, uint16_t blockSize)
+{
+  this->block = block;
+  this->blockSize = blockSize;
+  this->payloadBits = (blockSize - sizeof(CookLogBlockFooter)) * 8u;
+  reset(0u, 0u);
+}
+
+void CookLogEncoder::reset(uint8_t count, uint8_t unit)
+{
+  CookLogBlockHeader header = {COOKLOG_MAGIC, min(count, (uint8_t)COOKLOG_MAX_SERIES), unit};
+
+  memset(this->block, 0, this->blockSize);
+  memcpy(this->block, &header, sizeof(header));
+
+  this->count = header.count;
+  this->overflow = false;
+  this->state.bitPosition = COOKLOG_HEADER_BITS;
+  this->state.samples = 0u;
+  this->state.firstTime = 0u;
+  this->state.lastTime = 0u;
+  this->state.lastDelta = 0;
+
+  for (uint8_t i = 0u; i < COOKLOG_MAX_SERIES; i++)
+  {
+    this->state.values[i] = 0u;
+    this->state.leading[i] = COOKLOG_NO_WINDOW;
+    this->state.trailing[i] = 0u;
+  }
+}
+
+// returns false when the sample does not fit into this block anymore
+boolean CookLogEncoder::add(CookLogSample *sample)
+{
+  CookLogBlockHeader *header = (CookLogBlockHeader *)this->block;
+
+  if ((sample->count != this->count) || (sample->unit != header->unit))
+    return false;
+
+  CookLogState backup = this->state;
+
+  writeTime(sample->time);
+
+  for (uint8_t i = 0u; i < this->count; i++)
+    writeValue(i, sample->values[i]);
+
+  if (this->overflow)
+  {
+    this->state = backup;
+    this->overflow = false;
+    return false;
+  }
+
+  if (0u == this->state.samples)
+    this->state.firstTime = sample->time;
+
+  this->state.lastTime = sample->time;
+  this->state.samples++;
+
+  return true;
+}
+
+void CookLogEncoder::finish()
+{
+  CookLogBlockFooter footer;
+
+  // clear the bits of a rolled back sample
+  uint16_t usedBytes = getUsedBytes();
+  memset(&this->block[usedBytes], 0, this->blockSize - sizeof(CookLogBlockFooter) - usedBytes);
+  if (this->state.bitPosition % 8u)
+    this->block[usedBytes - 1u] &= (uint8_t)(0xFFu << (8u - (this->state.bitPosition % 8u)));
+
+  footer.firstTime = this->state.firstTime;
+  footer.lastTime = this->state.lastTime;
+  footer.samples = this->state.samples;
+  footer.usedBytes = usedBytes;
+  memcpy(&this->block[this->blockSize - sizeof(footer)], &footer, sizeof(footer));
+
+  footer.crc = CookLog::crc(this->block, this->blockSize);
+  memcpy(&this->block[this->blockSize - sizeof(footer)], &footer, sizeof(footer));
+}
+
+void CookLogEncoder::writeBits(uint32_t value, uint8_t bits)
+{
+  if ((this->state.bitPosition + bits) > this->payloadBits)
+  {
+    this->overflow = true;
+    return;
+  }
+
+  while (bits--)
+  {
+    uint8_t mask = 0x80u >> (this->state.bitPosition % 8u);
+    uint8_t *byte = &this->block[this->state.bitPosition / 8u];
+
+    *byte = (value >> bits) & 1u ? (*byte | mask) : (*byte & ~mask);
+    this->state.bitPosition++;
+  }
+}
+
+void CookLogEncoder::writeTime(uint32_t time)
+{
+  if (0u == this->state.samples)
+  {
+    writeBits(time, 32u);
+    this->state.lastDelta = 0;
+    return;
+  }
+
+  int32_t delta = time - this->state.lastTime;
+  int32_t deltaOfDelta = delta - this->state.lastDelta;
+  this->state.lastDelta = delta;
+
+  if (0 == deltaOfDelta)
+  {
+    writeBits(0u, 1u);
+  }
+  else if ((deltaOfDelta >= -63) && (deltaOfDelta <= 64))
+  {
+    writeBits(0x02u, 2u);
+    writeBits(deltaOfDelta + 63, 7u);
+  }
+  else if ((deltaOfDelta >= -255) && (deltaOfDelta <= 256))
+  {
+    writeBits(0x06u, 3u);
+    writeBits(deltaOfDelta + 255, 9u);
+  }
+  else if ((deltaOfDelta >= -2047) && (deltaOfDelta <= 2048))
+  {
+    writeBits(0x0Eu, 4u);
+    writeBits(deltaOfDelta + 2047, 12u);
+  }
+  else
+  {
+    writeBits(0x0Fu, 4u);
+    writeBits(deltaOfDelta, 32u);
+  }
+}
+
+void CookLogEncoder::writeValue(uint8_t index, float value)
+{
+  FloatBits current;
+  current.value = value;
+
+  if (0u == this->state.samples)
+  {
+    writeBits(current.bits, 32u);
+    this->state.values[index] = current.bits;
+    return;
+  }
+
+  uint32_t xorValue = current.bits ^ this->state.values[index];
+  this->state.values[index] = current.bits;
+
+  if (0u == xorValue)
+  {
+    writeBits(0u, 1u);
+    return;
+  }
+
+  uint8_t leading = min(__builtin_clz(xorValue), 31);
+  uint8_t trailing = __builtin_ctz(xorValue);
+
+  if ((this->state.leading[index] != COOKLOG_NO_WINDOW) && (leading >= this->state.leading[index]) && (trailing >= this->state.trailing[index]))
+  {
+    // meaningful bits fit into the previous window
+    uint8_t length = 32u - this->state.leading[index] - this->state.trailing[index];
+    writeBits(0x02u, 2u);
+    writeBits(xorValue >> this->state.trailing[index], length);
+  }
+  else
+  {
+    uint8_t length = 32u - leading - trailing;
+    writeBits(0x03u, 2u);
+    writeBits(leading, 5u);
+    writeBits(length - 1u, 5u);
+    writeBits(xorValue >> trailing, length);
+    this->state.leading[index] = leading;
+    this->state.trailing[index] = trailing;
+  }
+}
+
+CookLogDecoder::CookLogDecoder(const uint8_t *block, uint16_t blockSize)
+{
+  this->block = block;
+  this->blockSize = blockSize;
+  memset(&this->header, 0, sizeof(this->header));
+  memset(&this->footer, 0, sizeof(this->footer));
+
+  // without a block the decoder is empty
+  if (block != NULL)
+  {
+    memcpy(&this->header, block, sizeof(this->header));
+    memcpy(&this->footer, &block[blockSize - sizeof(this->footer)], sizeof(this->footer));
+  }
+
+  this->state.bitPosition = COOKLOG_HEADER_BITS;
+  this->state.samples = 0u;
+  this->state.lastTime = 0u;
+  this->state.lastDelta = 0;
+}
+
+boolean CookLogDecoder::isValid()
+{
+  return (COOKLOG_MAGIC == this->header.magic) && (this->header.count <= COOKLOG_MAX_SERIES) &&
+         (this->footer.crc == CookLog::crc(this->block, this->blockSize));
+}
+
+CookLogBlockFooter CookLogDecoder::getFooter()
+{
+  return this->footer;
+}
+
+boolean CookLogDecoder::next(CookLogSample *sample)
+{
+  if (this->state.samples >= this->footer.samples)
+    return false;
+
+  if (0u == this->state.samples)
+  {
+    sample->time = readBits(32u);
+  }
+  else
+  {
+    int32_t deltaOfDelta;
+
+    if (0u == readBits(1u))
+      deltaOfDelta = 0;
+    else if (0u == readBits(1u))
+      deltaOfDelta = (int32_t)readBits(7u) - 63;
+    else if (0u == readBits(1u))
+      deltaOfDelta = (int32_t)readBits(9u) - 255;
+    else if (0u == readBits(1u))
+      deltaOfDelta = (int32_t)readBits(12u) - 2047;
+    else
+      deltaOfDelta = (int32_t)readBits(32u);
+
+    this->state.lastDelta += deltaOfDelta;
+    sample->time = this->state.lastTime + this->state.lastDelta;
+  }
+
+  this->state.lastTime = sample->time;
+  sample->unit = this->header.unit;
+  sample->count = this->header.count;
+
+  for (uint8_t i = 0u; i < this->header.count; i++)
+  {
+    FloatBits value;
+
+    if (0u == this->state.samples)
+    {
+      value.bits = readBits(32u);
+    }
+    else if (0u == readBits(1u))
+    {
+      value.bits = this->state.values[i];
+    }
+    else
+    {
+      if (1u == readBits(1u))
+      {
+        this->state.leading[i] = readBits(5u);
+        uint8_t length = readBits(5u) + 1u;
+        this->state.trailing[i] = 32u - this->state.leading[i] - length;
+      }
+
+      uint8_t length = 32u - this->state.leading[i] - this->state.trailing[i];
+      value.bits = this->state.values[i] ^ (readBits(length) << this->state.trailing[i]);
+    }
+
+    this->state.values[i] = value.bits;
+    sample->values[i] = value.value;
+  }
+
+  this->state.samples++;
+
+  return true;
+}
+
+uint32_t CookLogDecoder::readBits(uint8_t bits)
+{
+  uint32_t value = 0u;
+
+  while (bits--)
+  {
+    uint16_t position = this->state.bitPosition++;
+    value = (value << 1u) | ((this->block[position / 8u] >> (7u - (position % 8u))) & 1u);
+  }
+
+  return value;
+}
+
+uint32_t CookLog::crc(const uint8_t *block, uint16_t blockSize)
+{
+  // everything but the crc itself
+  return crc32_le(0u, block, blockSize - sizeof(uint32_t));
+}
+
+uint32_t CookLog::getBlockCount(File &file, uint16_t blockSize)
+{
+  return (file) ? (file.size() + blockSize - 1u) / blockSize : 0u;
+}
+
+boolean CookLog::readFooter(File &file, uint16_t blockSize, uint32_t blockIndex, CookLogBlockFooter *footer)
+{
+  if (!file.seek((blockIndex + 1u) * blockSize - sizeof(CookLogBlockFooter)))
+    return false;
+
+  return (file.read((uint8_t *)footer, sizeof(CookLogBlockFooter)) == sizeof(CookLogBlockFooter));
+}
+
+// binary search over the block footers, returns the first block containing samples at or after time
+int32_t CookLog::findBlock(File &file, uint16_t blockSize, uint32_t time)
+{
+  int32_t low = 0;
+  int32_t high = (int32_t)getBlockCount(file, blockSize) - 1;
+  int32_t found = -1;
+  CookLogBlockFooter footer;
+
+  while (low <= high)
+  {
+    int32_t middle = low + (high - low) / 2;
+
+    if (!readFooter(file, blockSize, middle, &footer))
+      break;
+
+    if (footer.lastTime >= time)
+    {
+      found = middle;
+      high = middle - 1;
+    }
+    else
+    {
+      low = middle + 1;
+    }
+  }
+
+  return found;
+}
+
+CookLogStream::CookLogStream(fs::FS &fs, uint16_t blockSize, uint32_t from) : decoder(NULL, 0u)
+{
+  this->fs = &fs;
+  this->fileIndex = 0u;
+  this->blockIndex = 0u;
+  this->blockCount = 0u;
+  this->blockSize = blockSize;
+  this->block = new uint8_t[blockSize];
+  this->from = from;
+  this->done = false;
+  this->pendingLength = 0u;
+  this->pendingIndex = 0u;
+}
+
+CookLogStream::~CookLogStream()
+{
+  this->file.close();
+  delete[] this->block;
+}
+
+void CookLogStream::addFile(String name)
+{
+  this->files.push_back(name);
+}
+
+size_t CookLogStream::read(uint8_t *buffer, size_t maxLen)
+{
+  size_t length = 0u;
+
+  while (length < maxLen)
+  {
+    if (this->pendingIndex >= this->pendingLength)
+    {
+      if (this->done)
+        break;
+
+      this->pendingIndex = 0u;
+      this->pendingLength = 0u;
+      produce();
+      continue;
+    }
+
+    size_t copyLength = min((size_t)(this->pendingLength - this->pendingIndex), maxLen - length);
+    memcpy(&buffer[length], &this->pending[this->pendingIndex], copyLength);
+    this->pendingIndex += copyLength;
+    length += copyLength;
+  }
+
+  return length;
+}
+
+// opens the next file that has samples at or after the start time
+boolean CookLogStream::openFile()
+{
+  while (this->fileIndex < this->files.size())
+  {
+    this->file = this->fs->open(this->files[this->fileIndex++]);
+    this->blockCount = CookLog::getBlockCount(this->file, this->blockSize);
+    int32_t first = CookLog::findBlock(this->file, this->blockSize, this->from);
+
+    if (first >= 0)
+    {
+      this->blockIndex = first;
+      return true;
+    }
+
+    this->file.close();
+  }
+
+  return false;
+}
+
+boolean CookLogStream::readBlock()
+{
+  while (this->file || openFile())
+  {
+    while (this->blockIndex < this->blockCount)
+    {
+      // the writer might be rotating or appending this file right now, a bad block is skipped
+      boolean success = this->file.seek(this->blockIndex * this->blockSize) &&
+                        (this->file.read(this->block, this->blockSize) == this->blockSize);
+      this->blockIndex++;
+
+      if (false == success)
+        break;
+
+      this->decoder = CookLogDecoder(this->block, this->blockSize);
+
+      if (this->decoder.isValid())
+        return true;
+    }
+
+    this->file.close();
+  }
+
+  return false;
+}
+
+void CookLogStream::produce()
+{
+  CookLogSample sample;
+
+  // decoder has no samples left before the first block has been read
+  while (false == this->decoder.next(&sample))
+  {
+    if (false == readBlock())
+    {
+      this->done = true;
+      return;
+    }
+  }
+
+  if (sample.time < this->from)
+    return;
+
+  int length = snprintf(this->pending, sizeof(this->pending), "%u;%c", sample.time, (char)sample.unit);
+
+  for (uint8_t i = 0u; (i < sample.count) && (length < (int)sizeof(this->pending)); i++)
+  {
+    if (INACTIVEVALUE == sample.values[i])
+      length += snprintf(&this->pending[length], sizeof(this->pending) - length, ";");
+    else
+      length += snprintf(&this->pending[length], sizeof(this->pending) - length, ";%.1f", sample.values[i]);
+  }
+
+  if (length < (int)sizeof(this->pending))
+    length += snprintf(&this->pending[length], sizeof(this->pending) - length, "\n");
+
+  this->pendingLength = min(length, (int)sizeof(this->pending) - 1);
+}
@@ -0,0 +1,145 @@
+/*************************************************** 
+    Copyright (C) 2020  Martin Koerner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    
+    HISTORY: Please refer Github History
+    
+****************************************************/
+#pragma once
+
+#include "Arduino.h"
+#include <FS.h>
+#include <vector>
+
+#define COOKLOG_MAX_SERIES 24u
+#define COOKLOG_MAGIC 0xC00Cu
+
+// All series of one point in time, e.g. channel temperatures and pitmaster values
+typedef struct
+{
+  uint32_t time;
+  uint8_t unit;
+  uint8_t count;
+  float values[COOKLOG_MAX_SERIES];
+} CookLogSample;
+
+typedef struct __attribute__((packed))
+{
+  uint16_t magic;
+  uint8_t count;
+  uint8_t unit;
+} CookLogBlockHeader;
+
+// end of every block, used as index for time range seeks
+typedef struct __attribute__((packed))
+{
+  uint32_t firstTime;
+  uint32_t lastTime;
+  uint16_t samples;
+  uint16_t usedBytes;
+  uint32_t crc;
+} CookLogBlockFooter;
+
+typedef struct
+{
+  uint16_t bitPosition;
+  uint16_t samples;
+  uint32_t firstTime;
+  uint32_t lastTime;
+  int32_t lastDelta;
+  uint32_t values[COOKLOG_MAX_SERIES];
+  uint8_t leading[COOKLOG_MAX_SERIES];
+  uint8_t trailing[COOKLOG_MAX_SERIES];
+} CookLogState;
+
+// Gorilla style compression: delta-of-delta timestamps and XOR'ed float values
+class CookLogEncoder
+{
+public:
+  CookLogEncoder(uint8_t *block, uint16_t blockSize);
+  void reset(uint8_t count, uint8_t unit);
+  boolean add(CookLogSample *sample);
+  void finish();
+  boolean isEmpty() { return (0u == this->state.samples); };
+  uint16_t getSamples() { return this->state.samples; };
+  uint16_t getUsedBytes() { return (this->state.bitPosition + 7u) / 8u; };
+
+private:
+  void writeBits(uint32_t value, uint8_t bits);
+  void writeTime(uint32_t time);
+  void writeValue(uint8_t index, float value);
+  uint8_t *block;
+  uint16_t blockSize;
+  uint16_t payloadBits;
+  uint8_t count;
+  boolean overflow;
+  CookLogState state;
+};
+
+class CookLogDecoder
+{
+public:
+  CookLogDecoder(const uint8_t *block, uint16_t blockSize);
+  boolean isValid();
+  CookLogBlockFooter getFooter();
+  boolean next(CookLogSample *sample);
+
+private:
+  uint32_t readBits(uint8_t bits);
+  const uint8_t *block;
+  uint16_t blockSize;
+  CookLogBlockHeader header;
+  CookLogBlockFooter footer;
+  CookLogState state;
+};
+
+class CookLog
+{
+public:
+  static uint32_t crc(const uint8_t *block, uint16_t blockSize);
+  static uint32_t getBlockCount(File &file, uint16_t blockSize);
+  static boolean readFooter(File &file, uint16_t blockSize, uint32_t blockIndex, CookLogBlockFooter *footer);
+  static int32_t findBlock(File &file, uint16_t blockSize, uint32_t time);
+};
+
+// CSV generator for chunked responses, one line "time;unit;value;..." per sample.
+// Files are read in the order they were added, blocks with a bad CRC are skipped.
+class CookLogStream
+{
+public:
+  CookLogStream(fs::FS &fs, uint16_t blockSize, uint32_t from);
+  ~CookLogStream();
+  void addFile(String name);
+  size_t read(uint8_t *buffer, size_t maxLen);
+
+private:
+  boolean openFile();
+  boolean readBlock();
+  void produce();
+  fs::FS *fs;
+  std::vector<String> files;
+  uint8_t fileIndex;
+  File file;
+  uint32_t blockIndex;
+  uint32_t blockCount;
+  uint16_t blockSize;
+  uint8_t *block;
+  CookLogDecoder decoder;
+  uint32_t from;
+  boolean done;
+  char pending[16u + (COOKLOG_MAX_SERIES * 8u)];
+  uint16_t pendingLength;
+  uint16_t pendingIndex;
+};
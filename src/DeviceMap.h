@@ -0,0 +1,132 @@
+/*************************************************** 
+    Copyright (C) 2020  Martin Koerner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    
+    HISTORY: Please refer Github History
+    
+****************************************************/
+#pragma once
+
+#include "Arduino.h"
+
+#define DEVICE_MAP_MAC_DIGITS 12u
+
+// Maps a 48 bit MAC address to a device with open addressing and linear probing.
+// Devices are only added, so no tombstones are needed. A slot is published by
+// writing its key last, lookups from other tasks never see a half written slot.
+template <typename T, uint8_t N>
+class DeviceMap
+{
+  static_assert((N > 0u) && ((N & (N - 1u)) == 0u), "size has to be a power of two");
+
+public:
+  DeviceMap()
+  {
+    memset(this->keys, 0, sizeof(this->keys));
+    memset(this->values, 0, sizeof(this->values));
+    this->count = 0u;
+  }
+
+  T *get(uint64_t mac)
+  {
+    if (0u == mac)
+      return NULL;
+
+    for (uint8_t probe = 0u, i = slot(mac); probe < N; probe++, i = (i + 1u) & (N - 1u))
+    {
+      if (mac == this->keys[i])
+        return this->values[i];
+
+      if (0u == this->keys[i])
+        break;
+    }
+
+    return NULL;
+  }
+
+  boolean put(uint64_t mac, T *device)
+  {
+    if ((0u == mac) || (this->count >= N))
+      return false;
+
+    for (uint8_t probe = 0u, i = slot(mac); probe < N; probe++, i = (i + 1u) & (N - 1u))
+    {
+      if (mac == this->keys[i])
+      {
+        this->values[i] = device;
+        return true;
+      }
+
+      if (0u == this->keys[i])
+      {
+        this->values[i] = device;
+        __sync_synchronize();
+        this->keys[i] = mac;
+        this->count++;
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  uint8_t size() { return this->count; }
+
+  // accepts "c4:7c:8d:6a:01:ff" in any case, with or without separators, returns 0 when invalid
+  static uint64_t parseMac(const char *address)
+  {
+    uint64_t mac = 0u;
+    uint8_t digits = 0u;
+
+    if (NULL == address)
+      return 0u;
+
+    for (; *address != '\0'; address++)
+    {
+      char c = *address;
+      uint8_t nibble;
+
+      if ((c >= '0') && (c <= '9'))
+        nibble = c - '0';
+      else if ((c >= 'a') && (c <= 'f'))
+        nibble = c - 'a' + 10u;
+      else if ((c >= 'A') && (c <= 'F'))
+        nibble = c - 'A' + 10u;
+      else if ((':' == c) || ('-' == c))
+        continue;
+      else
+        return 0u;
+
+      if (++digits > DEVICE_MAP_MAC_DIGITS)
+        return 0u;
+
+      mac = (mac << 4) | nibble;
+    }
+
+    return (DEVICE_MAP_MAC_DIGITS == digits) ? mac : 0u;
+  }
+
+private:
+  static uint8_t slot(uint64_t mac)
+  {
+    // the vendor part is often the same, fold everything into 32 bit and mix
+    uint32_t hash = (uint32_t)mac ^ (uint32_t)(mac >> 32);
+    return ((hash * 2654435761u) >> 24) & (N - 1u);
+  }
+
+  uint64_t keys[N];
+  T *values[N];
+  uint8_t count;
+};
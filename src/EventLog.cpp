@@ -0,0 +1,425 @@
+/*************************************************** 
+    Copyright (C) 2020  Martin Koerner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    
+    HISTORY: Please refer Github History
+    
+****************************************************/
+#include "EventLog.h"
+#include "TimeLib.h"
+
+#define EVENT_LOG_BENCHMARK_CALLS 5000u
+
+static const char levelNames[] = "?FEWNTV";
+
+static portMUX_TYPE taskMux = portMUX_INITIALIZER_UNLOCKED;
+
+TaskHandle_t EventLog::tasks[EVENT_LOG_MAX_TASKS] = {NULL};
+char EventLog::taskNames[EVENT_LOG_MAX_TASKS][configMAX_TASK_NAME_LEN] = {{0}};
+uint8_t EventLog::taskCount = 0u;
+
+// Print into a fixed line buffer, too long lines are cut
+class EventLogLine : public Print
+{
+public:
+  EventLogLine(char *buffer, size_t size)
+  {
+    this->buffer = buffer;
+    this->size = size;
+    this->length = 0u;
+  };
+
+  size_t write(uint8_t character)
+  {
+    if (this->length >= this->size)
+      return 0u;
+
+    this->buffer[this->length++] = character;
+    return 1u;
+  };
+
+  using Print::write;
+  size_t getLength() { return this->length; };
+
+private:
+  char *buffer;
+  size_t size;
+  size_t length;
+};
+
+EventLogRecord::EventLogRecord(LogRingBuffer *ring, uint8_t level, uint8_t task, const char *format, uint16_t dataSize)
+{
+  this->ring = ring;
+  this->dataSize = dataSize;
+  this->size = 0u;
+  this->header.size = sizeof(EventLogHeader) + dataSize;
+  this->header.level = level;
+  this->header.task = task;
+  this->header.time = millis();
+  this->header.format = format;
+  this->header.position = ring->reserve(this->header.size);
+}
+
+uint16_t EventLogRecord::getArgSize(const char *value)
+{
+  return 2u + ((NULL == value) ? 0u : min(strlen(value), (size_t)EVENT_LOG_MAX_STRING));
+}
+
+void EventLogRecord::add(const char *value)
+{
+  if (NULL == value)
+    value = "";
+
+  // strings are copied, most of them are temporary c_str() of a String
+  uint8_t arg[2] = {(uint8_t)EventLogArg::String, (uint8_t)min(strlen(value), (size_t)EVENT_LOG_MAX_STRING)};
+
+  if ((this->size + sizeof(arg) + arg[1]) > this->dataSize)
+    return;
+
+  store(arg, sizeof(arg));
+  store((const uint8_t *)value, arg[1]);
+}
+
+void EventLogRecord::store(const uint8_t *data, uint16_t length)
+{
+  this->ring->store(this->header.position + sizeof(EventLogHeader) + this->size, data, length);
+  this->size += length;
+}
+
+// the position tag is stored last, a reader only takes complete records
+void EventLogRecord::commit()
+{
+  // a string that got shorter since the size was taken leaves a gap, it is filled
+  // behind the last argument where the reader never looks
+  while (this->size < this->dataSize)
+  {
+    uint8_t fill = 0u;
+    store(&fill, 1u);
+  }
+
+  this->ring->store(this->header.position + sizeof(this->header.position), ((uint8_t *)&this->header) + sizeof(this->header.position), sizeof(EventLogHeader) - sizeof(this->header.position));
+  __sync_synchronize();
+  this->ring->store(this->header.position, (uint8_t *)&this->header.position, sizeof(this->header.position));
+}
+
+EventLog::EventLog()
+{
+  this->level = LOG_LEVEL_SILENT;
+  this->ring = NULL;
+}
+
+void EventLog::begin(int level, LogRingBuffer *ring)
+{
+  this->level = level;
+  this->ring = ring;
+}
+
+// the task is the module of a record, names are copied because tasks get deleted
+uint8_t EventLog::getTaskId()
+{
+  TaskHandle_t handle = xTaskGetCurrentTaskHandle();
+  uint8_t count = taskCount;
+
+  for (uint8_t i = 0u; i < count; i++)
+  {
+    if (tasks[i] == handle)
+      return i;
+  }
+
+  uint8_t task = EVENT_LOG_NO_TASK;
+
+  portENTER_CRITICAL(&taskMux);
+  for (uint8_t i = count; i < taskCount; i++)
+  {
+    if (tasks[i] == handle)
+      task = i;
+  }
+
+  if ((EVENT_LOG_NO_TASK == task) && (taskCount < EVENT_LOG_MAX_TASKS))
+  {
+    task = taskCount;
+    strncpy(taskNames[task], pcTaskGetTaskName(NULL), configMAX_TASK_NAME_LEN - 1u);
+    tasks[task] = handle;
+    taskCount++;
+  }
+  portEXIT_CRITICAL(&taskMux);
+
+  return task;
+}
+
+const char *EventLog::getTaskName(uint8_t task)
+{
+  return (task < taskCount) ? taskNames[task] : "?";
+}
+
+// cost of a stored record compared to formatting the same text, and of a filtered call
+void EventLog::benchmark(Print *print)
+{
+  LogRingBuffer ring;
+  EventLog eventLog;
+  char text[EVENT_LOG_LINE_SIZE];
+
+  if (false == ring.begin(LOG_BUFFER_SIZE))
+    return;
+
+  eventLog.begin(LOG_LEVEL_NOTICE, &ring);
+
+  uint32_t start = micros();
+  for (uint32_t i = 0u; i < EVENT_LOG_BENCHMARK_CALLS; i++)
+    eventLog.notice("Benchmark: %s, %d, %F" CR, "channel", i, 21.5f);
+  uint32_t recordTime = micros() - start;
+
+  start = micros();
+  for (uint32_t i = 0u; i < EVENT_LOG_BENCHMARK_CALLS; i++)
+    eventLog.verbose("Benchmark: %s, %d, %F" CR, "channel", i, 21.5f);
+  uint32_t filteredTime = micros() - start;
+
+  start = micros();
+  for (uint32_t i = 0u; i < EVENT_LOG_BENCHMARK_CALLS; i++)
+    snprintf(text, sizeof(text), "00:00:00: Benchmark: %s, %u, %.2f\n", "channel", i, 21.5f);
+  uint32_t formatTime = micros() - start;
+
+  print->printf("event log: record %u ns/call (%u bytes), filtered %u ns/call, snprintf %u ns/call (%u bytes)\n",
+                recordTime * 1000u / EVENT_LOG_BENCHMARK_CALLS,
+                ring.getEnd() / EVENT_LOG_BENCHMARK_CALLS,
+                filteredTime * 1000u / EVENT_LOG_BENCHMARK_CALLS,
+                formatTime * 1000u / EVENT_LOG_BENCHMARK_CALLS,
+                strlen(text));
+}
+
+EventLogReader::EventLogReader(LogRingBuffer *ring)
+{
+  this->ring = ring;
+  this->position = ring->getStart();
+  this->end = ring->getEnd();
+  this->dataIndex = 0u;
+  this->pendingLength = 0u;
+  this->pendingIndex = 0u;
+}
+
+size_t EventLogReader::read(uint8_t *buffer, size_t maxLen)
+{
+  size_t length = 0u;
+
+  while (length < maxLen)
+  {
+    if (this->pendingIndex >= this->pendingLength)
+    {
+      if (false == this->produce())
+        break;
+    }
+
+    size_t copyLength = min(maxLen - length, (size_t)(this->pendingLength - this->pendingIndex));
+    memcpy(&buffer[length], &this->pending[this->pendingIndex], copyLength);
+    this->pendingIndex += copyLength;
+    length += copyLength;
+  }
+
+  return length;
+}
+
+void EventLogReader::printTo(Print *print)
+{
+  while (this->produce())
+    print->write((uint8_t *)this->pending, this->pendingLength);
+}
+
+boolean EventLogReader::produce()
+{
+  this->pendingLength = 0u;
+  this->pendingIndex = 0u;
+
+  if (false == this->readRecord())
+    return false;
+
+  this->format();
+
+  return true;
+}
+
+// finds the next complete record, overwritten parts of the ring are skipped
+boolean EventLogReader::readRecord()
+{
+  size_t ringSize = this->ring->getSize();
+
+  while ((int32_t)(this->end - this->position) >= (int32_t)sizeof(EventLogHeader))
+  {
+    if ((this->ring->getEnd() - this->position) > ringSize)
+    {
+      this->position = this->ring->getStart();
+      continue;
+    }
+
+    this->ring->read(this->position, (uint8_t *)&this->header, sizeof(EventLogHeader));
+
+    if ((this->header.position != this->position) ||
+        (this->header.size < sizeof(EventLogHeader)) ||
+        (this->header.size > EVENT_LOG_MAX_RECORD) ||
+        (this->header.level < LOG_LEVEL_FATAL) ||
+        (this->header.level > LOG_LEVEL_VERBOSE))
+    {
+      this->position++;
+      continue;
+    }
+
+    this->ring->read(this->position + sizeof(EventLogHeader), this->data, this->header.size - sizeof(EventLogHeader));
+
+    // record was overwritten while it was copied
+    if ((this->ring->getEnd() - this->position) > ringSize)
+      continue;
+
+    this->position += this->header.size;
+    this->dataIndex = 0u;
+    return true;
+  }
+
+  this->position = this->end;
+  return false;
+}
+
+boolean EventLogReader::nextArg(EventLogArg *type, uint32_t *value, const char **text, uint8_t *textLength)
+{
+  uint16_t dataSize = this->header.size - sizeof(EventLogHeader);
+
+  if (this->dataIndex >= dataSize)
+    return false;
+
+  *type = (EventLogArg)this->data[this->dataIndex++];
+
+  if (EventLogArg::String == *type)
+  {
+    if (this->dataIndex >= dataSize)
+      return false;
+
+    uint8_t length = this->data[this->dataIndex++];
+    *textLength = min(length, (uint8_t)(dataSize - this->dataIndex));
+    *text = (const char *)&this->data[this->dataIndex];
+    this->dataIndex += *textLength;
+  }
+  else
+  {
+    if ((this->dataIndex + sizeof(uint32_t)) > dataSize)
+      return false;
+
+    memcpy(value, &this->data[this->dataIndex], sizeof(uint32_t));
+    this->dataIndex += sizeof(uint32_t);
+  }
+
+  return true;
+}
+
+// same format specifiers as ArduinoLog
+void EventLogReader::format()
+{
+  EventLogLine line(this->pending, sizeof(this->pending));
+  time_t t = now();
+
+  if (year(t) > 2000)
+  {
+    t -= (millis() - this->header.time) / 1000u;
+    line.printf("%02d:%02d:%02d: ", hour(t), minute(t), second(t));
+  }
+  else
+  {
+    line.printf("%u.%03u: ", this->header.time / 1000u, this->header.time % 1000u);
+  }
+
+  line.printf("%c %s: ", levelNames[this->header.level], EventLog::getTaskName(this->header.task));
+
+  for (const char *c = this->header.format; *c != '\0'; c++)
+  {
+    if (*c != '%')
+    {
+      line.write(*c);
+      continue;
+    }
+
+    if (*(++c) == '\0')
+      break;
+
+    if ('%' == *c)
+    {
+      line.write('%');
+      continue;
+    }
+
+    EventLogArg type;
+    uint32_t value = 0u;
+    const char *text = "";
+    uint8_t textLength = 0u;
+    float floatValue;
+
+    if (false == this->nextArg(&type, &value, &text, &textLength))
+    {
+      line.write('?');
+      continue;
+    }
+
+    memcpy(&floatValue, &value, sizeof(floatValue));
+
+    if (EventLogArg::String == type)
+    {
+      line.write((const uint8_t *)text, textLength);
+      continue;
+    }
+
+    switch (*c)
+    {
+    case 'c':
+      line.write((char)value);
+      break;
+    case 'x':
+      line.print(value, HEX);
+      break;
+    case 'X':
+      line.print("0x");
+      line.print(value, HEX);
+      break;
+    case 'b':
+      line.print(value, BIN);
+      break;
+    case 'B':
+      line.print("0b");
+      line.print(value, BIN);
+      break;
+    case 't':
+      line.write((value != 0u) ? 'T' : 'F');
+      break;
+    case 'T':
+      line.print((value != 0u) ? "true" : "false");
+      break;
+    default:
+      if (EventLogArg::Float == type)
+        line.print(floatValue);
+      else if (EventLogArg::Int == type)
+        line.print((int32_t)value);
+      else
+        line.print(value);
+      break;
+    }
+  }
+
+  this->pendingLength = line.getLength();
+
+  if ((this->pendingLength > 0u) && (this->pending[this->pendingLength - 1u] != '\n'))
+  {
+    if (this->pendingLength == sizeof(this->pending))
+      this->pendingLength--;
+
+    this->pending[this->pendingLength++] = '\n';
+  }
+}
+
+EventLog Log;
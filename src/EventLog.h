@@ -0,0 +1,187 @@
+/*************************************************** 
+    Copyright (C) 2020  Martin Koerner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    
+    HISTORY: Please refer Github History
+    
+****************************************************/
+#pragma once
+
+#include <Arduino.h>
+#include <type_traits>
+#include "LogRingBuffer.h"
+
+#define CR "\n"
+
+#define LOG_LEVEL_SILENT 0
+#define LOG_LEVEL_FATAL 1
+#define LOG_LEVEL_ERROR 2
+#define LOG_LEVEL_WARNING 3
+#define LOG_LEVEL_NOTICE 4
+#define LOG_LEVEL_TRACE 5
+#define LOG_LEVEL_VERBOSE 6
+
+#define EVENT_LOG_MAX_RECORD 128u
+#define EVENT_LOG_MAX_DATA (EVENT_LOG_MAX_RECORD - sizeof(EventLogHeader))
+#define EVENT_LOG_MAX_STRING 48u
+#define EVENT_LOG_MAX_TASKS 16u
+#define EVENT_LOG_NO_TASK 0xFFu
+#define EVENT_LOG_LINE_SIZE 192u
+
+// Every record starts with its own absolute ring position, so a reader
+// detects records that were overwritten and finds the next valid one.
+typedef struct
+{
+  uint32_t position;
+  uint16_t size;
+  uint8_t level;
+  uint8_t task;
+  uint32_t time;
+  const char *format;
+} EventLogHeader;
+
+enum class EventLogArg : uint8_t
+{
+  Int,
+  UInt,
+  Float,
+  String
+};
+
+// Writes the arguments straight into the reserved ring slot, so a log call
+// needs only the header and one argument on the stack of the calling task.
+class EventLogRecord
+{
+public:
+  EventLogRecord(LogRingBuffer *ring, uint8_t level, uint8_t task, const char *format, uint16_t dataSize);
+  void add(const char *value);
+  void add(const String &value) { add(value.c_str()); };
+  template <typename T>
+  typename std::enable_if<std::is_floating_point<T>::value>::type add(T value) { addValue(EventLogArg::Float, (float)value); };
+  template <typename T>
+  typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value>::type add(T value) { addValue(EventLogArg::Int, (int32_t)value); };
+  template <typename T>
+  typename std::enable_if<(std::is_integral<T>::value && !std::is_signed<T>::value) || std::is_enum<T>::value>::type add(T value) { addValue(EventLogArg::UInt, (uint32_t)value); };
+  void commit();
+  static uint16_t getArgSize(const char *value);
+  static uint16_t getArgSize(const String &value) { return getArgSize(value.c_str()); };
+  template <typename T>
+  static typename std::enable_if<std::is_arithmetic<T>::value || std::is_enum<T>::value, uint16_t>::type getArgSize(T value) { return 1u + sizeof(uint32_t); };
+
+private:
+  template <typename T>
+  void addValue(EventLogArg type, T value)
+  {
+    uint8_t arg[1u + sizeof(T)];
+
+    if ((this->size + sizeof(arg)) > this->dataSize)
+      return;
+
+    arg[0] = (uint8_t)type;
+    memcpy(&arg[1], &value, sizeof(T));
+    store(arg, sizeof(arg));
+  };
+  void store(const uint8_t *data, uint16_t length);
+  LogRingBuffer *ring;
+  EventLogHeader header;
+  uint16_t dataSize;
+  uint16_t size;
+};
+
+// Binary event log with the interface of ArduinoLog. A call only stores the
+// format pointer and the raw arguments into the ring, the text is formatted
+// when the log is read by /log or the serial console.
+class EventLog
+{
+public:
+  EventLog();
+  void begin(int level, LogRingBuffer *ring);
+  void setLevel(int level) { this->level = level; };
+  int getLevel() { return this->level; };
+  template <typename... Args>
+  void fatal(const char *format, Args... args) { this->add(LOG_LEVEL_FATAL, format, args...); };
+  template <typename... Args>
+  void error(const char *format, Args... args) { this->add(LOG_LEVEL_ERROR, format, args...); };
+  template <typename... Args>
+  void warning(const char *format, Args... args) { this->add(LOG_LEVEL_WARNING, format, args...); };
+  template <typename... Args>
+  void notice(const char *format, Args... args) { this->add(LOG_LEVEL_NOTICE, format, args...); };
+  template <typename... Args>
+  void trace(const char *format, Args... args) { this->add(LOG_LEVEL_TRACE, format, args...); };
+  template <typename... Args>
+  void verbose(const char *format, Args... args) { this->add(LOG_LEVEL_VERBOSE, format, args...); };
+  static const char *getTaskName(uint8_t task);
+  static void benchmark(Print *print);
+
+private:
+  template <typename... Args>
+  void add(int level, const char *format, Args... args)
+  {
+    // filtered records cost one compare
+    if ((level > this->level) || (NULL == this->ring))
+      return;
+
+    EventLogRecord record(this->ring, level, getTaskId(), format, getArgsSize(0u, args...));
+    addArgs(record, args...);
+    record.commit();
+  };
+  static uint16_t getArgsSize(uint16_t size) { return size; };
+  template <typename T, typename... Args>
+  static uint16_t getArgsSize(uint16_t size, T value, Args... args)
+  {
+    uint16_t argSize = EventLogRecord::getArgSize(value);
+    // an argument that does not fit is dropped, EventLogRecord::add() skips the same ones
+    return getArgsSize(((size + argSize) <= EVENT_LOG_MAX_DATA) ? (size + argSize) : size, args...);
+  };
+  void addArgs(EventLogRecord &record){};
+  template <typename T, typename... Args>
+  void addArgs(EventLogRecord &record, T value, Args... args)
+  {
+    record.add(value);
+    addArgs(record, args...);
+  };
+  static uint8_t getTaskId();
+  int level;
+  LogRingBuffer *ring;
+  static TaskHandle_t tasks[EVENT_LOG_MAX_TASKS];
+  static char taskNames[EVENT_LOG_MAX_TASKS][configMAX_TASK_NAME_LEN];
+  static uint8_t taskCount;
+};
+
+// Formats the records of a ring into text lines, used for chunked responses
+class EventLogReader
+{
+public:
+  EventLogReader(LogRingBuffer *ring);
+  size_t read(uint8_t *buffer, size_t maxLen);
+  void printTo(Print *print);
+
+private:
+  boolean produce();
+  boolean readRecord();
+  void format();
+  boolean nextArg(EventLogArg *type, uint32_t *value, const char **text, uint8_t *textLength);
+  LogRingBuffer *ring;
+  uint32_t position;
+  uint32_t end;
+  EventLogHeader header;
+  uint8_t data[EVENT_LOG_MAX_DATA];
+  uint16_t dataIndex;
+  char pending[EVENT_LOG_LINE_SIZE];
+  uint16_t pendingLength;
+  uint16_t pendingIndex;
+};
+
+extern EventLog Log;
@@ -0,0 +1,243 @@
+/*************************************************** 
+    Copyright (C) 2020  Martin Koerner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    
+    HISTORY: Please refer Github History
+    
+****************************************************/
+#include "JsonWriter.h"
+
+JsonWriter::JsonWriter(Print *print) : ApiWriter(print)
+{
+  this->depth = 0u;
+  this->hasValue = 0u;
+}
+
+void JsonWriter::beginObject(const char *key)
+{
+  beginValue(key);
+  writeRaw('{');
+
+  if (this->depth < JSON_WRITER_MAX_DEPTH)
+    this->depth++;
+
+  this->hasValue &= ~(1u << (this->depth - 1u));
+}
+
+void JsonWriter::endObject()
+{
+  if (this->depth > 0u)
+    this->depth--;
+
+  writeRaw('}');
+}
+
+void JsonWriter::beginArray(const char *key)
+{
+  beginValue(key);
+  writeRaw('[');
+
+  if (this->depth < JSON_WRITER_MAX_DEPTH)
+    this->depth++;
+
+  this->hasValue &= ~(1u << (this->depth - 1u));
+}
+
+void JsonWriter::endArray()
+{
+  if (this->depth > 0u)
+    this->depth--;
+
+  writeRaw(']');
+}
+
+void JsonWriter::addString(const char *key, const char *value)
+{
+  beginValue(key);
+
+  if (NULL == value)
+  {
+    writeRaw("null");
+    return;
+  }
+
+  writeRaw('"');
+  writeEscaped(value);
+  writeRaw('"');
+}
+
+void JsonWriter::addInt(const char *key, int32_t value)
+{
+  beginValue(key);
+
+  if (value < 0)
+  {
+    writeRaw('-');
+    writeUInt((uint32_t)(-(value + 1)) + 1u);
+  }
+  else
+    writeUInt((uint32_t)value);
+}
+
+void JsonWriter::addUInt(const char *key, uint32_t value)
+{
+  beginValue(key);
+  writeUInt(value);
+}
+
+void JsonWriter::addBool(const char *key, boolean value)
+{
+  beginValue(key);
+  writeRaw(value ? "true" : "false");
+}
+
+// Same fixed point output as ArduinoJson, digits are rounded and always printed
+void JsonWriter::addFloat(const char *key, float value, uint8_t digits)
+{
+  beginValue(key);
+
+  if (isnan(value) || isinf(value))
+  {
+    writeRaw("null");
+    return;
+  }
+
+  if (value < 0.0f)
+  {
+    writeRaw('-');
+    value = -value;
+  }
+
+  float rounding = 0.5f;
+  for (uint8_t i = 0u; i < digits; i++)
+    rounding /= 10.0f;
+
+  value += rounding;
+
+  uint32_t integerPart = (uint32_t)value;
+  float remainder = value - (float)integerPart;
+  writeUInt(integerPart);
+
+  if (digits > 0u)
+    writeRaw('.');
+
+  while (digits-- > 0u)
+  {
+    remainder *= 10.0f;
+    uint8_t digit = (uint8_t)remainder;
+    writeRaw((char)('0' + digit));
+    remainder -= (float)digit;
+  }
+}
+
+void JsonWriter::addNull(const char *key)
+{
+  beginValue(key);
+  writeRaw("null");
+}
+
+void JsonWriter::beginValue(const char *key)
+{
+  if (this->depth > 0u)
+  {
+    uint16_t mask = 1u << (this->depth - 1u);
+
+    if (this->hasValue & mask)
+      writeRaw(',');
+
+    this->hasValue |= mask;
+  }
+
+  if (key != NULL)
+  {
+    writeRaw('"');
+    writeEscaped(key);
+    writeRaw("\":");
+  }
+}
+
+void JsonWriter::writeRaw(const char *str)
+{
+  writeBytes((const uint8_t *)str, strlen(str));
+}
+
+void JsonWriter::writeRaw(char c)
+{
+  writeBytes((const uint8_t *)&c, 1u);
+}
+
+void JsonWriter::writeEscaped(const char *str)
+{
+  const char *start = str;
+
+  for (; *str != '\0'; str++)
+  {
+    char escaped;
+
+    switch (*str)
+    {
+    case '"':
+      escaped = '"';
+      break;
+    case '\\':
+      escaped = '\\';
+      break;
+    case '\b':
+      escaped = 'b';
+      break;
+    case '\f':
+      escaped = 'f';
+      break;
+    case '\n':
+      escaped = 'n';
+      break;
+    case '\r':
+      escaped = 'r';
+      break;
+    case '\t':
+      escaped = 't';
+      break;
+    default:
+      continue;
+    }
+
+    // write the unescaped run at once
+    if (str > start)
+      writeBytes((const uint8_t *)start, str - start);
+
+    writeRaw('\\');
+    writeRaw(escaped);
+    start = str + 1;
+  }
+
+  if (str > start)
+    writeBytes((const uint8_t *)start, str - start);
+}
+
+void JsonWriter::writeUInt(uint32_t value)
+{
+  char buffer[11];
+  uint8_t index = sizeof(buffer) - 1u;
+
+  buffer[index] = '\0';
+
+  do
+  {
+    buffer[--index] = (char)('0' + (value % 10u));
+    value /= 10u;
+  } while (value > 0u);
+
+  writeRaw(&buffer[index]);
+}
@@ -0,0 +1,64 @@
+/*************************************************** 
+    Copyright (C) 2020  Martin Koerner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    
+    HISTORY: Please refer Github History
+    
+****************************************************/
+#pragma once
+
+#include <Arduino.h>
+#include "ApiWriter.h"
+
+#define JSON_WRITER_MAX_DEPTH 16u
+
+// Minimal JSON generator that prints straight into a Print target.
+// No document is built in RAM, the caller is responsible for a valid structure.
+class JsonWriter : public ApiWriter
+{
+public:
+  JsonWriter(Print *print = NULL);
+  using ApiWriter::addString;
+  void beginObject(const char *key = NULL);
+  void endObject();
+  void beginArray(const char *key = NULL);
+  void endArray();
+  void addString(const char *key, const char *value);
+  void addInt(const char *key, int32_t value);
+  void addUInt(const char *key, uint32_t value);
+  void addBool(const char *key, boolean value);
+  void addFloat(const char *key, float value, uint8_t digits = 2u);
+  void addNull(const char *key);
+
+private:
+  void beginValue(const char *key);
+  void writeRaw(const char *str);
+  void writeRaw(char c);
+  void writeEscaped(const char *str);
+  void writeUInt(uint32_t value);
+  uint8_t depth;
+  uint16_t hasValue;
+};
+
+// Appends to a String, reserve it before to avoid reallocations
+class JsonStringPrint : public Print
+{
+public:
+  JsonStringPrint(String *str) { this->str = str; };
+  size_t write(uint8_t c) { return this->str->concat((char)c) ? 1u : 0u; };
+
+private:
+  String *str;
+};
@@ -19,59 +19,172 @@
 ****************************************************/
 #include "LogRingBuffer.h"
 
-LogRingBuffer::LogRingBuffer()
+#define LOG_BENCHMARK_WRITES 20000u
+
+typedef struct
+{
+  LogRingBuffer *ring;
+  uint32_t time;
+  SemaphoreHandle_t done;
+} LogBenchmarkType;
+
+LogRingBuffer::LogRingBuffer() : head(0u)
 {
-  bufferIndex = 0u;
-  isFull = false;
+  this->buffer = NULL;
+  this->bufferSize = 0u;
+  this->psram = false;
+  this->isFull = false;
 }
 
 LogRingBuffer::~LogRingBuffer()
 {
-  if (buffer != NULL)
-  {
-    delete (buffer);
-  }
+  free(this->buffer);
+}
+
+boolean LogRingBuffer::begin(size_t size)
+{
+  if (this->buffer != NULL)
+    return true;
+
+  this->psram = psramFound();
+
+  if (0u == size)
+    size = (this->psram) ? LOG_BUFFER_SIZE_PSRAM : LOG_BUFFER_SIZE;
+
+  // power of two, positions are masked
+  while (size & (size - 1u))
+    size &= (size - 1u);
+
+  uint8_t *newBuffer = (uint8_t *)((this->psram) ? ps_malloc(size) : malloc(size));
+
+  if (NULL == newBuffer)
+    return false;
+
+  this->bufferSize = size;
+  this->buffer = newBuffer;
+
+  return true;
 }
 
 size_t LogRingBuffer::write(uint8_t character)
 {
-  buffer[bufferIndex++] = character;
+  return write(&character, 1u);
+}
+
+size_t LogRingBuffer::write(const uint8_t *data, size_t size)
+{
+  if ((NULL == this->buffer) || (0u == size))
+    return 0u;
 
-  // Check for overflow
-  if (bufferIndex >= LOG_BUFFER_SIZE)
+  uint32_t position = this->reserve(size);
+
+  // only the last part of a huge write fits into the ring
+  if (size > this->bufferSize)
   {
-    bufferIndex = 0u;
-    isFull = true;
+    position += size - this->bufferSize;
+    data += size - this->bufferSize;
+    size = this->bufferSize;
   }
+
+  this->store(position, data, size);
+
+  return size;
 }
 
-String LogRingBuffer::get()
+// reserves size bytes at the end of the ring, returns the absolute position
+uint32_t LogRingBuffer::reserve(size_t size)
 {
-  String logString;
+  uint32_t position = this->head.fetch_add(size);
 
-  if ((false == isFull))
-  {
-    for (size_t i = 0u; i < bufferIndex; i++)
-    {
-      logString += buffer[i];
-    }
-  }
-  else
-  {
-    for (size_t i = 0; i < LOG_BUFFER_SIZE; i++)
-    {
-      size_t index = bufferIndex + i;
+  if ((position + size) >= this->bufferSize)
+    this->isFull = true;
 
-      if (index >= LOG_BUFFER_SIZE)
-      {
-        index -= LOG_BUFFER_SIZE;
-      }
+  return position;
+}
 
-      logString += buffer[index];
-    }
-  }
+// copies data to a reserved position, in max. two contiguous parts
+void LogRingBuffer::store(uint32_t position, const uint8_t *data, size_t size)
+{
+  if (NULL == this->buffer)
+    return;
+
+  size_t mask = this->bufferSize - 1u;
+  size_t index = position & mask;
+
+  size = min(size, this->bufferSize);
+  size_t firstPart = min(size, this->bufferSize - index);
+
+  memcpy(&this->buffer[index], data, firstPart);
+  memcpy(this->buffer, &data[firstPart], size - firstPart);
+}
+
+uint32_t LogRingBuffer::getStart()
+{
+  uint32_t end = this->head;
+
+  return (this->isFull) ? (end - this->bufferSize) : 0u;
+}
+
+// copies the ring from position, in max. two contiguous parts
+size_t LogRingBuffer::read(uint32_t position, uint8_t *data, size_t size)
+{
+  if (NULL == this->buffer)
+    return 0u;
+
+  size_t mask = this->bufferSize - 1u;
+  size_t index = position & mask;
+
+  size = min(size, this->bufferSize);
+  size_t firstPart = min(size, this->bufferSize - index);
+
+  memcpy(data, &this->buffer[index], firstPart);
+  memcpy(&data[firstPart], this->buffer, size - firstPart);
+
+  return size;
+}
+
+void LogRingBuffer::benchmarkTask(void *parameter)
+{
+  LogBenchmarkType *benchmark = (LogBenchmarkType *)parameter;
+  uint32_t start = micros();
+
+  for (uint32_t i = 0u; i < LOG_BENCHMARK_WRITES; i++)
+    benchmark->ring->write('0');
+
+  benchmark->time = micros() - start;
+  xSemaphoreGive(benchmark->done);
+  vTaskDelete(NULL);
+}
+
+// append cost of a single writer and of writers on both cores at the same time
+void LogRingBuffer::benchmark(Print *print)
+{
+  LogRingBuffer ring;
+
+  if (false == ring.begin(LOG_BUFFER_SIZE))
+    return;
+
+  uint32_t start = micros();
+  for (uint32_t i = 0u; i < LOG_BENCHMARK_WRITES; i++)
+    ring.write('1');
+  uint32_t singleTime = micros() - start;
+
+  LogBenchmarkType benchmark = {&ring, 0u, xSemaphoreCreateBinary()};
+  xTaskCreatePinnedToCore(LogRingBuffer::benchmarkTask, "LogBenchmark", 2048, &benchmark, uxTaskPriorityGet(NULL), NULL, 0);
+
+  start = micros();
+  for (uint32_t i = 0u; i < LOG_BENCHMARK_WRITES; i++)
+    ring.write('1');
+  uint32_t contendedTime = micros() - start;
+
+  xSemaphoreTake(benchmark.done, portMAX_DELAY);
+  vSemaphoreDelete(benchmark.done);
 
-  return logString;
+  print->printf("log ring (%u bytes, %s): single %u ns/write, contended core 1 %u ns/write, core 0 %u ns/write\n",
+                ring.getSize(), ring.psram ? "psram" : "internal",
+                singleTime * 1000u / LOG_BENCHMARK_WRITES,
+                contendedTime * 1000u / LOG_BENCHMARK_WRITES,
+                benchmark.time * 1000u / LOG_BENCHMARK_WRITES);
 }
 
 LogRingBuffer gLogRingBuffer;
\ No newline at end of file
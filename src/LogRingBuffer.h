@@ -20,21 +20,43 @@
 #pragma once
 
 #include <Arduino.h>
+#include <atomic>
 
+// size in byte, rounded down to a power of two
+#ifndef LOG_BUFFER_SIZE
 #define LOG_BUFFER_SIZE 2048u
+#endif
 
+#ifndef LOG_BUFFER_SIZE_PSRAM
+#define LOG_BUFFER_SIZE_PSRAM 32768u
+#endif
+
+// Ring buffer for the log output of all tasks. Writers reserve their
+// position with an atomic counter, so no lock is needed on both cores.
+// Readers copy directly out of the ring, a position that is overwritten
+// while it is read just returns newer log text.
 class LogRingBuffer : public Print
 {
 public:
   LogRingBuffer();
   ~LogRingBuffer();
+  boolean begin(size_t size = 0u);
   size_t write(uint8_t character);
-  String get();
+  size_t write(const uint8_t *data, size_t size);
+  uint32_t reserve(size_t size);
+  void store(uint32_t position, const uint8_t *data, size_t size);
+  size_t getSize() { return this->bufferSize; };
+  uint32_t getEnd() { return this->head; };
+  uint32_t getStart();
+  size_t read(uint32_t position, uint8_t *data, size_t size);
+  static void benchmark(Print *print);
 
 private:
-  char buffer[LOG_BUFFER_SIZE];
+  static void benchmarkTask(void *parameter);
+  uint8_t *buffer;
   size_t bufferSize;
-  size_t bufferIndex;
+  boolean psram;
+  std::atomic<uint32_t> head;
   boolean isFull;
 };
 
@@ -0,0 +1,350 @@
+/*************************************************** 
+    Copyright (C) 2020  Martin Koerner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    
+    HISTORY: Please refer Github History
+    
+****************************************************/
+#include "Metrics.h"
+#include "system/SystemBase.h"
+#include "ApiCache.h"
+#include "TaskMonitor.h"
+#include "BusLock.h"
+#include "Version.h"
+#include "EventLog.h"
+#include <esp_heap_caps.h>
+
+static const char *pitmasterTypes[] = {"off", "manual", "auto"};
+
+MetricsWriter::MetricsWriter(Print *print)
+{
+  this->print = print;
+  this->hasLabel = false;
+}
+
+void MetricsWriter::family(const char *name, const char *type, const char *help)
+{
+  this->print->printf("# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+MetricsWriter &MetricsWriter::sample(const char *name)
+{
+  this->print->print(name);
+  this->hasLabel = false;
+  return *this;
+}
+
+MetricsWriter &MetricsWriter::label(const char *key, const char *value)
+{
+  this->print->write(this->hasLabel ? ',' : '{');
+  this->print->print(key);
+  this->print->print("=\"");
+
+  // channel names are user input
+  for (const char *c = value; *c != '\0'; c++)
+  {
+    if (('\\' == *c) || ('"' == *c))
+      this->print->write('\\');
+
+    if ('\n' == *c)
+      this->print->print("\\n");
+    else
+      this->print->write(*c);
+  }
+
+  this->print->write('"');
+  this->hasLabel = true;
+  return *this;
+}
+
+MetricsWriter &MetricsWriter::label(const char *key, uint32_t value)
+{
+  this->print->printf("%c%s=\"%u\"", this->hasLabel ? ',' : '{', key, value);
+  this->hasLabel = true;
+  return *this;
+}
+
+void MetricsWriter::endLabels()
+{
+  this->print->print(this->hasLabel ? "} " : " ");
+}
+
+void MetricsWriter::value(uint32_t value)
+{
+  this->endLabels();
+  this->print->printf("%u\n", value);
+}
+
+void MetricsWriter::value(int32_t value)
+{
+  this->endLabels();
+  this->print->printf("%d\n", value);
+}
+
+void MetricsWriter::value(float value)
+{
+  this->endLabels();
+
+  if (isnan(value))
+    this->print->print("NaN");
+  else if (isinf(value))
+    this->print->print((value > 0.0f) ? "+Inf" : "-Inf");
+  else
+    this->print->print(value, 2);
+
+  this->print->write('\n');
+}
+
+static void systemMetrics(MetricsWriter &writer)
+{
+  writer.family("wlanthermo_info", "gauge", "Firmware and device information");
+  writer.sample("wlanthermo_info").label("version", FIRMWAREVERSION).label("serial", SystemBase::getSerialNumber().c_str()).label("hardware", (uint32_t)gSystem->getHardwareVersion()).value((uint32_t)1u);
+
+  writer.family("wlanthermo_uptime_seconds", "counter", "Time since start");
+  writer.sample("wlanthermo_uptime_seconds").value((uint32_t)(esp_timer_get_time() / 1000000));
+
+  writer.family("wlanthermo_heap_free_bytes", "gauge", "Free internal heap");
+  writer.sample("wlanthermo_heap_free_bytes").value((uint32_t)ESP.getFreeHeap());
+
+  writer.family("wlanthermo_heap_min_free_bytes", "gauge", "Lowest free internal heap since start");
+  writer.sample("wlanthermo_heap_min_free_bytes").value((uint32_t)ESP.getMinFreeHeap());
+
+  writer.family("wlanthermo_heap_largest_block_bytes", "gauge", "Largest free internal heap block");
+  writer.sample("wlanthermo_heap_largest_block_bytes").value((uint32_t)heap_caps_get_largest_free_block(MALLOC_CAP_8BIT | MALLOC_CAP_INTERNAL));
+
+  if (psramFound())
+  {
+    writer.family("wlanthermo_psram_free_bytes", "gauge", "Free PSRAM");
+    writer.sample("wlanthermo_psram_free_bytes").value((uint32_t)ESP.getFreePsram());
+  }
+
+  writer.family("wlanthermo_wifi_connected", "gauge", "WiFi station connected");
+  writer.sample("wlanthermo_wifi_connected").value((uint32_t)gSystem->wlan.isConnected());
+
+  if (gSystem->wlan.isConnected())
+  {
+    writer.family("wlanthermo_wifi_rssi_dbm", "gauge", "WiFi signal strength");
+    writer.sample("wlanthermo_wifi_rssi_dbm").value((int32_t)gSystem->wlan.getRssi());
+  }
+
+  if (gSystem->battery != NULL)
+  {
+    writer.family("wlanthermo_battery_percent", "gauge", "Battery charge");
+    writer.sample("wlanthermo_battery_percent").value((int32_t)gSystem->battery->percentage);
+
+    writer.family("wlanthermo_battery_millivolts", "gauge", "Filtered battery voltage");
+    writer.sample("wlanthermo_battery_millivolts").value((int32_t)gSystem->battery->voltage);
+
+    writer.family("wlanthermo_usb_powered", "gauge", "USB supply connected");
+    writer.sample("wlanthermo_usb_powered").value((uint32_t)gSystem->battery->isUsbPowered());
+  }
+}
+
+static void temperatureMetrics(MetricsWriter &writer)
+{
+  TemperatureGrp &temperatures = gSystem->temperatures;
+  const char *unit = (TemperatureUnit::Fahrenheit == temperatures.getUnit()) ? "F" : "C";
+
+  writer.family("wlanthermo_channel_connected", "gauge", "Sensor connected to the channel");
+  for (uint8_t i = 0u; i < temperatures.count(); i++)
+  {
+    if (temperatures[i] != NULL)
+      writer.sample("wlanthermo_channel_connected").label("channel", (uint32_t)(i + 1u)).value((uint32_t)temperatures[i]->isActive());
+  }
+
+  writer.family("wlanthermo_channel_temperature", "gauge", "Channel temperature, connected channels only");
+  for (uint8_t i = 0u; i < temperatures.count(); i++)
+  {
+    TemperatureBase *temperature = temperatures[i];
+
+    if ((temperature != NULL) && temperature->isActive())
+      writer.sample("wlanthermo_channel_temperature").label("channel", (uint32_t)(i + 1u)).label("name", temperature->getName().c_str()).label("unit", unit).value(temperature->getValue());
+  }
+
+  writer.family("wlanthermo_channel_alarm_limit", "gauge", "Channel alarm limits");
+  for (uint8_t i = 0u; i < temperatures.count(); i++)
+  {
+    TemperatureBase *temperature = temperatures[i];
+
+    if (temperature != NULL)
+    {
+      writer.sample("wlanthermo_channel_alarm_limit").label("channel", (uint32_t)(i + 1u)).label("limit", "min").value(temperature->getMinValue());
+      writer.sample("wlanthermo_channel_alarm_limit").label("channel", (uint32_t)(i + 1u)).label("limit", "max").value(temperature->getMaxValue());
+    }
+  }
+}
+
+static void pitmasterMetrics(MetricsWriter &writer)
+{
+  PitmasterGrp &pitmasters = gSystem->pitmasters;
+
+  writer.family("wlanthermo_pitmaster_value_percent", "gauge", "Pitmaster output");
+  for (uint8_t i = 0u; i < pitmasters.count(); i++)
+  {
+    if (pitmasters[i] != NULL)
+      writer.sample("wlanthermo_pitmaster_value_percent").label("pitmaster", (uint32_t)i).value(pitmasters[i]->getValue());
+  }
+
+  writer.family("wlanthermo_pitmaster_target_temperature", "gauge", "Pitmaster set point");
+  for (uint8_t i = 0u; i < pitmasters.count(); i++)
+  {
+    if (pitmasters[i] != NULL)
+      writer.sample("wlanthermo_pitmaster_target_temperature").label("pitmaster", (uint32_t)i).value(pitmasters[i]->getTargetTemperature());
+  }
+
+  writer.family("wlanthermo_pitmaster_mode", "gauge", "Active pitmaster mode");
+  for (uint8_t i = 0u; i < pitmasters.count(); i++)
+  {
+    if (pitmasters[i] != NULL)
+    {
+      PitmasterType type = pitmasters[i]->getType();
+
+      for (uint8_t t = pm_off; t <= pm_auto; t++)
+        writer.sample("wlanthermo_pitmaster_mode").label("pitmaster", (uint32_t)i).label("mode", pitmasterTypes[t]).value((uint32_t)(t == type));
+    }
+  }
+
+  writer.family("wlanthermo_pitmaster_pid_term", "gauge", "Parts of the last PID output");
+  for (uint8_t i = 0u; i < pitmasters.count(); i++)
+  {
+    if (pitmasters[i] != NULL)
+    {
+      PitmasterPidTerms terms = pitmasters[i]->getPidTerms();
+      writer.sample("wlanthermo_pitmaster_pid_term").label("pitmaster", (uint32_t)i).label("term", "p").value(terms.p);
+      writer.sample("wlanthermo_pitmaster_pid_term").label("pitmaster", (uint32_t)i).label("term", "i").value(terms.i);
+      writer.sample("wlanthermo_pitmaster_pid_term").label("pitmaster", (uint32_t)i).label("term", "d").value(terms.d);
+    }
+  }
+}
+
+static void connectMetrics(MetricsWriter &writer)
+{
+  CloudStats cloudStats = Cloud::getStats();
+  MqttStats mqttStats = Mqtt::getStats();
+
+  writer.family("wlanthermo_cloud_queue_depth", "gauge", "Cloud requests waiting to be sent");
+  writer.sample("wlanthermo_cloud_queue_depth").value(Cloud::getQueueDepth());
+
+  writer.family("wlanthermo_cloud_requests_total", "counter", "Cloud requests sent");
+  writer.sample("wlanthermo_cloud_requests_total").value(cloudStats.requests);
+
+  writer.family("wlanthermo_cloud_errors_total", "counter", "Failed cloud requests");
+  writer.sample("wlanthermo_cloud_errors_total").label("reason", "http").value(cloudStats.httpErrors);
+  writer.sample("wlanthermo_cloud_errors_total").label("reason", "queue_full").value(cloudStats.queueFull);
+
+  writer.family("wlanthermo_cloud_uploads_total", "counter", "Scheduled uploads by stream");
+  writer.sample("wlanthermo_cloud_uploads_total").label("stream", "cloud").value(gSystem->cloud.getCloudScheduler()->getUploads());
+  writer.sample("wlanthermo_cloud_uploads_total").label("stream", "custom").value(gSystem->cloud.getCustomScheduler()->getUploads());
+
+  writer.family("wlanthermo_cloud_interval_seconds", "gauge", "Current upload interval by stream, adaptive between floor and ceiling");
+  writer.sample("wlanthermo_cloud_interval_seconds").label("stream", "cloud").value((uint32_t)gSystem->cloud.getCloudScheduler()->getInterval());
+  writer.sample("wlanthermo_cloud_interval_seconds").label("stream", "custom").value((uint32_t)gSystem->cloud.getCustomScheduler()->getInterval());
+
+  CloudBufferStats bufferStats = gSystem->cloud.getBuffer()->getStats();
+
+  writer.family("wlanthermo_cloud_buffer_samples", "gauge", "Cloud samples waiting for upload in RAM and on SPIFFS");
+  writer.sample("wlanthermo_cloud_buffer_samples").value(gSystem->cloud.getBuffer()->getCount());
+
+  writer.family("wlanthermo_cloud_buffer_samples_total", "counter", "Cloud samples by buffer event");
+  writer.sample("wlanthermo_cloud_buffer_samples_total").label("event", "added").value(bufferStats.added);
+  writer.sample("wlanthermo_cloud_buffer_samples_total").label("event", "sent").value(bufferStats.sent);
+  writer.sample("wlanthermo_cloud_buffer_samples_total").label("event", "duplicate").value(bufferStats.duplicates);
+  writer.sample("wlanthermo_cloud_buffer_samples_total").label("event", "dropped").value(bufferStats.dropped);
+
+  writer.family("wlanthermo_cloud_buffer_spilled_bytes_total", "counter", "Bytes moved from RAM to SPIFFS");
+  writer.sample("wlanthermo_cloud_buffer_spilled_bytes_total").value(bufferStats.spilledBytes);
+
+  writer.family("wlanthermo_cloud_connections_total", "counter", "Cloud requests by connection, kept connections are reused while the server allows it");
+  writer.sample("wlanthermo_cloud_connections_total").label("connection", "new").value(cloudStats.connections);
+  writer.sample("wlanthermo_cloud_connections_total").label("connection", "reused").value(cloudStats.reused);
+
+  writer.family("wlanthermo_cloud_request_milliseconds_total", "counter", "Time from request to response");
+  writer.sample("wlanthermo_cloud_request_milliseconds_total").label("connection", "new").value(cloudStats.connectLatency);
+  writer.sample("wlanthermo_cloud_request_milliseconds_total").label("connection", "reused").value(cloudStats.reusedLatency);
+
+  writer.family("wlanthermo_mqtt_connected", "gauge", "MQTT broker connected");
+  writer.sample("wlanthermo_mqtt_connected").value((uint32_t)Mqtt::isConnected());
+
+  writer.family("wlanthermo_mqtt_in_flight", "gauge", "MQTT messages waiting for acknowledge");
+  writer.sample("wlanthermo_mqtt_in_flight").value(mqttStats.inFlight);
+
+  writer.family("wlanthermo_mqtt_published_total", "counter", "MQTT messages published");
+  writer.sample("wlanthermo_mqtt_published_total").value(mqttStats.published);
+
+  writer.family("wlanthermo_mqtt_errors_total", "counter", "MQTT errors");
+  writer.sample("wlanthermo_mqtt_errors_total").label("reason", "publish").value(mqttStats.publishErrors);
+  writer.sample("wlanthermo_mqtt_errors_total").label("reason", "disconnect").value(mqttStats.disconnects);
+}
+
+static const MetricsSection metricsSections[] = {
+    systemMetrics,
+    temperatureMetrics,
+    pitmasterMetrics,
+    connectMetrics,
+    BusLock::printMetrics,
+    ApiCache::printMetrics,
+    TaskMonitor::printMetrics,
+    TaskMonitor::printSectionMetrics};
+
+#define METRICS_SECTION_COUNT (sizeof(metricsSections) / sizeof(metricsSections[0]))
+
+MetricsStream::MetricsStream() : writer(this)
+{
+  this->section = 0u;
+  this->pendingIndex = 0u;
+  this->pending.reserve(METRICS_STREAM_PART_SIZE);
+}
+
+size_t MetricsStream::read(uint8_t *buffer, size_t maxLen)
+{
+  size_t length = 0u;
+
+  while (length < maxLen)
+  {
+    if (this->pendingIndex >= this->pending.getSize())
+    {
+      if (this->section >= METRICS_SECTION_COUNT)
+        break;
+
+      // keeps the reserved buffer
+      this->pending.clear();
+      this->pendingIndex = 0u;
+      metricsSections[this->section++](this->writer);
+
+      // out of heap, a cut line would make Prometheus reject the whole scrape
+      if (this->pending.hasFailed())
+      {
+        Log.warning("Metrics: section %u dropped, no memory" CR, this->section - 1u);
+        this->pending.clear();
+      }
+      continue;
+    }
+
+    size_t copyLength = min(this->pending.getSize() - this->pendingIndex, maxLen - length);
+    memcpy(&buffer[length], this->pending.getData() + this->pendingIndex, copyLength);
+    this->pendingIndex += copyLength;
+    length += copyLength;
+  }
+
+  return length;
+}
+
+void MetricsStream::printTo(Print *print)
+{
+  MetricsWriter writer(print);
+
+  for (uint8_t i = 0u; i < METRICS_SECTION_COUNT; i++)
+    metricsSections[i](writer);
+}
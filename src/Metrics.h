@@ -0,0 +1,65 @@
+/*************************************************** 
+    Copyright (C) 2020  Martin Koerner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    
+    HISTORY: Please refer Github History
+    
+****************************************************/
+#pragma once
+
+#include <Arduino.h>
+#include "ApiWriter.h"
+
+#define METRICS_CONTENT_TYPE "text/plain; version=0.0.4"
+#define METRICS_STREAM_PART_SIZE 1024u
+
+// Writes samples in the Prometheus text exposition format:
+// writer.sample("name").label("channel", 1u).value(21.5f);
+class MetricsWriter
+{
+public:
+  MetricsWriter(Print *print);
+  void family(const char *name, const char *type, const char *help);
+  MetricsWriter &sample(const char *name);
+  MetricsWriter &label(const char *key, const char *value);
+  MetricsWriter &label(const char *key, uint32_t value);
+  void value(uint32_t value);
+  void value(int32_t value);
+  void value(float value);
+
+private:
+  void endLabels();
+  Print *print;
+  boolean hasLabel;
+};
+
+typedef void (*MetricsSection)(MetricsWriter &writer);
+
+// Renders one section per read, so no buffer holds the whole document
+class MetricsStream : public Print
+{
+public:
+  MetricsStream();
+  size_t read(uint8_t *buffer, size_t maxLen);
+  size_t write(uint8_t c) { return this->pending.write(c); };
+  size_t write(const uint8_t *data, size_t size) { return this->pending.write(data, size); };
+  static void printTo(Print *print);
+
+private:
+  MetricsWriter writer;
+  uint8_t section;
+  ApiBufferPrint pending;
+  size_t pendingIndex;
+};
@@ -25,9 +25,10 @@
 #include "API.h"
 
 AsyncMqttClient Mqtt::pmqttClient;
-MqttConfig Mqtt::config = {"192.168.2.1", 1883u, "", "", 0, false, 30};
+MqttConfig Mqtt::config = {"192.168.2.1", 1883u, "", "", 0, false, 30, false};
 bool Mqtt::sendSettingsflag = false;
 uint16_t Mqtt::intervalCounter = 0u;
+MqttStats Mqtt::stats = {0u, 0u, 0u, 0u};
 
 Mqtt::Mqtt()
 {
@@ -90,6 +91,7 @@ void Mqtt::saveConfig()
   json["QoS"] = config.QoS;
   json["enabled"] = config.enabled;
   json["interval"] = config.interval;
+  json["cbor"] = config.cbor;
   Settings::write(kMqtt, json);
 }
 
@@ -115,6 +117,8 @@ void Mqtt::loadConfig()
       config.enabled = json["enabled"];
     if (json.containsKey("interval"))
       config.interval = json["interval"];
+    if (json.containsKey("cbor"))
+      config.cbor = json["cbor"];
   }
 }
 
@@ -150,6 +154,8 @@ void Mqtt::onMqttDisconnect(AsyncMqttClientDisconnectReason reason)
 {
   IPRINTPLN("d:MQTT");
   sendSettingsflag = false;
+  stats.disconnects++;
+  stats.inFlight = 0u;
 }
 
 void Mqtt::onMqttConnect(bool sessionPresent)
@@ -227,6 +233,9 @@ void Mqtt::onMqttMessage(char *topic, char *datas, AsyncMqttClientMessagePropert
 
 void Mqtt::onMqttPublish(uint16_t packetId)
 {
+  if (stats.inFlight > 0u)
+    stats.inFlight--;
+
   MQPRINTPLN("[MQTT]\tPublish acknowledged.");
   MQPRINTP("  packetId: ");
   MQPRINTLN(packetId);
@@ -255,8 +264,7 @@ bool Mqtt::sendData()
 
   if (pmqttClient.connected())
   {
-    String payload_data = API::apiData(APIDATA);
-    pmqttClient.publish(prefixgen(1).c_str(), gSystem->mqtt.config.QoS, false, payload_data.c_str());
+    publishApi(prefixgen(1), APIDATA);
     MQPRINTPLN("[MQTT] Send: /data ");
     return true;
   }
@@ -271,8 +279,7 @@ bool Mqtt::sendSettings()
 
   if (pmqttClient.connected())
   {
-    String payload_settings = API::apiData(APISETTINGS);
-    pmqttClient.publish(prefixgen(2).c_str(), gSystem->mqtt.config.QoS, false, payload_settings.c_str());
+    publishApi(prefixgen(2), APISETTINGS);
     MQPRINTPLN("[MQTT] Send: /settings ");
     return true;
   }
@@ -282,6 +289,36 @@ bool Mqtt::sendSettings()
   }
 }
 
+// publish JSON or CBOR document
+void Mqtt::publishApi(String topic, int typ)
+{
+  ApiFormat format = (gSystem->mqtt.config.cbor) ? ApiFormat::Cbor : ApiFormat::Json;
+  ApiBufferPrint payload;
+
+  if (payload.reserve(API::apiWrite(NULL, typ, format) + 16u))
+  {
+    API::apiWrite(&payload, typ, format);
+
+    // packet id 0 means the message was not sent
+    uint16_t packetId = pmqttClient.publish(topic.c_str(), gSystem->mqtt.config.QoS, false, (const char *)payload.getData(), payload.getSize());
+
+    if (0u == packetId)
+    {
+      stats.publishErrors++;
+      return;
+    }
+
+    if (gSystem->mqtt.config.QoS > 0u)
+      stats.inFlight++;
+
+    stats.published++;
+  }
+  else
+  {
+    stats.publishErrors++;
+  }
+}
+
 void Mqtt::onSettingsWrite(SettingsNvsKeys key)
 {
   // enable sending of settings
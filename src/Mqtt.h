@@ -35,8 +35,17 @@ typedef struct
   byte QoS;
   bool enabled;
   int interval;
+  bool cbor;
 } MqttConfig;
 
+typedef struct
+{
+  uint32_t published;
+  uint32_t publishErrors;
+  uint32_t disconnects;
+  uint32_t inFlight; // QoS > 0, not acknowledged
+} MqttStats;
+
 class Mqtt
 {
 public:
@@ -46,10 +55,13 @@ public:
   void loadConfig();
   MqttConfig getConfig();
   void setConfig(MqttConfig newConfig);
+  static boolean isConnected() { return pmqttClient.connected(); };
+  static MqttStats getStats() { return stats; };
 
 private:
   static bool sendSettings();
   static bool sendData();
+  static void publishApi(String topic, int typ);
   static void onSettingsWrite(SettingsNvsKeys key);
 
   static void onMqttDisconnect(AsyncMqttClientDisconnectReason reason);
@@ -63,5 +75,6 @@ private:
   static MqttConfig config;
   static bool sendSettingsflag;
   static uint16_t intervalCounter;
+  static MqttStats stats;
   bool initDone;
 };
@@ -27,7 +27,7 @@
 #include "RecoveryMode.h"
 #include "DbgPrint.h"
 #include "Settings.h"
-#include "ArduinoLog.h"
+#include "EventLog.h"
 #include "LogRingBuffer.h"
 #include "system/SystemBase.h"
 #include "webui/recoverymode.html.gz.h"
@@ -21,9 +21,16 @@
 // HELP: https://github.com/bblanchon/ArduinoJson
 
 #include "system/SystemBase.h"
+#include "temperature/TemperatureLut.h"
+#include "SlidingMedian.h"
 #include "display/DisplayBase.h"
 #include "WebHandler.h"
 #include "API.h"
+#include "EventLog.h"
+#include "ApiCache.h"
+#include "TaskMonitor.h"
+#include "Metrics.h"
+#include "BusLock.h"
 #include "DbgPrint.h"
 #include <Preferences.h>
 
@@ -254,6 +261,81 @@ void read_serial(char *buffer)
       Serial.printf("Free heap: %d bytes\n", ESP.getFreeHeap());
       return;
     }
+    else if (str == "temperaturelut")
+    {
+      TemperatureLut::benchmark(&Serial);
+      return;
+    }
+    else if ((str == "buslock") || (str == "wirelock"))
+    {
+      BusLock::print(&Serial);
+      BusLock::resetAll();
+      return;
+    }
+    else if ((str == "tasks") || (str == "systemtask"))
+    {
+      TaskMonitor::print(&Serial);
+      return;
+    }
+    else if (str == "taskreset")
+    {
+      TaskMonitor::resetAll();
+      return;
+    }
+    else if (str == "spiffshistory")
+    {
+      if (gSystem->spiffsHistory != NULL)
+        gSystem->spiffsHistory->printStats(&Serial);
+      else
+        Serial.println("SPIFFS history not active");
+      return;
+    }
+    else if (str == "spiffswa")
+    {
+      if (gSystem->spiffsHistory != NULL)
+        gSystem->spiffsHistory->benchmark(&Serial);
+      else
+        Serial.println("SPIFFS history not active");
+      return;
+    }
+    else if (str == "slidingmedian")
+    {
+      slidingMedianBenchmark(&Serial);
+      return;
+    }
+    else if ((str == "apistream") || (str == "apiformat"))
+    {
+      API::benchmark(&Serial);
+      return;
+    }
+    else if (str == "cloudbatch")
+    {
+      gSystem->cloud.benchmark(&Serial);
+      return;
+    }
+    else if (str == "logbench")
+    {
+      LogRingBuffer::benchmark(&Serial);
+      EventLog::benchmark(&Serial);
+      return;
+    }
+    else if (str == "log")
+    {
+      EventLogReader reader(&gLogRingBuffer);
+      reader.printTo(&Serial);
+      return;
+    }
+    else if (str == "apicache")
+    {
+      MetricsWriter writer(&Serial);
+      ApiCache::printMetrics(writer);
+      return;
+    }
+    else if (str == "metrics")
+    {
+      MetricsStream::printTo(&Serial);
+      return;
+    }
     /*
     else if (str == "pittest") {
       pitMaster[0].active = AUTO;
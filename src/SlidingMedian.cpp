@@ -0,0 +1,68 @@
+/*************************************************** 
+    Copyright (C) 2020  Martin Koerner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    
+    HISTORY: Please refer Github History
+    
+****************************************************/
+
+#include "SlidingMedian.h"
+#include "MedianFilterLib.h"
+
+#define BENCHMARK_SAMPLES 2000u
+
+template <size_t N>
+static void benchmarkWindow(Print *print)
+{
+  SlidingMedian<float, N> slidingMedian;
+  MedianFilter<float> medianFilter(N);
+  volatile float result;
+  float value;
+
+  randomSeed(N);
+  uint32_t slidingTime = micros();
+  for (uint16_t i = 0u; i < BENCHMARK_SAMPLES; i++)
+  {
+    value = (float)random(-300, 3000) / 10.0;
+    slidingMedian.addValue(value);
+    result = slidingMedian.getFiltered();
+  }
+  slidingTime = micros() - slidingTime;
+
+  randomSeed(N);
+  uint32_t libraryTime = micros();
+  for (uint16_t i = 0u; i < BENCHMARK_SAMPLES; i++)
+  {
+    value = (float)random(-300, 3000) / 10.0;
+    medianFilter.AddValue(value);
+    result = medianFilter.GetFiltered();
+  }
+  libraryTime = micros() - libraryTime;
+
+  print->printf("window %2u: SlidingMedian %5uus, MedianFilter %5uus (%u samples)\n",
+                N, slidingTime, libraryTime, BENCHMARK_SAMPLES);
+
+  (void)result;
+}
+
+void slidingMedianBenchmark(Print *print)
+{
+  benchmarkWindow<5u>(print);
+  benchmarkWindow<9u>(print);
+  benchmarkWindow<10u>(print);
+  benchmarkWindow<16u>(print);
+  benchmarkWindow<32u>(print);
+  benchmarkWindow<64u>(print);
+}
@@ -0,0 +1,169 @@
+/*************************************************** 
+    Copyright (C) 2020  Martin Koerner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    
+    HISTORY: Please refer Github History
+    
+****************************************************/
+#pragma once
+
+#include "Arduino.h"
+
+// Sliding window median with a compile time window size and without heap allocation.
+// The window is kept in two heaps around the median (max heap below, min heap above),
+// so adding a value costs O(log n) and reading the median is O(1).
+// Based on the "Mediator" approach from https://stackoverflow.com/a/5970314
+template <typename T, size_t N>
+class SlidingMedian
+{
+  static_assert(N > 0u && N < INT16_MAX, "invalid window size");
+
+public:
+  SlidingMedian() { reset(); }
+
+  void reset()
+  {
+    this->index = 0u;
+    this->count = 0u;
+
+    // fill order is 0, -1, 1, -2, 2, ... so both heaps stay balanced until the window is full
+    for (int16_t k = N - 1; k >= 0; k--)
+    {
+      this->pos[k] = ((k + 1) / 2) * ((k & 1) ? -1 : 1);
+      heap(this->pos[k]) = k;
+    }
+  }
+
+  T addValue(T value)
+  {
+    boolean isNew = (this->count < N);
+    int16_t p = this->pos[this->index];
+    T old = this->data[this->index];
+
+    this->data[this->index] = value;
+    this->index = (this->index + 1u) % N;
+    this->count += isNew ? 1u : 0u;
+
+    if (p > 0)
+    {
+      // value is in the min heap
+      if (!isNew && old < value)
+        minSortDown(p * 2);
+      else if (minSortUp(p))
+        maxSortDown(-1);
+    }
+    else if (p < 0)
+    {
+      // value is in the max heap
+      if (!isNew && value < old)
+        maxSortDown(p * 2);
+      else if (maxSortUp(p))
+        minSortDown(1);
+    }
+    else
+    {
+      // value is the median
+      if (maxCount())
+        maxSortDown(-1);
+      if (minCount())
+        minSortDown(1);
+    }
+
+    return getFiltered();
+  }
+
+  T getFiltered() const
+  {
+    if (0u == this->count)
+      return T();
+
+    T value = this->data[heap(0)];
+
+    // even number of values: mean of both middle values
+    if (0u == (this->count & 1u))
+      value = (value + this->data[heap(-1)]) / 2;
+
+    return value;
+  }
+
+  size_t getCount() const { return this->count; }
+  static constexpr size_t getSize() { return N; }
+
+private:
+  T data[N];           // circular buffer of values
+  int16_t pos[N];      // heap position of each value
+  int16_t heapData[N]; // indexes into data, heap(0) is the median
+  size_t index;
+  size_t count;
+
+  int16_t &heap(int16_t i) { return this->heapData[i + (int16_t)(N / 2u)]; }
+  int16_t heap(int16_t i) const { return this->heapData[i + (int16_t)(N / 2u)]; }
+  int16_t minCount() const { return ((int16_t)this->count - 1) / 2; }
+  int16_t maxCount() const { return (int16_t)this->count / 2; }
+
+  boolean less(int16_t i, int16_t j) const { return this->data[heap(i)] < this->data[heap(j)]; }
+
+  boolean exchange(int16_t i, int16_t j)
+  {
+    int16_t t = heap(i);
+    heap(i) = heap(j);
+    heap(j) = t;
+    this->pos[heap(i)] = i;
+    this->pos[heap(j)] = j;
+    return true;
+  }
+
+  boolean compareExchange(int16_t i, int16_t j) { return less(i, j) && exchange(i, j); }
+
+  // i is the first child to check, sorts down while it is smaller than its parent
+  void minSortDown(int16_t i)
+  {
+    for (; i <= minCount(); i *= 2)
+    {
+      if (i > 1 && i < minCount() && less(i + 1, i))
+        ++i;
+      if (!compareExchange(i, i / 2))
+        break;
+    }
+  }
+
+  // i is the first child to check, sorts down while it is bigger than its parent
+  void maxSortDown(int16_t i)
+  {
+    for (; i >= -maxCount(); i *= 2)
+    {
+      if (i < -1 && i > -maxCount() && less(i, i - 1))
+        --i;
+      if (!compareExchange(i / 2, i))
+        break;
+    }
+  }
+
+  boolean minSortUp(int16_t i)
+  {
+    while (i > 0 && compareExchange(i, i / 2))
+      i /= 2;
+    return (0 == i);
+  }
+
+  boolean maxSortUp(int16_t i)
+  {
+    while (i < 0 && compareExchange(i / 2, i))
+      i /= 2;
+    return (0 == i);
+  }
+};
+
+void slidingMedianBenchmark(Print *print);
@@ -0,0 +1,289 @@
+/*************************************************** 
+    Copyright (C) 2020  Martin Koerner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    
+    HISTORY: Please refer Github History
+    
+****************************************************/
+
+#include "SpiffsHistory.h"
+#include "TaskConfig.h"
+#include "EventLog.h"
+#include <SPIFFS.h>
+#include <esp_partition.h>
+
+#define SPIFFS_HISTORY_FILE_PREFIX "/cooklog"
+#define SPIFFS_HISTORY_QUEUE_LENGTH 10u
+#define SPIFFS_HISTORY_FLUSH_TIMEOUT 2000u // ms
+#define SPIFFS_HISTORY_BENCHMARK_FILE "/cooklogwa.bin"
+#define SPIFFS_HISTORY_BENCHMARK_BLOCKS 16u
+// one object lookup page per logical block, one entry for each other page
+#define SPIFFS_LOOKUP_ENTRIES ((SPIFFS_LOGICAL_BLOCK_SIZE / SPIFFS_LOGICAL_PAGE_SIZE) - 1u)
+#define SPIFFS_LOOKUP_FREE 0xFFFFu
+
+SpiffsHistory::SpiffsHistory()
+{
+  this->block = new uint8_t[SPIFFS_HISTORY_BLOCK_SIZE];
+  this->encoder = new CookLogEncoder(this->block, SPIFFS_HISTORY_BLOCK_SIZE);
+  this->flushRequested = false;
+  this->flushDone = xSemaphoreCreateBinary();
+  this->writeAmplification = 0.0;
+  memset(&this->stats, 0, sizeof(this->stats));
+
+  findNewestSegment();
+
+  this->sampleQueue = xQueueCreate(SPIFFS_HISTORY_QUEUE_LENGTH, sizeof(CookLogSample));
+  xTaskCreatePinnedToCore(SpiffsHistory::task, "SpiffsHistory::task", 4096, this, TASK_PRIORITY_SDCARD_TASK, NULL, 0);
+}
+
+String SpiffsHistory::getSegmentName(uint8_t segment)
+{
+  return SPIFFS_HISTORY_FILE_PREFIX + String(segment) + ".bin";
+}
+
+// segments from the oldest to the one currently written
+CookLogStream *SpiffsHistory::createLogStream(uint32_t from)
+{
+  CookLogStream *stream = new CookLogStream(SPIFFS, SPIFFS_HISTORY_BLOCK_SIZE, from);
+  uint8_t newest = this->segment;
+
+  for (uint8_t i = 1u; i <= SPIFFS_HISTORY_SEGMENTS; i++)
+    stream->addFile(getSegmentName((newest + i) % SPIFFS_HISTORY_SEGMENTS));
+
+  return stream;
+}
+
+// continue with the segment holding the latest samples
+void SpiffsHistory::findNewestSegment()
+{
+  uint32_t newestTime = 0u;
+
+  this->segment = 0u;
+  this->segmentBlocks = 0u;
+
+  for (uint8_t i = 0u; i < SPIFFS_HISTORY_SEGMENTS; i++)
+  {
+    File file = SPIFFS.open(getSegmentName(i));
+    uint32_t blocks = CookLog::getBlockCount(file, SPIFFS_HISTORY_BLOCK_SIZE);
+    CookLogBlockFooter footer;
+
+    // segments of another block size are not continued
+    if ((blocks > 0u) && (0u == (file.size() % SPIFFS_HISTORY_BLOCK_SIZE)) &&
+        CookLog::readFooter(file, SPIFFS_HISTORY_BLOCK_SIZE, blocks - 1u, &footer) && (footer.lastTime > newestTime))
+    {
+      newestTime = footer.lastTime;
+      this->segment = i;
+      this->segmentBlocks = blocks;
+    }
+
+    file.close();
+  }
+
+  Log.notice("SPIFFS history: segment %d, block %d" CR, this->segment, this->segmentBlocks);
+}
+
+// called from the system task, never blocks
+boolean SpiffsHistory::log(CookLogSample *sample)
+{
+  return (xQueueSend(this->sampleQueue, sample, 0) == pdTRUE);
+}
+
+// write the current block before deep sleep or restart
+void SpiffsHistory::flush()
+{
+  xSemaphoreTake(this->flushDone, 0);
+  this->flushRequested = true;
+  xSemaphoreTake(this->flushDone, SPIFFS_HISTORY_FLUSH_TIMEOUT);
+}
+
+void SpiffsHistory::task(void *parameter)
+{
+  SpiffsHistory *history = (SpiffsHistory *)parameter;
+  CookLogSample sample;
+
+  for (;;)
+  {
+    if (xQueueReceive(history->sampleQueue, &sample, TASK_CYCLE_TIME_SDCARD_TASK) == pdTRUE)
+    {
+      history->writeSample(&sample);
+    }
+
+    if (history->flushRequested)
+    {
+      if (false == history->encoder->isEmpty())
+      {
+        history->writeBlock();
+        history->encoder->reset(0u, 0u);
+      }
+
+      history->flushRequested = false;
+      xSemaphoreGive(history->flushDone);
+    }
+  }
+}
+
+void SpiffsHistory::writeSample(CookLogSample *sample)
+{
+  this->stats.samples++;
+
+  if (this->encoder->add(sample))
+    return;
+
+  // only full blocks are written, SPIFFS can't overwrite a page in place
+  if (false == this->encoder->isEmpty())
+  {
+    this->writeBlock();
+  }
+
+  this->encoder->reset(sample->count, sample->unit);
+  this->encoder->add(sample);
+}
+
+boolean SpiffsHistory::writeBlock()
+{
+  if (this->segmentBlocks >= SPIFFS_HISTORY_SEGMENT_BLOCKS)
+  {
+    // rotate, truncating frees the pages of the oldest segment
+    this->segment = (this->segment + 1u) % SPIFFS_HISTORY_SEGMENTS;
+    this->segmentBlocks = 0u;
+    this->stats.rotations++;
+  }
+
+  this->encoder->finish();
+
+  // a new segment is truncated, it might hold blocks of an older block size
+  File file = SPIFFS.open(getSegmentName(this->segment), (0u == this->segmentBlocks) ? FILE_WRITE : FILE_APPEND);
+
+  if (!file)
+  {
+    Log.warning("SPIFFS history: open segment %d failed" CR, this->segment);
+    return false;
+  }
+
+  size_t written = file.write(this->block, SPIFFS_HISTORY_BLOCK_SIZE);
+  file.close();
+
+  this->segmentBlocks++;
+  this->stats.blocks++;
+  this->stats.encodedBytes += this->encoder->getUsedBytes();
+  this->stats.writtenBytes += written;
+
+  return (SPIFFS_HISTORY_BLOCK_SIZE == written);
+}
+
+// free pages of the partition, counted in the object lookup page of every logical block
+static int32_t countFreePages()
+{
+  const esp_partition_t *partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_DATA_SPIFFS, NULL);
+  uint16_t lookup[SPIFFS_LOOKUP_ENTRIES];
+  int32_t freePages = 0;
+
+  if (NULL == partition)
+    return -1;
+
+  for (uint32_t offset = 0u; offset < partition->size; offset += SPIFFS_LOGICAL_BLOCK_SIZE)
+  {
+    if (esp_partition_read(partition, offset, lookup, sizeof(lookup)) != ESP_OK)
+      return -1;
+
+    for (uint8_t i = 0u; i < SPIFFS_LOOKUP_ENTRIES; i++)
+    {
+      if (SPIFFS_LOOKUP_FREE == lookup[i])
+        freePages++;
+    }
+  }
+
+  return freePages;
+}
+
+// Appends blocks like writeBlock() and counts the pages programmed for each of them.
+// A block during which garbage collection has freed pages is not counted.
+void SpiffsHistory::benchmark(Print *print)
+{
+  uint8_t *data = new uint8_t[SPIFFS_HISTORY_BLOCK_SIZE];
+  uint32_t pages = 0u;
+  uint32_t blocks = 0u;
+  uint32_t skipped = 0u;
+  int32_t freeBefore = -1;
+
+  memset(data, 0xA5u, SPIFFS_HISTORY_BLOCK_SIZE);
+  SPIFFS.remove(SPIFFS_HISTORY_BENCHMARK_FILE);
+
+  // the first block creates the file, it is not part of the measurement
+  for (uint8_t i = 0u; i <= SPIFFS_HISTORY_BENCHMARK_BLOCKS; i++)
+  {
+    File file = SPIFFS.open(SPIFFS_HISTORY_BENCHMARK_FILE, (0u == i) ? FILE_WRITE : FILE_APPEND);
+
+    if (!file)
+      break;
+
+    file.write(data, SPIFFS_HISTORY_BLOCK_SIZE);
+    file.close();
+
+    int32_t freeAfter = countFreePages();
+
+    if ((freeBefore >= 0) && (freeAfter >= 0) && (freeAfter <= freeBefore))
+    {
+      pages += freeBefore - freeAfter;
+      blocks++;
+    }
+    else if (freeBefore >= 0)
+    {
+      skipped++;
+    }
+
+    freeBefore = freeAfter;
+  }
+
+  SPIFFS.remove(SPIFFS_HISTORY_BENCHMARK_FILE);
+  delete[] data;
+
+  if (0u == blocks)
+  {
+    print->println("SPIFFS write benchmark failed");
+    return;
+  }
+
+  this->writeAmplification = (float)(pages * SPIFFS_LOGICAL_PAGE_SIZE) / (blocks * SPIFFS_HISTORY_BLOCK_SIZE);
+
+  print->printf("SPIFFS write benchmark: %u blocks of %u bytes, %u pages programmed, %u blocks skipped for GC\n",
+                blocks, SPIFFS_HISTORY_BLOCK_SIZE, pages, skipped);
+  print->printf("write amplification %.2f (programmed flash bytes / block bytes)\n", this->writeAmplification);
+}
+
+void SpiffsHistory::printStats(Print *print)
+{
+  SpiffsHistoryStats current = this->stats;
+  float uptimeDays = millis() / 86400000.0;
+  // padding of the blocks only, the pages SPIFFS programs per block are measured by benchmark()
+  float fillOverhead = (current.encodedBytes > 0u) ? (float)current.writtenBytes / current.encodedBytes : 0.0;
+  float samplesPerBlock = (current.blocks > 0u) ? (float)current.samples / current.blocks : 0.0;
+
+  print->printf("SPIFFS history: segment %u, block %u, rotations %u\n", this->segment, this->segmentBlocks, current.rotations);
+  print->printf("samples %u, blocks %u, encoded %u bytes, written %u bytes\n", current.samples, current.blocks, current.encodedBytes, current.writtenBytes);
+  print->printf("block fill overhead %.2f, samples per block %.1f\n", fillOverhead, samplesPerBlock);
+
+  if ((this->writeAmplification > 0.0) && (uptimeDays > 0.0))
+  {
+    float partitionWrites = ((current.writtenBytes * this->writeAmplification) / (float)SPIFFS.totalBytes()) / uptimeDays;
+    print->printf("write amplification %.2f (measured), partition writes per day %.4f\n", this->writeAmplification, partitionWrites);
+  }
+  else
+  {
+    print->println("write amplification not measured, run spiffswa");
+  }
+
+  print->printf("retention approx. %.1fh at 1 sample/s\n", (samplesPerBlock * SPIFFS_HISTORY_SEGMENT_BLOCKS * (SPIFFS_HISTORY_SEGMENTS - 1u)) / 3600.0);
+}
@@ -0,0 +1,71 @@
+/*************************************************** 
+    Copyright (C) 2020  Martin Koerner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    
+    HISTORY: Please refer Github History
+    
+****************************************************/
+#pragma once
+
+#include "Arduino.h"
+#include "CookLog.h"
+
+// logical page and block size of the ESP32 SPIFFS configuration
+#define SPIFFS_LOGICAL_PAGE_SIZE 256u
+#define SPIFFS_LOGICAL_BLOCK_SIZE 4096u
+#define SPIFFS_PAGE_HEADER_SIZE 5u // spiffs_page_header: object id, span index, flags
+
+// data of one SPIFFS data page, blocks are only written completely
+#define SPIFFS_HISTORY_BLOCK_SIZE (SPIFFS_LOGICAL_PAGE_SIZE - SPIFFS_PAGE_HEADER_SIZE)
+#define SPIFFS_HISTORY_SEGMENTS 16u
+#define SPIFFS_HISTORY_SEGMENT_BLOCKS 128u // 31KB per segment
+
+typedef struct
+{
+  uint32_t samples;
+  uint32_t blocks;
+  uint32_t encodedBytes;
+  uint32_t writtenBytes;
+  uint32_t rotations;
+} SpiffsHistoryStats;
+
+// Circular cook log on SPIFFS: fixed size segment files, the oldest segment is overwritten first
+class SpiffsHistory
+{
+public:
+  SpiffsHistory();
+  boolean log(CookLogSample *sample);
+  void flush();
+  SpiffsHistoryStats getStats() { return this->stats; };
+  void printStats(Print *print);
+  CookLogStream *createLogStream(uint32_t from);
+  void benchmark(Print *print);
+  static String getSegmentName(uint8_t segment);
+
+private:
+  static void task(void *parameter);
+  void findNewestSegment();
+  void writeSample(CookLogSample *sample);
+  boolean writeBlock();
+  QueueHandle_t sampleQueue;
+  SemaphoreHandle_t flushDone;
+  volatile boolean flushRequested;
+  uint8_t *block;
+  CookLogEncoder *encoder;
+  uint8_t segment;
+  uint16_t segmentBlocks;
+  float writeAmplification;
+  SpiffsHistoryStats stats;
+};
@@ -22,16 +22,22 @@
 #define TASK_PRIORITY_SYSTEM_TASK 30
 #define TASK_PRIORITY_MAIN_TASK 3
 #define TASK_PRIORITY_CONNECT_TASK 2
+#define TASK_PRIORITY_CONNECT_DISCOVERY_TASK 1
 #define TASK_PRIORITY_DISPLAY_TASK 2
 #define TASK_PRIORITY_BLUETOOTH_TASK 2
 #define TASK_PRIORITY_PBGUARD_TASK 1
+#define TASK_PRIORITY_SDCARD_TASK 1
 
 #define TASK_CYCLE_TIME_SYSTEM_TASK 200
 #define TASK_CYCLE_TIME_MAIN_TASK 200
 
 #define TASK_CYCLE_TIME_CONNECT_TASK 1000
+#define TASK_CYCLE_TIME_CONNECT_DISCOVERY 30000
+#define TASK_CYCLE_TIME_CONNECT_DISCOVERY_EMPTY 5000
 
 #define TASK_CYCLE_TIME_DISPLAY_FAST_TASK 10
 #define TASK_CYCLE_TIME_DISPLAY_SLOW_TASK 100
 
 #define TASK_CYCLE_TIME_BLUETOOTH_TASK 1000
+
+#define TASK_CYCLE_TIME_SDCARD_TASK 1000
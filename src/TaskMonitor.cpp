@@ -0,0 +1,203 @@
+/*************************************************** 
+    Copyright (C) 2020  Martin Koerner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    
+    HISTORY: Please refer Github History
+    
+****************************************************/
+#include "TaskMonitor.h"
+
+TaskSection *TaskSection::first = NULL;
+TaskMonitor *TaskMonitor::first = NULL;
+
+TaskRuntime::TaskRuntime()
+{
+  this->reset();
+}
+
+void TaskRuntime::add(uint32_t time)
+{
+  uint8_t bucket = 0u;
+
+  if (time >= (1u << TASK_MONITOR_BUCKET_SHIFT))
+    bucket = min((uint32_t)(31u - __builtin_clz(time) - TASK_MONITOR_BUCKET_SHIFT + 1u), (uint32_t)(TASK_MONITOR_BUCKETS - 1u));
+
+  this->buckets[bucket]++;
+  this->minTime = (this->count > 0u) ? min(this->minTime, time) : time;
+  this->maxTime = max(this->maxTime, time);
+  this->total += time;
+  this->count++;
+}
+
+void TaskRuntime::reset()
+{
+  this->count = 0u;
+  this->minTime = 0u;
+  this->maxTime = 0u;
+  this->total = 0u;
+  memset(this->buckets, 0, sizeof(this->buckets));
+}
+
+// upper bound of the bucket holding the percentile, limited to the maximum
+uint32_t TaskRuntime::getPercentile(uint8_t percent)
+{
+  uint32_t count = this->count;
+  uint32_t limit = (uint32_t)(((uint64_t)count * percent + 99u) / 100u);
+  uint32_t sum = 0u;
+
+  if (0u == count)
+    return 0u;
+
+  for (uint8_t i = 0u; i < (TASK_MONITOR_BUCKETS - 1u); i++)
+  {
+    sum += this->buckets[i];
+
+    if (sum >= limit)
+      return min((uint32_t)(1u << (i + TASK_MONITOR_BUCKET_SHIFT)), this->maxTime);
+  }
+
+  return this->maxTime;
+}
+
+TaskSection::TaskSection(const char *name)
+{
+  this->name = name;
+  this->start = 0u;
+  this->next = first;
+  first = this;
+}
+
+TaskMonitor::TaskMonitor(const char *name, uint32_t cycleTime)
+{
+  this->name = name;
+  this->cycleTime = cycleTime;
+  this->handle = NULL;
+  this->start = 0u;
+  this->lastStart = 0u;
+  this->jitterMax = 0u;
+  this->deadlineMisses = 0u;
+  this->next = first;
+  first = this;
+}
+
+void TaskMonitor::begin()
+{
+  this->start = esp_timer_get_time();
+
+  if (NULL == this->handle)
+    this->handle = xTaskGetCurrentTaskHandle();
+
+  // deviation of the cycle start from the configured cycle time
+  if (this->lastStart != 0u)
+  {
+    int32_t deviation = (int32_t)(this->start - this->lastStart) - (int32_t)(this->cycleTime * 1000u);
+    this->jitterMax = max(this->jitterMax, (uint32_t)abs(deviation));
+  }
+
+  this->lastStart = this->start;
+}
+
+void TaskMonitor::end()
+{
+  uint32_t time = (uint32_t)esp_timer_get_time() - this->start;
+
+  this->add(time);
+
+  if (time > (this->cycleTime * 1000u))
+    this->deadlineMisses++;
+}
+
+// stack high water mark in bytes, read from the calling task
+uint32_t TaskMonitor::getStackFree()
+{
+  TaskHandle_t handle = this->handle;
+
+  return (handle != NULL) ? uxTaskGetStackHighWaterMark(handle) : 0u;
+}
+
+void TaskMonitor::print(Print *print)
+{
+  print->println("task                cycles   min   avg   p99    max  jitter misses stack (us, bytes)");
+
+  for (TaskMonitor *monitor = first; monitor != NULL; monitor = monitor->next)
+  {
+    print->printf("%-19s %7u %5u %5u %5u %6u %7u %6u %5u\n", monitor->name, monitor->getCount(),
+                  monitor->getMin(), monitor->getAverage(), monitor->getPercentile(99u), monitor->getMax(),
+                  monitor->jitterMax, monitor->deadlineMisses, monitor->getStackFree());
+  }
+
+  print->println("section              calls   min   avg   p99    max (us)");
+
+  for (TaskSection *section = TaskSection::first; section != NULL; section = section->next)
+  {
+    print->printf("%-19s %7u %5u %5u %5u %6u\n", section->name, section->getCount(),
+                  section->getMin(), section->getAverage(), section->getPercentile(99u), section->getMax());
+  }
+}
+
+static void printRuntime(MetricsWriter &writer, const char *metric, const char *label, const char *name, TaskRuntime *runtime)
+{
+  writer.sample(metric).label(label, name).label("stat", "min").value(runtime->getMin());
+  writer.sample(metric).label(label, name).label("stat", "avg").value(runtime->getAverage());
+  writer.sample(metric).label(label, name).label("stat", "p99").value(runtime->getPercentile(99u));
+  writer.sample(metric).label(label, name).label("stat", "max").value(runtime->getMax());
+}
+
+void TaskMonitor::printMetrics(MetricsWriter &writer)
+{
+  writer.family("wlanthermo_task_cycles_total", "counter", "Task cycles");
+  for (TaskMonitor *monitor = first; monitor != NULL; monitor = monitor->next)
+    writer.sample("wlanthermo_task_cycles_total").label("task", monitor->name).value(monitor->getCount());
+
+  writer.family("wlanthermo_task_cycle_microseconds", "gauge", "Task run time per cycle");
+  for (TaskMonitor *monitor = first; monitor != NULL; monitor = monitor->next)
+    printRuntime(writer, "wlanthermo_task_cycle_microseconds", "task", monitor->name, monitor);
+
+  writer.family("wlanthermo_task_jitter_microseconds", "gauge", "Max. deviation of the cycle start from the cycle time");
+  for (TaskMonitor *monitor = first; monitor != NULL; monitor = monitor->next)
+    writer.sample("wlanthermo_task_jitter_microseconds").label("task", monitor->name).value(monitor->jitterMax);
+
+  writer.family("wlanthermo_task_deadline_misses_total", "counter", "Cycles with a run time above the cycle time");
+  for (TaskMonitor *monitor = first; monitor != NULL; monitor = monitor->next)
+    writer.sample("wlanthermo_task_deadline_misses_total").label("task", monitor->name).value(monitor->deadlineMisses);
+
+  writer.family("wlanthermo_task_stack_free_bytes", "gauge", "Stack high water mark");
+  for (TaskMonitor *monitor = first; monitor != NULL; monitor = monitor->next)
+    writer.sample("wlanthermo_task_stack_free_bytes").label("task", monitor->name).value(monitor->getStackFree());
+}
+
+void TaskMonitor::printSectionMetrics(MetricsWriter &writer)
+{
+  writer.family("wlanthermo_task_section_calls_total", "counter", "Task section calls");
+  for (TaskSection *section = TaskSection::first; section != NULL; section = section->next)
+    writer.sample("wlanthermo_task_section_calls_total").label("section", section->name).value(section->getCount());
+
+  writer.family("wlanthermo_task_section_microseconds", "gauge", "Task section run time");
+  for (TaskSection *section = TaskSection::first; section != NULL; section = section->next)
+    printRuntime(writer, "wlanthermo_task_section_microseconds", "section", section->name, section);
+}
+
+void TaskMonitor::resetAll()
+{
+  for (TaskMonitor *monitor = first; monitor != NULL; monitor = monitor->next)
+  {
+    monitor->reset();
+    monitor->jitterMax = 0u;
+    monitor->deadlineMisses = 0u;
+  }
+
+  for (TaskSection *section = TaskSection::first; section != NULL; section = section->next)
+    section->reset();
+}
@@ -0,0 +1,96 @@
+/*************************************************** 
+    Copyright (C) 2020  Martin Koerner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    
+    HISTORY: Please refer Github History
+    
+****************************************************/
+#pragma once
+
+#include <Arduino.h>
+#include <esp_timer.h>
+#include "Metrics.h"
+
+// bucket i holds run times below 2^(i + 5) us, the last one everything above
+#define TASK_MONITOR_BUCKETS 16u
+#define TASK_MONITOR_BUCKET_SHIFT 5u
+
+// Run time statistics with a power of two histogram for percentiles
+class TaskRuntime
+{
+public:
+  TaskRuntime();
+  void add(uint32_t time);
+  void reset();
+  uint32_t getCount() { return this->count; };
+  uint32_t getMin() { return (this->count > 0u) ? this->minTime : 0u; };
+  uint32_t getMax() { return this->maxTime; };
+  uint32_t getAverage() { return (this->count > 0u) ? (uint32_t)(this->total / this->count) : 0u; };
+  uint32_t getPercentile(uint8_t percent);
+
+protected:
+  uint32_t count;
+  uint32_t minTime;
+  uint32_t maxTime;
+  uint64_t total;
+  uint32_t buckets[TASK_MONITOR_BUCKETS];
+};
+
+// Times one part of a task cycle
+class TaskSection : public TaskRuntime
+{
+public:
+  TaskSection(const char *name);
+  void begin() { this->start = esp_timer_get_time(); };
+  void end() { this->add((uint32_t)esp_timer_get_time() - this->start); };
+
+private:
+  friend class TaskMonitor;
+  const char *name;
+  uint32_t start;
+  TaskSection *next;
+  static TaskSection *first;
+};
+
+// Cycle time, jitter, deadline misses and stack usage of a periodic task.
+// begin() and end() enclose the work of one cycle, stop() has to be called
+// before the task deletes itself.
+class TaskMonitor : public TaskRuntime
+{
+public:
+  TaskMonitor(const char *name, uint32_t cycleTime);
+  void begin();
+  void end();
+  void stop() { this->handle = NULL; };
+  uint32_t getDeadlineMisses() { return this->deadlineMisses; };
+  uint32_t getJitterMax() { return this->jitterMax; };
+  uint32_t getStackFree();
+  static void print(Print *print);
+  static void printMetrics(MetricsWriter &writer);
+  static void printSectionMetrics(MetricsWriter &writer);
+  static void resetAll();
+
+private:
+  const char *name;
+  uint32_t cycleTime;
+  TaskHandle_t handle;
+  uint32_t start;
+  uint32_t lastStart;
+  uint32_t jitterMax;
+  uint32_t deadlineMisses;
+  TaskMonitor *next;
+  // monitors are static objects in other files, a plain pointer is initialized before them
+  static TaskMonitor *first;
+};
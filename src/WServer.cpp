@@ -24,6 +24,8 @@
 
 #include "WServer.h"
 #include "WebHandler.h"
+#include "WebEvents.h"
+#include "ApiCache.h"
 #include "Cloud.h"
 #include "system/SystemBase.h"
 #include "DbgPrint.h"
@@ -65,6 +67,8 @@ void WServer::init()
 {
   loadConfig();
   webServer.addHandler(&nanoWebHandler);
+  gWebEvents.init(&webServer);
+  ApiCache::init();
 
   webServer.on("/help", HTTP_GET, [](AsyncWebServerRequest *request) {
              request->redirect("https://github.com/WLANThermo-nano/WLANThermo_nano_Software/blob/master/README.md");
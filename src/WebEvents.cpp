@@ -0,0 +1,199 @@
+/*************************************************** 
+    Copyright (C) 2020  Martin Koerner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    
+    HISTORY: Please refer Github History
+    
+****************************************************/
+#include "WebEvents.h"
+#include "API.h"
+#include "JsonWriter.h"
+#include "system/SystemBase.h"
+#include "EventLog.h"
+
+WebEvents gWebEvents;
+
+WebEvents::WebEvents() : eventSource(WEB_EVENTS_URL)
+{
+  this->mux = portMUX_INITIALIZER_UNLOCKED;
+  this->changedValues = 0u;
+  this->changedSettings = 0u;
+  this->changedPitmasterValues = 0u;
+  this->changedPitmasterSettings = 0u;
+  this->lastSystemEvent = 0u;
+  this->eventId = 0u;
+}
+
+void WebEvents::init(AsyncWebServer *webServer)
+{
+  this->eventSource.onConnect([this](AsyncEventSourceClient *client) {
+    String snapshot = API::apiData(APIDATA);
+    client->send(snapshot.c_str(), "data", ++this->eventId, WEB_EVENTS_RECONNECT_TIME);
+    Log.notice("Web event client connected, %d clients" CR, this->eventSource.count());
+  });
+
+  webServer->addHandler(&this->eventSource);
+
+  // register for all temperature callbacks
+  gSystem->temperatures.registerCallback(WebEvents::temperatureCb, this);
+
+  // register for all pitmaster callbacks
+  for (uint8_t i = 0; i < gSystem->pitmasters.count(); i++)
+  {
+    Pitmaster *pitmaster = gSystem->pitmasters[i];
+    if (pitmaster != NULL)
+    {
+      pitmaster->registerCallback(WebEvents::pitmasterCb, this);
+    }
+  }
+}
+
+void WebEvents::temperatureCb(uint8_t index, TemperatureBase *temperature, boolean settingsChanged, void *userData)
+{
+  WebEvents *webEvents = (WebEvents *)userData;
+
+  if (index >= WEB_EVENTS_MAX_CHANNELS)
+    return;
+
+  portENTER_CRITICAL(&webEvents->mux);
+  if (settingsChanged)
+    webEvents->changedSettings |= (1u << index);
+  else
+    webEvents->changedValues |= (1u << index);
+  portEXIT_CRITICAL(&webEvents->mux);
+}
+
+void WebEvents::pitmasterCb(Pitmaster *pitmaster, boolean settingsChanged, void *userData)
+{
+  WebEvents *webEvents = (WebEvents *)userData;
+  uint8_t index = pitmaster->getGlobalIndex();
+
+  // one bit per pitmaster
+  if (index >= 8u)
+    return;
+
+  portENTER_CRITICAL(&webEvents->mux);
+  if (settingsChanged)
+    webEvents->changedPitmasterSettings |= (1u << index);
+  else
+    webEvents->changedPitmasterValues |= (1u << index);
+  portEXIT_CRITICAL(&webEvents->mux);
+}
+
+void WebEvents::update()
+{
+  portENTER_CRITICAL(&this->mux);
+  uint32_t values = this->changedValues;
+  uint32_t settings = this->changedSettings;
+  uint8_t pitmasterValues = this->changedPitmasterValues;
+  uint8_t pitmasterSettings = this->changedPitmasterSettings;
+  this->changedValues = 0u;
+  this->changedSettings = 0u;
+  this->changedPitmasterValues = 0u;
+  this->changedPitmasterSettings = 0u;
+  portEXIT_CRITICAL(&this->mux);
+
+  if (0u == this->eventSource.count())
+    return;
+
+  // system values (rssi, battery, ...) are sent only from time to time, this also keeps the connection alive
+  // or together with changed settings (e.g. unit)
+  boolean sendSystem = ((millis() - this->lastSystemEvent) >= WEB_EVENTS_SYSTEM_INTERVAL) || (settings > 0u);
+
+  if ((false == sendSystem) && (0u == (values | settings)) && (0u == (pitmasterValues | pitmasterSettings)))
+    return;
+
+  String message;
+  JsonStringPrint print(&message);
+  JsonWriter writer(&print);
+
+  message.reserve(WEB_EVENTS_MESSAGE_SIZE);
+  writer.beginObject();
+
+  if (sendSystem)
+  {
+    writer.beginObject("system");
+    API::systemObj(writer);
+    writer.endObject();
+    this->lastSystemEvent = millis();
+  }
+
+  if ((values | settings) > 0u)
+    writeChannels(writer, values, settings);
+
+  if ((pitmasterValues | pitmasterSettings) > 0u)
+    writePitmasters(writer, pitmasterValues, pitmasterSettings);
+
+  writer.endObject();
+
+  this->eventSource.send(message.c_str(), "delta", ++this->eventId);
+}
+
+// Changed settings send the complete channel, otherwise only the value
+void WebEvents::writeChannels(JsonWriter &writer, uint32_t values, uint32_t settings)
+{
+  writer.beginArray("channel");
+
+  for (uint8_t i = 0u; (i < gSystem->temperatures.count()) && (i < WEB_EVENTS_MAX_CHANNELS); i++)
+  {
+    uint32_t mask = (1u << i);
+    TemperatureBase *temperature = gSystem->temperatures[i];
+
+    if (settings & mask)
+    {
+      API::channelObj(writer, i);
+    }
+    else if ((values & mask) && (temperature != NULL))
+    {
+      writer.beginObject();
+      writer.addUInt("number", i + 1u);
+      writer.addFloat("temp", API::limit_float(temperature->getValue(), i));
+      writer.addBool("connected", temperature->isConnected());
+      writer.endObject();
+    }
+  }
+
+  writer.endArray();
+}
+
+// Changed settings send the complete pitmaster, otherwise only the value
+void WebEvents::writePitmasters(JsonWriter &writer, uint8_t values, uint8_t settings)
+{
+  writer.beginArray("pitmaster");
+
+  for (uint8_t i = 0u; i < gSystem->pitmasters.count(); i++)
+  {
+    Pitmaster *pitmaster = gSystem->pitmasters[i];
+
+    if (NULL == pitmaster)
+      continue;
+
+    uint8_t mask = (1u << pitmaster->getGlobalIndex());
+
+    if (settings & mask)
+    {
+      API::pitObj(writer, i);
+    }
+    else if (values & mask)
+    {
+      writer.beginObject();
+      writer.addUInt("id", i);
+      writer.addUInt("value", (uint8_t)pitmaster->getValue());
+      writer.endObject();
+    }
+  }
+
+  writer.endArray();
+}
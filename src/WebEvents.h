@@ -0,0 +1,57 @@
+/*************************************************** 
+    Copyright (C) 2020  Martin Koerner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    
+    HISTORY: Please refer Github History
+    
+****************************************************/
+#pragma once
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+
+#define WEB_EVENTS_URL "/events"
+#define WEB_EVENTS_MAX_CHANNELS 32u
+#define WEB_EVENTS_SYSTEM_INTERVAL 10000u
+#define WEB_EVENTS_RECONNECT_TIME 5000u
+#define WEB_EVENTS_MESSAGE_SIZE 256u
+
+// Server-Sent Events for the web interface and apps.
+// A client gets the complete /data document as "data" event on connect,
+// afterwards only changed channels and pitmasters are sent as "delta" event.
+class WebEvents
+{
+public:
+  WebEvents();
+  void init(AsyncWebServer *webServer);
+  void update();
+  size_t getClientCount() { return this->eventSource.count(); };
+
+private:
+  static void temperatureCb(uint8_t index, class TemperatureBase *temperature, boolean settingsChanged, void *userData);
+  static void pitmasterCb(class Pitmaster *pitmaster, boolean settingsChanged, void *userData);
+  void writeChannels(class JsonWriter &writer, uint32_t values, uint32_t settings);
+  void writePitmasters(class JsonWriter &writer, uint8_t values, uint8_t settings);
+  AsyncEventSource eventSource;
+  portMUX_TYPE mux;
+  uint32_t changedValues;
+  uint32_t changedSettings;
+  uint8_t changedPitmasterValues;
+  uint8_t changedPitmasterSettings;
+  uint32_t lastSystemEvent;
+  uint32_t eventId;
+};
+
+extern WebEvents gWebEvents;
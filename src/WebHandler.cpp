@@ -32,16 +32,24 @@
 #include "display/DisplayBase.h"
 #include "Version.h"
 #include "RecoveryMode.h"
-#include "LogRingBuffer.h"
+#include "EventLog.h"
 #include "DeviceId.h"
+#include "ApiCache.h"
+#include "Metrics.h"
 #include <SPIFFS.h>
 #include <AsyncJson.h>
+#include <memory>
 #include "webui/restart.html.gz.h"
 
 #define BAD_PATH "BAD PATH"
 
 #define APPLICATIONJSON "application/json"
 
+static ApiCache dataCache(APIDATA, ApiFormat::Json, "data");
+static ApiCache dataCborCache(APIDATA, ApiFormat::Cbor, "data_cbor");
+static ApiCache settingsCache(APISETTINGS, ApiFormat::Json, "settings");
+static ApiCache settingsCborCache(APISETTINGS, ApiFormat::Cbor, "settings_cbor");
+
 typedef void (NanoWebHandler::*ArRequestHandlerFunc)(AsyncWebServerRequest *);
 typedef bool (NanoWebHandler::*ArBodyHandlerFunc)(AsyncWebServerRequest *, uint8_t *);
 
@@ -93,6 +101,9 @@ static const NanoWebHandlerListType nanoWebHandlerList[] = {
     {"/getdeviceid", HTTP_GET | HTTP_POST, 0, &NanoWebHandler::handleDeviceId, NULL},
     {"/log", HTTP_GET | HTTP_POST, HTTP_GET | HTTP_POST, &NanoWebHandler::handleLog, NULL},
     {"/getpush", HTTP_GET | HTTP_POST, 0, &NanoWebHandler::handleGetPush, NULL},
+    {"/history", HTTP_GET, 0, &NanoWebHandler::handleHistory, NULL},
+    {"/cooklog", HTTP_GET, 0, &NanoWebHandler::handleCookLog, NULL},
+    {"/metrics", HTTP_GET, 0, &NanoWebHandler::handleMetrics, NULL},
     // Body handler
     {"/setnetwork", HTTP_POST, 0, NULL, &NanoWebHandler::setNetwork},
     {"/setchannels", HTTP_POST, HTTP_POST, NULL, &NanoWebHandler::setChannels},
@@ -188,6 +199,8 @@ bool NanoWebHandler::canHandle(AsyncWebServerRequest *request)
     if ((request->url().equals(nanoWebHandlerList[i].requestUrl)) && ((request->method() & nanoWebHandlerList[i].requestMethod) > 0u))
     {
       supported = true;
+      request->addInterestingHeader("If-None-Match");
+      request->addInterestingHeader("Accept");
       break;
     }
   }
@@ -197,20 +210,18 @@ bool NanoWebHandler::canHandle(AsyncWebServerRequest *request)
 
 void NanoWebHandler::handleSettings(AsyncWebServerRequest *request)
 {
-
-  String jsonStr;
-  jsonStr = API::apiData(APISETTINGS);
-
-  request->send(200, APPLICATIONJSON, jsonStr);
+  if (ApiCache::acceptsCbor(request))
+    settingsCborCache.handleRequest(request);
+  else
+    settingsCache.handleRequest(request);
 }
 
 void NanoWebHandler::handleData(AsyncWebServerRequest *request)
 {
-
-  String jsonStr;
-  jsonStr = API::apiData(APIDATA);
-
-  request->send(200, APPLICATIONJSON, jsonStr);
+  if (ApiCache::acceptsCbor(request))
+    dataCborCache.handleRequest(request);
+  else
+    dataCache.handleRequest(request);
 }
 
 void NanoWebHandler::handleWifiResult(AsyncWebServerRequest *request)
@@ -489,7 +500,63 @@ void NanoWebHandler::handleDeviceId(AsyncWebServerRequest *request)
 
 void NanoWebHandler::handleLog(AsyncWebServerRequest *request)
 {
-  request->send(200, TEXTPLAIN, gLogRingBuffer.get());
+  std::shared_ptr<EventLogReader> reader(new EventLogReader(&gLogRingBuffer));
+
+  // records are formatted while the response is sent
+  AsyncWebServerResponse *response = request->beginChunkedResponse(TEXTPLAIN, [reader](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+    return reader->read(buffer, maxLen);
+  });
+
+  request->send(response);
+}
+
+void NanoWebHandler::handleHistory(AsyncWebServerRequest *request)
+{
+  std::shared_ptr<TemperatureHistoryStream> stream(new TemperatureHistoryStream(&gSystem->temperatures));
+
+  AsyncWebServerResponse *response = request->beginChunkedResponse(APPLICATIONJSON, [stream](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+    return stream->read(buffer, maxLen);
+  });
+
+  request->send(response);
+}
+
+void NanoWebHandler::handleCookLog(AsyncWebServerRequest *request)
+{
+  uint32_t from = request->hasParam("from") ? request->getParam("from")->value().toInt() : 0u;
+  CookLogStream *cookLogStream = NULL;
+
+  if (gSystem->sdCard != NULL)
+    cookLogStream = gSystem->sdCard->createLogStream(from);
+  else if (gSystem->spiffsHistory != NULL)
+    cookLogStream = gSystem->spiffsHistory->createLogStream(from);
+
+  if (NULL == cookLogStream)
+  {
+    request->send(404, TEXTPLAIN, "no cook log");
+    return;
+  }
+
+  std::shared_ptr<CookLogStream> stream(cookLogStream);
+
+  // blocks are read from the file system while the response is sent
+  AsyncWebServerResponse *response = request->beginChunkedResponse("text/csv", [stream](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+    return stream->read(buffer, maxLen);
+  });
+
+  request->send(response);
+}
+
+void NanoWebHandler::handleMetrics(AsyncWebServerRequest *request)
+{
+  std::shared_ptr<MetricsStream> stream(new MetricsStream());
+
+  // sections are rendered while the response is sent
+  AsyncWebServerResponse *response = request->beginChunkedResponse(METRICS_CONTENT_TYPE, [stream](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+    return stream->read(buffer, maxLen);
+  });
+
+  request->send(response);
 }
 
 void NanoWebHandler::handleGetPush(AsyncWebServerRequest *request)
@@ -751,6 +818,8 @@ bool NanoWebHandler::setIoT(AsyncWebServerRequest *request, uint8_t *datas)
     mqttConfig.enabled = _chart["PMQon"];
   if (_chart.containsKey("PMQint"))
     mqttConfig.interval = _chart["PMQint"];
+  if (_chart.containsKey("PMQcbor"))
+    mqttConfig.cbor = _chart["PMQcbor"];
 
   gSystem->mqtt.setConfig(mqttConfig);
 
@@ -760,6 +829,8 @@ bool NanoWebHandler::setIoT(AsyncWebServerRequest *request, uint8_t *datas)
     cloudConfig.cloudToken = _chart["CLtoken"].asString();
   if (_chart.containsKey("CLint"))
     cloudConfig.cloudInterval = _chart["CLint"];
+  if (_chart.containsKey("CLdelta"))
+    cloudConfig.cloudDelta = _chart["CLdelta"];
   
   if (_chart.containsKey("CCLon"))
     cloudConfig.customEnabled = _chart["CCLon"];
@@ -767,6 +838,12 @@ bool NanoWebHandler::setIoT(AsyncWebServerRequest *request, uint8_t *datas)
     cloudConfig.customUrl = _chart["CCLurl"].asString();
   if (_chart.containsKey("CCLint"))
     cloudConfig.customInterval = _chart["CCLint"];
+  if (_chart.containsKey("CLadapt"))
+    cloudConfig.adaptiveInterval = _chart["CLadapt"];
+  if (_chart.containsKey("CLfloor"))
+    cloudConfig.intervalFloor = _chart["CLfloor"];
+  if (_chart.containsKey("CLceil"))
+    cloudConfig.intervalCeiling = _chart["CLceil"];
 
   gSystem->cloud.setConfig(cloudConfig);
 
@@ -1187,6 +1264,10 @@ bool NanoWebHandler::setServerAPI(AsyncWebServerRequest *request, uint8_t *datas
       Serial.print("[CLOUD]: ");
       Serial.println(gSystem->cloud.state);
     }
+
+    // server wants the full snapshot again
+    if (_cloud.containsKey("resync") && _cloud["resync"])
+      Cloud::requestResync();
   }
 
   // NOTE
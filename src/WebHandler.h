@@ -64,6 +64,9 @@ public:
   void handleDeviceId(AsyncWebServerRequest *request);
   void handleLog(AsyncWebServerRequest *request);
   void handleGetPush(AsyncWebServerRequest *request);
+  void handleHistory(AsyncWebServerRequest *request);
+  void handleCookLog(AsyncWebServerRequest *request);
+  void handleMetrics(AsyncWebServerRequest *request);
 
   // Body handler
   bool setServerAPI(AsyncWebServerRequest *request, uint8_t *datas);
@@ -24,7 +24,7 @@
 #include "Constants.h"
 #include "Version.h"
 #include "system/SystemBase.h"
-#include "ArduinoLog.h"
+#include "EventLog.h"
 
 #define APPASSWORD "12345678"
 
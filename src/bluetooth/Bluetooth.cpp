@@ -26,8 +26,10 @@
 #include "temperature/TemperatureBase.h"
 #include "system/SystemBase.h"
 #include "Settings.h"
-#include "ArduinoLog.h"
+#include "EventLog.h"
 #include "TaskConfig.h"
+#include "TaskMonitor.h"
+#include "BusLock.h"
 #include <byteswap.h>
 
 #define BLE_BAUD 115200u
@@ -45,8 +47,11 @@
 
 HardwareSerial *Bluetooth::serialBle = NULL;
 std::vector<BleDeviceType *> Bluetooth::bleDevices;
+BleDeviceMap Bluetooth::bleDeviceMap;
 boolean Bluetooth::enabled = true;
 
+static TaskMonitor bluetoothMonitor("Bluetooth::task", TASK_CYCLE_TIME_BLUETOOTH_TASK);
+
 Bluetooth::Bluetooth(int8_t rxPin, int8_t txPin, uint8_t resetPin)
 {
     serialBle = new HardwareSerial(1);
@@ -111,6 +116,12 @@ void Bluetooth::loadConfig(TemperatureGrp *temperatureGrp)
                 bleDevice->count = json["tcount"][i];
                 bleDevice->selected = json["tselected"][i];
 
+                if (false == bleDeviceMap.put(BleDeviceMap::parseMac(bleDevice->address), bleDevice))
+                {
+                    delete bleDevice;
+                    continue;
+                }
+
                 for (uint8_t s = 0u; s < bleDevice->count; s++)
                 {
                     if (bleDevice->selected & (1 << s))
@@ -184,22 +195,59 @@ void Bluetooth::enableChip(boolean enable)
     }
 }
 
-void Bluetooth::getDevices()
+BleDeviceType *Bluetooth::findDevice(const char *address, uint8_t remoteIndex)
+{
+    uint64_t mac = BleDeviceMap::parseMac(address);
+    BleDevice *bleDevice = bleDeviceMap.get(mac);
+
+    if (NULL == bleDevice)
+    {
+        bleDevice = new BleDeviceType();
+        memset(bleDevice, 0, sizeof(BleDeviceType));
+        bleDevice->remoteIndex = BLE_DEVICE_REMOTE_INDEX_INIT;
+        strncpy(bleDevice->address, address, sizeof(bleDevice->address) - 1u);
+
+        // invalid address or no free slot
+        if (false == bleDeviceMap.put(mac, bleDevice))
+        {
+            delete bleDevice;
+            return NULL;
+        }
+
+        bleDevices.push_back(bleDevice);
+    }
+
+    if (BLE_DEVICE_REMOTE_INDEX_INIT == bleDevice->remoteIndex)
+    {
+        bleDevice->remoteIndex = remoteIndex;
+    }
+
+    return bleDevice;
+}
+
+uint32_t Bluetooth::getRequestedDevices()
 {
     uint32_t requestedDevices = 0u;
 
     for (uint8_t devIndex = 0u; devIndex < bleDevices.size(); devIndex++)
     {
-        if (bleDevices[devIndex]->selected > 0u)
+        if ((bleDevices[devIndex]->selected > 0u) && (bleDevices[devIndex]->remoteIndex < BLUETOOTH_DEVICE_MAP_SIZE))
         {
             requestedDevices |= (1u << bleDevices[devIndex]->remoteIndex);
         }
     }
 
-    gSystem->wireLock();
+    return requestedDevices;
+}
+
+void Bluetooth::getDevices()
+{
+    uint32_t requestedDevices = getRequestedDevices();
+
+    gBleUartBus.lock();
     serialBle->printf("getDevices=%d\n", requestedDevices);
     String bleDeviceJson = serialBle->readStringUntil('\n');
-    gSystem->wireRelease();
+    gBleUartBus.release();
     Serial.println(bleDeviceJson);
 
     DynamicJsonBuffer jsonBuffer;
@@ -232,31 +280,12 @@ void Bluetooth::getDevices()
             continue;
         }
 
-        // check if device is known
-        String deviceAddress = _device[BLE_JSON_ADDRESS];
-        const auto isKnownDevice = [deviceAddress](BleDevice *d) {
-            return (deviceAddress.equalsIgnoreCase(d->address));
-        };
+        BleDevice *bleDevice = findDevice(_device[BLE_JSON_ADDRESS].asString(), deviceIndex);
 
-        auto it = std::find_if(bleDevices.begin(), bleDevices.end(), isKnownDevice);
-        BleDevice *bleDevice;
-
-        if (it != bleDevices.end())
+        if (NULL == bleDevice)
         {
-            bleDevice = *it;
-        }
-        else
-        {
-            bleDevice = new BleDeviceType();
-            memset(bleDevice, 0, sizeof(BleDeviceType));
-            bleDevice->remoteIndex = BLE_DEVICE_REMOTE_INDEX_INIT;
-            strcpy(bleDevice->address, deviceAddress.c_str());
-            bleDevices.push_back(bleDevice);
-        }
-
-        if (BLE_DEVICE_REMOTE_INDEX_INIT == bleDevice->remoteIndex)
-        {
-            bleDevice->remoteIndex = deviceIndex;
+            Serial.println("Invalid JSON: unknown address format");
+            continue;
         }
 
         if (_device.containsKey(BLE_JSON_NAME) == true)
@@ -324,30 +353,27 @@ boolean Bluetooth::getDevice(uint8_t index, BleDevice *device)
 
 void Bluetooth::setDeviceSelected(String peerAddress, uint8_t selected)
 {
-    const auto isKnownDevice = [peerAddress](BleDevice *d) {
-        return (peerAddress.equalsIgnoreCase(d->address));
-    };
-
-    auto it = std::find_if(bleDevices.begin(), bleDevices.end(), isKnownDevice);
+    BleDevice *bleDevice = getDeviceHandle(BleDeviceMap::parseMac(peerAddress.c_str()));
 
-    if (it != bleDevices.end())
+    if (bleDevice != NULL)
     {
-        (*it)->selected = selected;
+        bleDevice->selected = selected;
     }
 }
 
-boolean Bluetooth::isDeviceConnected(String peerAddress)
+// handles stay valid, devices are never deleted
+BleDeviceType *Bluetooth::getDeviceHandle(uint64_t mac)
 {
-    boolean isConnected = false;
-    const auto isKnownDevice = [peerAddress](BleDevice *d) {
-        return (peerAddress.equalsIgnoreCase(d->address));
-    };
+    return bleDeviceMap.get(mac);
+}
 
-    auto it = std::find_if(bleDevices.begin(), bleDevices.end(), isKnownDevice);
+boolean Bluetooth::isDeviceConnected(BleDeviceType *device)
+{
+    boolean isConnected = false;
 
-    if (it != bleDevices.end())
+    if (device != NULL)
     {
-        isConnected = (boolean)(*it)->status;
+        isConnected = (boolean)device->status;
 
         // overwrite connection status when bluetooth has been disabled
         if (false == enabled)
@@ -356,7 +382,7 @@ boolean Bluetooth::isDeviceConnected(String peerAddress)
             // reset sensors
             for (uint8_t i = 0; i < BLE_SENSORS_MAX_COUNT; i++)
             {
-                (*it)->sensors[i] = INACTIVEVALUE;
+                device->sensors[i] = INACTIVEVALUE;
             }
         }
     }
@@ -364,35 +390,36 @@ boolean Bluetooth::isDeviceConnected(String peerAddress)
     return isConnected;
 }
 
-float Bluetooth::getSensorValue(String peerAddress, uint8_t index)
+boolean Bluetooth::isDeviceConnected(String peerAddress)
 {
-    float value = INACTIVEVALUE;
-    const auto isKnownDevice = [peerAddress](BleDevice *d) {
-        return (peerAddress.equalsIgnoreCase(d->address));
-    };
+    return isDeviceConnected(getDeviceHandle(BleDeviceMap::parseMac(peerAddress.c_str())));
+}
 
-    auto it = std::find_if(bleDevices.begin(), bleDevices.end(), isKnownDevice);
+float Bluetooth::getSensorValue(BleDeviceType *device, uint8_t index)
+{
+    float value = INACTIVEVALUE;
 
-    if ((it != bleDevices.end()) && (index < BLE_SENSORS_MAX_COUNT))
+    if ((device != NULL) && (index < BLE_SENSORS_MAX_COUNT))
     {
-        value = (*it)->sensors[index];
+        value = device->sensors[index];
     }
 
     return value;
 }
 
+float Bluetooth::getSensorValue(String peerAddress, uint8_t index)
+{
+    return getSensorValue(getDeviceHandle(BleDeviceMap::parseMac(peerAddress.c_str())), index);
+}
+
 String Bluetooth::getSensorUnit(String peerAddress, uint8_t index)
 {
     char unit[BLE_SENSOR_UNIT_MAX_SIZE] = {0u};
-    const auto isKnownDevice = [peerAddress](BleDevice *d) {
-        return (peerAddress.equalsIgnoreCase(d->address));
-    };
-
-    auto it = std::find_if(bleDevices.begin(), bleDevices.end(), isKnownDevice);
+    BleDevice *bleDevice = getDeviceHandle(BleDeviceMap::parseMac(peerAddress.c_str()));
 
-    if ((it != bleDevices.end()) && (index < BLE_SENSORS_MAX_COUNT))
+    if ((bleDevice != NULL) && (index < BLE_SENSORS_MAX_COUNT))
     {
-        memcpy(unit, (*it)->units[index], BLE_SENSOR_UNIT_MAX_SIZE);
+        memcpy(unit, bleDevice->units[index], BLE_SENSOR_UNIT_MAX_SIZE);
     }
 
     return unit;
@@ -405,14 +432,14 @@ void Bluetooth::task(void *parameter)
 
     while (1)
     {
-        //Serial.printf("Bluetooth::task, highWaterMark: %d\n", uxTaskGetStackHighWaterMark(NULL));
-
         if (gSystem->otaUpdate.isUpdateInProgress())
         {
             // exit task loop for better update performance
             break;
         }
 
+        bluetoothMonitor.begin();
+
         // check if bluetooth has been enabled or disabled
         if (bluetooth->enabled != bluetooth->chipEnabled)
         {
@@ -424,9 +451,14 @@ void Bluetooth::task(void *parameter)
         {
             bluetooth->getDevices();
         }
-        vTaskDelay(TASK_CYCLE_TIME_BLUETOOTH_TASK);
+
+        bluetoothMonitor.end();
+
+        // Wait for the next cycle.
+        vTaskDelayUntil(&xLastWakeTime, TASK_CYCLE_TIME_BLUETOOTH_TASK);
     }
 
+    bluetoothMonitor.stop();
     Serial.println("Delete Bluetooth task");
     vTaskDelete(NULL);
 }
@@ -23,8 +23,11 @@
 #include <ArduinoJson.h>
 #include "fwu.h"
 #include "temperature/TemperatureGrp.h"
+#include "DeviceMap.h"
 
 #define BLUETOOTH_MAX_DEVICE_COUNT 4u
+// remote index is a bit in the uint32 request mask
+#define BLUETOOTH_DEVICE_MAP_SIZE 32u
 
 #define BLE_ADDRESS_STRING_MAX_SIZE 18u
 #define BLE_NAME_STRING_MAX_SIZE 18u
@@ -47,6 +50,8 @@ typedef struct BleDevice
     uint8_t remoteIndex;
 } BleDeviceType;
 
+typedef DeviceMap<BleDeviceType, BLUETOOTH_DEVICE_MAP_SIZE> BleDeviceMap;
+
 class Bluetooth
 {
 public:
@@ -61,14 +66,19 @@ public:
     uint8_t getDeviceCount();
     boolean getDevice(uint8_t index, BleDevice *device);
     void setDeviceSelected(String peerAddress, uint8_t selected);
+    static BleDeviceType *getDeviceHandle(uint64_t mac);
+    static boolean isDeviceConnected(BleDeviceType *device);
     static boolean isDeviceConnected(String peerAddress);
+    static float getSensorValue(BleDeviceType *device, uint8_t index);
     static float getSensorValue(String peerAddress, uint8_t index);
     static String getSensorUnit(String peerAddress, uint8_t index);
 
 private:
     static void dfuTxFunction(struct SFwu *fwu, uint8_t *buf, uint8_t len);
     uint8_t dfuRxFunction(uint8_t *data, int maxLen);
+    uint32_t getRequestedDevices();
     void getDevices();
+    static BleDeviceType *findDevice(const char *address, uint8_t remoteIndex);
     boolean waitForBootloader(uint32_t timeoutInMs);
     static void task(void *parameter);
     boolean doDfu();
@@ -79,5 +89,6 @@ private:
     boolean chipEnabled;
     boolean isNrf52840;
     static std::vector<BleDeviceType *> bleDevices;
+    static BleDeviceMap bleDeviceMap;
     static HardwareSerial *serialBle;
 };
\ No newline at end of file
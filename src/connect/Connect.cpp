@@ -22,8 +22,9 @@
 #include "temperature/TemperatureBase.h"
 #include "system/SystemBase.h"
 #include "Settings.h"
-#include "ArduinoLog.h"
+#include "EventLog.h"
 #include "TaskConfig.h"
+#include "TaskMonitor.h"
 #include <byteswap.h>
 #include <ESPmDNS.h>
 
@@ -35,18 +36,43 @@
 
 #define HTTP_STATUS_OK 200
 
+// seconds
+#define CONNECT_REQUEST_TIMEOUT 2
+// poll interval doubles with every failed request up to 32 s
+#define CONNECT_BACKOFF_MAX_SHIFT 5u
+#define CONNECT_PEER_OFFLINE_FAILURES 3u
+
 std::vector<ConnectDeviceType *> Connect::connectDevices;
+ConnectDeviceMap Connect::connectDeviceMap;
+ConnectServiceType Connect::services[CONNECT_PEER_MAX_COUNT];
+uint8_t Connect::serviceCount = 0u;
+boolean Connect::servicesUpdated = false;
+portMUX_TYPE Connect::servicesMux = portMUX_INITIALIZER_UNLOCKED;
 boolean Connect::enabled = true;
 
-asyncHTTPrequest deviceClient = asyncHTTPrequest();
+static TaskMonitor connectMonitor("Connect::task", TASK_CYCLE_TIME_CONNECT_TASK);
 
 Connect::Connect()
 {
+    // IPAddress is a class with a vtable, the peers can't be cleared with memset
+    for (uint8_t i = 0u; i < CONNECT_PEER_MAX_COUNT; i++)
+    {
+        this->peers[i].ip = IPAddress();
+        this->peers[i].mac = 0u;
+        this->peers[i].device = NULL;
+        this->peers[i].client = NULL;
+        this->peers[i].nextPoll = 0u;
+        this->peers[i].failures = 0u;
+        this->peers[i].busy = false;
+    }
+    this->peerCount = 0u;
 }
 
 void Connect::init()
 {
     xTaskCreatePinnedToCore(Connect::task, "Connect::task", 10000, this, TASK_PRIORITY_CONNECT_TASK, NULL, 1);
+    // mDNS queries block for a while, they must not delay the polling
+    xTaskCreatePinnedToCore(Connect::discoveryTask, "Connect::discovery", 4000, this, TASK_PRIORITY_CONNECT_DISCOVERY_TASK, NULL, 1);
 }
 
 void Connect::loadConfig(TemperatureGrp *temperatureGrp)
@@ -79,6 +105,12 @@ void Connect::loadConfig(TemperatureGrp *temperatureGrp)
                 connectDevice->count = json["tcount"][i];
                 connectDevice->selected = json["tselected"][i];
 
+                if (false == connectDeviceMap.put(ConnectDeviceMap::parseMac(connectDevice->address), connectDevice))
+                {
+                    delete connectDevice;
+                    continue;
+                }
+
                 for (uint8_t s = 0u; s < connectDevice->count; s++)
                 {
                     if (connectDevice->selected & (1 << s))
@@ -119,69 +151,226 @@ void Connect::saveConfig()
     Settings::write(kConnect, json);
 }
 
-void Connect::getDevices()
+void Connect::discover()
 {
-    if (false == gSystem->wlan.isConnected())
-        return;
+    ConnectServiceType found[CONNECT_PEER_MAX_COUNT];
+    uint64_t ownMac = ConnectDeviceMap::parseMac(Wlan::getMacAddress().c_str());
+    uint8_t foundCount = 0u;
 
     int nrOfServices = MDNS.queryService("wlanthermo", "tcp");
 
-    if (nrOfServices == 0)
+    for (int i = 0; (i < nrOfServices) && (foundCount < CONNECT_PEER_MAX_COUNT); i++)
     {
-        Serial.println("No services were found.");
+        if (false == MDNS.hasTxt(i, "mac_address"))
+            continue;
+
+        uint64_t mac = ConnectDeviceMap::parseMac(MDNS.txt(i, "mac_address").c_str());
+
+        if ((0u == mac) || (ownMac == mac))
+            continue;
+
+        found[foundCount].ip = MDNS.IP(i);
+        found[foundCount].mac = mac;
+        strncpy(found[foundCount].name, MDNS.hostname(i).c_str(), CONNECT_NAME_STRING_MAX_SIZE - 1u);
+        found[foundCount].name[CONNECT_NAME_STRING_MAX_SIZE - 1u] = '\0';
+        foundCount++;
     }
-    else
+
+    portENTER_CRITICAL(&servicesMux);
+    memcpy(services, found, sizeof(ConnectServiceType) * foundCount);
+    serviceCount = foundCount;
+    servicesUpdated = true;
+    portEXIT_CRITICAL(&servicesMux);
+}
+
+void Connect::discoveryTask(void *parameter)
+{
+    while (1)
     {
-        Serial.print("Number of services found: ");
-        Serial.println(nrOfServices);
+        uint32_t cycleTime = TASK_CYCLE_TIME_CONNECT_DISCOVERY_EMPTY;
 
-        for (int i = 0; i < nrOfServices; i = i + 1)
+        if (enabled && gSystem->wlan.isConnected())
         {
+            discover();
 
-            Serial.println("---------------");
+            // look again soon while nothing has been found
+            if (serviceCount > 0u)
+                cycleTime = TASK_CYCLE_TIME_CONNECT_DISCOVERY;
+        }
 
-            Serial.print("Hostname: ");
-            Serial.println(MDNS.hostname(i));
+        vTaskDelay(cycleTime);
+    }
+}
 
-            Serial.print("IP address: ");
-            Serial.println(MDNS.IP(i));
+ConnectDeviceType *Connect::addDevice(uint64_t mac, const char *name)
+{
+    ConnectDeviceType *connectDevice = connectDeviceMap.get(mac);
 
-            if (MDNS.hasTxt(i, "mac_address"))
-            {
-                Serial.print("MAC address: ");
-                Serial.println(MDNS.txt(i, "mac_address"));
+    if (connectDevice != NULL)
+        return connectDevice;
+
+    connectDevice = new ConnectDeviceType();
+    memset(connectDevice, 0, sizeof(ConnectDeviceType));
 
-                String url = "http://" + MDNS.IP(i).toString() + "/data";
-                deviceClient.onReadyStateChange(Connect::onReadyStateChange, NULL);
-                deviceClient.open("GET", url.c_str());
-                deviceClient.send();
+    for (uint8_t i = 0; i < CONNECT_TEMPERATURE_MAX_COUNT; i++)
+    {
+        connectDevice->temperatures[i] = INACTIVEVALUE;
+    }
+
+    strncpy(connectDevice->name, name, sizeof(connectDevice->name) - 1u);
+    snprintf(connectDevice->address, sizeof(connectDevice->address), "%02x:%02x:%02x:%02x:%02x:%02x",
+             (uint8_t)(mac >> 40), (uint8_t)(mac >> 32), (uint8_t)(mac >> 24), (uint8_t)(mac >> 16), (uint8_t)(mac >> 8), (uint8_t)mac);
+
+    if (false == connectDeviceMap.put(mac, connectDevice))
+    {
+        delete connectDevice;
+        return NULL;
+    }
+
+    connectDevices.push_back(connectDevice);
+
+    return connectDevice;
+}
+
+// takes over the services of the last discovery, peers keep their HTTP client and backoff
+void Connect::updatePeers()
+{
+    ConnectServiceType found[CONNECT_PEER_MAX_COUNT];
+    uint8_t foundCount = 0u;
+
+    portENTER_CRITICAL(&servicesMux);
+    if (servicesUpdated)
+    {
+        memcpy(found, services, sizeof(ConnectServiceType) * serviceCount);
+        foundCount = serviceCount;
+        servicesUpdated = false;
+    }
+    portEXIT_CRITICAL(&servicesMux);
+
+    for (uint8_t i = 0u; i < foundCount; i++)
+    {
+        ConnectPeerType *peer = NULL;
+
+        for (uint8_t p = 0u; p < this->peerCount; p++)
+        {
+            if (this->peers[p].mac == found[i].mac)
+            {
+                peer = &this->peers[p];
+                break;
             }
+        }
+
+        if ((NULL == peer) && (this->peerCount < CONNECT_PEER_MAX_COUNT))
+        {
+            ConnectDeviceType *device = addDevice(found[i].mac, found[i].name);
+
+            if (NULL == device)
+                continue;
+
+            peer = &this->peers[this->peerCount++];
+            peer->mac = found[i].mac;
+            peer->device = device;
+            peer->client = new asyncHTTPrequest();
+            peer->client->setTimeout(CONNECT_REQUEST_TIMEOUT);
+            peer->client->onReadyStateChange(Connect::onReadyStateChange, peer);
+            Log.notice("Connect: new peer %s (%s)" CR, found[i].name, device->address);
+        }
+        else if (NULL == peer)
+        {
+            continue;
+        }
 
-            Serial.println("---------------");
+        // address could have changed, reset backoff for a faster reconnect
+        if ((uint32_t)peer->ip != (uint32_t)found[i].ip)
+        {
+            peer->ip = found[i].ip;
+            peer->failures = 0u;
+            peer->nextPoll = millis();
         }
     }
 }
 
-void Connect::onReadyStateChange(void *optParm, asyncHTTPrequest *request, int readyState)
+// starts a request for every peer that is due, all requests run in parallel
+void Connect::pollPeers()
 {
-    if (READY_STATE_DONE == readyState)
+    uint32_t currentMillis = millis();
+
+    for (uint8_t p = 0u; p < this->peerCount; p++)
+    {
+        ConnectPeerType *peer = &this->peers[p];
+
+        if (peer->busy || ((int32_t)(currentMillis - peer->nextPoll) < 0))
+            continue;
+
+        uint8_t shift = min(peer->failures, (uint8_t)CONNECT_BACKOFF_MAX_SHIFT);
+        peer->nextPoll = currentMillis + (TASK_CYCLE_TIME_CONNECT_TASK << shift);
+
+        String url = "http://" + peer->ip.toString() + "/data";
+        peer->busy = true;
+
+        if ((false == peer->client->open("GET", url.c_str())) || (false == peer->client->send()))
+        {
+            updateDevice(peer, false, "");
+        }
+    }
+}
+
+void Connect::updateDevice(ConnectPeerType *peer, boolean success, String response)
+{
+    ConnectDeviceType *device = peer->device;
+
+    if (success)
     {
         DynamicJsonBuffer jsonBuffer;
-        JsonObject &json = jsonBuffer.parseObject(request->responseText());
+        JsonObject &json = jsonBuffer.parseObject(response);
+        success = json.success() && json.containsKey("channel");
+
+        if (success)
+        {
+            JsonArray &_channels = json["channel"].asArray();
+            uint8_t channelIndex = 0u;
+
+            for (JsonArray::iterator itChannel = _channels.begin(); (itChannel != _channels.end()) && (channelIndex < CONNECT_TEMPERATURE_MAX_COUNT); ++itChannel, channelIndex++)
+            {
+                JsonObject &_channel = itChannel->asObject();
+                device->temperatures[channelIndex] = _channel["temp"];
+            }
 
-        JsonArray &_channels = json["channel"].asArray();
-        uint8_t channelIndex = 0u;
+            device->count = channelIndex;
+            device->status = 1u;
+            peer->failures = 0u;
+        }
+    }
 
-        connectDevices[0]->status = 1u;
+    if (false == success)
+    {
+        if (peer->failures < UINT8_MAX)
+            peer->failures++;
 
-        for (JsonArray::iterator itChannel = _channels.begin(); itChannel != _channels.end(); ++itChannel, channelIndex++)
+        if (CONNECT_PEER_OFFLINE_FAILURES == peer->failures)
         {
-            JsonObject &_channel = itChannel->asObject();
-            connectDevices[0]->temperatures[channelIndex] = _channel["temp"];
-            Serial.println(connectDevices[0]->temperatures[channelIndex]);
+            device->status = 0u;
+
+            for (uint8_t i = 0; i < CONNECT_TEMPERATURE_MAX_COUNT; i++)
+            {
+                device->temperatures[i] = INACTIVEVALUE;
+            }
+
+            Log.warning("Connect: peer %s offline" CR, device->address);
         }
-        
-        request->abort();
+    }
+
+    peer->busy = false;
+}
+
+void Connect::onReadyStateChange(void *optParm, asyncHTTPrequest *request, int readyState)
+{
+    if (READY_STATE_DONE == readyState)
+    {
+        ConnectPeerType *peer = (ConnectPeerType *)optParm;
+        boolean success = (HTTP_STATUS_OK == request->responseHTTPcode());
+
+        updateDevice(peer, success, success ? request->responseText() : String());
     }
 }
 
@@ -205,52 +394,47 @@ boolean Connect::getDevice(uint8_t index, ConnectDevice *device)
 
 void Connect::setDeviceSelected(String peerAddress, uint8_t selected)
 {
-    const auto isKnownDevice = [peerAddress](ConnectDevice *d) {
-        return (peerAddress.equalsIgnoreCase(d->address));
-    };
-
-    auto it = std::find_if(connectDevices.begin(), connectDevices.end(), isKnownDevice);
+    ConnectDevice *connectDevice = getDeviceHandle(ConnectDeviceMap::parseMac(peerAddress.c_str()));
 
-    if (it != connectDevices.end())
+    if (connectDevice != NULL)
     {
-        (*it)->selected = selected;
+        connectDevice->selected = selected;
     }
 }
 
-boolean Connect::isDeviceConnected(String peerAddress)
+// handles stay valid, devices are never deleted
+ConnectDeviceType *Connect::getDeviceHandle(uint64_t mac)
 {
-    boolean isConnected = false;
-    const auto isKnownDevice = [peerAddress](ConnectDevice *d) {
-        return (peerAddress.equalsIgnoreCase(d->address));
-    };
-
-    auto it = std::find_if(connectDevices.begin(), connectDevices.end(), isKnownDevice);
+    return connectDeviceMap.get(mac);
+}
 
-    if (it != connectDevices.end())
-    {
-        isConnected = (boolean)(*it)->status;
-    }
+boolean Connect::isDeviceConnected(ConnectDeviceType *device)
+{
+    return (device != NULL) ? (boolean)device->status : false;
+}
 
-    return isConnected;
+boolean Connect::isDeviceConnected(String peerAddress)
+{
+    return isDeviceConnected(getDeviceHandle(ConnectDeviceMap::parseMac(peerAddress.c_str())));
 }
 
-float Connect::getTemperatureValue(String peerAddress, uint8_t index)
+float Connect::getTemperatureValue(ConnectDeviceType *device, uint8_t index)
 {
     float value = INACTIVEVALUE;
-    const auto isKnownDevice = [peerAddress](ConnectDevice *d) {
-        return (peerAddress.equalsIgnoreCase(d->address));
-    };
 
-    auto it = std::find_if(connectDevices.begin(), connectDevices.end(), isKnownDevice);
-
-    if ((it != connectDevices.end()) && (index < CONNECT_TEMPERATURE_MAX_COUNT))
+    if ((device != NULL) && (index < CONNECT_TEMPERATURE_MAX_COUNT))
     {
-        value = (*it)->temperatures[index];
+        value = device->temperatures[index];
     }
 
     return value;
 }
 
+float Connect::getTemperatureValue(String peerAddress, uint8_t index)
+{
+    return getTemperatureValue(getDeviceHandle(ConnectDeviceMap::parseMac(peerAddress.c_str())), index);
+}
+
 void Connect::task(void *parameter)
 {
     TickType_t xLastWakeTime = xTaskGetTickCount();
@@ -258,7 +442,15 @@ void Connect::task(void *parameter)
 
     while (1)
     {
-        connect->getDevices();
-        vTaskDelay(TASK_CYCLE_TIME_CONNECT_TASK);
+        connectMonitor.begin();
+
+        if (enabled && gSystem->wlan.isConnected())
+        {
+            connect->updatePeers();
+            connect->pollPeers();
+        }
+
+        connectMonitor.end();
+        vTaskDelayUntil(&xLastWakeTime, TASK_CYCLE_TIME_CONNECT_TASK);
     }
 }
@@ -22,11 +22,15 @@
 #include "Arduino.h"
 #include <ArduinoJson.h>
 #include <asyncHTTPrequest.h>
+#include <IPAddress.h>
 #include "temperature/TemperatureGrp.h"
+#include "DeviceMap.h"
 
 #define CONNECT_ADDRESS_STRING_MAX_SIZE 18u
 #define CONNECT_NAME_STRING_MAX_SIZE 18u
 #define CONNECT_TEMPERATURE_MAX_COUNT 32u
+#define CONNECT_DEVICE_MAP_SIZE 16u
+#define CONNECT_PEER_MAX_COUNT 8u
 
 typedef float (*BleGetTemperatureValue_t)(String, uint8_t);
 
@@ -40,6 +44,28 @@ typedef struct ConnectDevice
     uint8_t status;
 } ConnectDeviceType;
 
+typedef DeviceMap<ConnectDeviceType, CONNECT_DEVICE_MAP_SIZE> ConnectDeviceMap;
+
+// thermometer found by mDNS
+typedef struct ConnectService
+{
+    IPAddress ip;
+    uint64_t mac;
+    char name[CONNECT_NAME_STRING_MAX_SIZE];
+} ConnectServiceType;
+
+// polled thermometer with its own HTTP client
+typedef struct ConnectPeer
+{
+    IPAddress ip;
+    uint64_t mac;
+    ConnectDeviceType *device;
+    asyncHTTPrequest *client;
+    uint32_t nextPoll;
+    uint8_t failures;
+    volatile boolean busy;
+} ConnectPeerType;
+
 class Connect
 {
 public:
@@ -50,13 +76,28 @@ public:
     uint8_t getDeviceCount();
     boolean getDevice(uint8_t index, ConnectDevice *device);
     void setDeviceSelected(String peerAddress, uint8_t selected);
+    static ConnectDeviceType *getDeviceHandle(uint64_t mac);
+    static boolean isDeviceConnected(ConnectDeviceType *device);
     static boolean isDeviceConnected(String peerAddress);
+    static float getTemperatureValue(ConnectDeviceType *device, uint8_t index);
     static float getTemperatureValue(String peerAddress, uint8_t index);
 
 private:
-    void getDevices();
+    void updatePeers();
+    void pollPeers();
+    static ConnectDeviceType *addDevice(uint64_t mac, const char *name);
+    static void updateDevice(ConnectPeerType *peer, boolean success, String response);
+    static void discover();
+    static void discoveryTask(void *parameter);
     static void task(void *parameter);
     static void onReadyStateChange(void *optParm, asyncHTTPrequest *request, int readyState);
     static boolean enabled;
     static std::vector<ConnectDeviceType *> connectDevices;
+    static ConnectDeviceMap connectDeviceMap;
+    static ConnectServiceType services[CONNECT_PEER_MAX_COUNT];
+    static uint8_t serviceCount;
+    static boolean servicesUpdated;
+    static portMUX_TYPE servicesMux;
+    ConnectPeerType peers[CONNECT_PEER_MAX_COUNT];
+    uint8_t peerCount;
 };
\ No newline at end of file
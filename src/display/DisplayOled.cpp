@@ -25,6 +25,7 @@
 #include "Settings.h"
 #include "Version.h"
 #include "TaskConfig.h"
+#include "BusLock.h"
 
 #define MAXBATTERYBAR 13u
 #define OLIMITMIN 35.0
@@ -163,9 +164,9 @@ void DisplayOled::task(void *parameter)
   uint8_t bootScreenTimeout = OLED_BOOT_SCREEN_TIME;
   DisplayOled *display = (DisplayOled *)parameter;
 
-  display->system->wireLock();
+  gI2cBus.lock();
   display->initDisplay();
-  display->system->wireRelease();
+  gI2cBus.release();
 
   // show boot screen
   while (bootScreenTimeout || display->system->isInitDone() != true)
@@ -186,9 +187,9 @@ void DisplayOled::task(void *parameter)
       /* Do nothing */
     }
 
-    display->system->wireLock();
+    gI2cBus.lock();
     display->update();
-    display->system->wireRelease();
+    gI2cBus.release();
 
     if ((millis() - flashTimeout) >= OLED_FLASH_INTERVAL)
     {
@@ -25,6 +25,7 @@
 #include "Settings.h"
 #include "Version.h"
 #include "TaskConfig.h"
+#include "BusLock.h"
 
 #define MAXBATTERYBAR 13u
 #define OLIMITMIN 35.0
@@ -141,9 +142,9 @@ void DisplayOledLink::task(void *parameter)
   uint8_t bootScreenTimeout = OLED_BOOT_SCREEN_TIME;
   DisplayOledLink *display = (DisplayOledLink *)parameter;
 
-  display->system->wireLock();
+  gI2cBus.lock();
   display->initDisplay();
-  display->system->wireRelease();
+  gI2cBus.release();
 
   // show boot screen
   while (bootScreenTimeout || display->system->isInitDone() != true)
@@ -155,9 +156,9 @@ void DisplayOledLink::task(void *parameter)
 
   for (;;)
   {
-    display->system->wireLock();
+    gI2cBus.lock();
     display->update();
-    display->system->wireRelease();
+    gI2cBus.release();
 
     if (!flashTimeout--)
     {
@@ -25,6 +25,7 @@
 #include "lvScreen.h"
 #include "lvTheme.h"
 #include "PCA9533.h"
+#include "BusLock.h"
 
 #define TFT_TOUCH_CALIBRATION_ARRAY_SIZE 5u
 #define I2C_BRIGHTNESS_CONTROL_ADDRESS 0x0D
@@ -167,9 +168,11 @@ void DisplayTft::setBrightness(uint8_t brightness)
   this->brightness = brightness;
   int value = (int)(this->brightness * 2.55);
 
+  gI2cBus.lock();
   Wire.beginTransmission(I2C_BRIGHTNESS_CONTROL_ADDRESS);
   Wire.write(value);
   Wire.endTransmission();
+  gI2cBus.release();
 }
 
 uint8_t DisplayTft::getBrightness()
@@ -180,9 +183,11 @@ uint8_t DisplayTft::getBrightness()
 void DisplayTft::drawCharging()
 {
   // set brightness
+  gI2cBus.lock();
   Wire.beginTransmission(I2C_BRIGHTNESS_CONTROL_ADDRESS);
   Wire.write(0);
   Wire.endTransmission();
+  gI2cBus.release();
 
   tft.init();
   tft.setRotation(1);
@@ -190,9 +195,11 @@ void DisplayTft::drawCharging()
   tft.fillScreen(TFT_BLACK);
 
   // set brightness
+  gI2cBus.lock();
   Wire.beginTransmission(I2C_BRIGHTNESS_CONTROL_ADDRESS);
   Wire.write(100);
   Wire.endTransmission();
+  gI2cBus.release();
 
   if (gSystem->battery->isCharging())
   {
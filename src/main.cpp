@@ -23,24 +23,18 @@
 #include "display/DisplayBase.h"
 #include "SerialCmd.h"
 #include "WServer.h"
+#include "WebEvents.h"
 #include "DbgPrint.h"
-#include "ArduinoLog.h"
-#include "LogRingBuffer.h"
+#include "EventLog.h"
 #include "TaskConfig.h"
+#include "TaskMonitor.h"
 #include "DeviceId.h"
 
 // Forward declaration
 void createTasks();
 
-void loggingPrefix(Print *p)
-{
-  time_t t = now();
-
-  if (year(t) > 2000)
-  {
-    p->printf("%02d:%02d:%02d: ", hour(t), minute(t), second(t));
-  }
-}
+static TaskMonitor mainMonitor("MainTask", TASK_CYCLE_TIME_MAIN_TASK);
+static TaskMonitor connectMonitor("ConnectTask", TASK_CYCLE_TIME_CONNECT_TASK);
 
 //++++++++++++++++++++++++++++++++++++++++++++++++++++++
 // SETUP
@@ -52,8 +46,8 @@ void setup()
   // Initialize Serial
   Serial.begin(115200);
   Serial.setDebugOutput(true);
+  gLogRingBuffer.begin();
   Log.begin(LOG_LEVEL_TRACE, &gLogRingBuffer);
-  Log.setPrefix(loggingPrefix);
   Log.notice("Start logging" CR);
 
   gSystem->hwInit();
@@ -86,8 +80,6 @@ void MainTask(void *parameter)
 
   for (;;)
   {
-    //Serial.printf("MainTask, highWaterMark: %d\n", uxTaskGetStackHighWaterMark(NULL));
-
     if (gSystem->otaUpdate.isUpdateInProgress())
     {
       // exit task loop for better update performance
@@ -100,6 +92,8 @@ void MainTask(void *parameter)
       break;
     }
 
+    mainMonitor.begin();
+
     // Detect Serial Input
     static char serialbuffer[300];
     if (readline(Serial.read(), serialbuffer, 300) > 0)
@@ -107,10 +101,13 @@ void MainTask(void *parameter)
       read_serial(serialbuffer);
     }
 
+    mainMonitor.end();
+
     // Wait for the next cycle.
     vTaskDelayUntil(&xLastWakeTime, TASK_CYCLE_TIME_MAIN_TASK);
   }
 
+  mainMonitor.stop();
   Serial.println("Delete MainTask task");
   vTaskDelete(NULL);
 }
@@ -121,29 +118,37 @@ void ConnectTask(void *parameter)
 
   for (;;)
   {
-    //Serial.printf("ConnectTask, highWaterMark: %d\n", uxTaskGetStackHighWaterMark(NULL));
-
     if (gSystem->otaUpdate.isUpdateInProgress())
     {
       // exit task loop for better update performance
       break;
     }
 
+    connectMonitor.begin();
+
     // WiFi - Monitoring
     gSystem->wlan.update();
 
+    // Push changes to web clients, also in AP mode
+    gWebEvents.update();
+
     if (gSystem->wlan.isConnected())
     {
       gSystem->otaUpdate.update();
       gSystem->mqtt.update();
       gSystem->notification.update();
-      gSystem->cloud.update();
     }
 
+    // buffers the cloud samples while offline
+    gSystem->cloud.update();
+
+    connectMonitor.end();
+
     // Wait for the next cycle.
     vTaskDelayUntil(&xLastWakeTime, TASK_CYCLE_TIME_CONNECT_TASK);
   }
 
+  connectMonitor.stop();
   Serial.println("Delete ConnectTask task");
   vTaskDelete(NULL);
 }
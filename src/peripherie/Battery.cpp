@@ -25,7 +25,7 @@
 #include "display/DisplayBase.h"
 #include "Settings.h"
 #include <esp_adc_cal.h>
-#include "ArduinoLog.h"
+#include "EventLog.h"
 
 #define BATTERY_ADC_IO 39u
 #define BATTERTY_CHARGE_IO 35u
@@ -18,9 +18,13 @@
     
 ****************************************************/
 #include "SdCard.h"
+#include "TaskConfig.h"
+#include "EventLog.h"
 #include <SD.h>
 
 #define DB_HISTORY_FILE "/history.bin"
+#define SDCARD_QUEUE_LENGTH 10u
+#define SDCARD_FLUSH_INTERVAL 60000u // ms
 
 SdCard::SdCard()
 {
@@ -28,9 +32,104 @@ SdCard::SdCard()
 
 SdCard::SdCard(uint8_t csPin)
 {
-  SD.begin(csPin);
+  this->csPin = csPin;
+  this->sampleQueue = NULL;
+  this->block = NULL;
+  this->encoder = NULL;
+  this->blockIndex = 0u;
+  this->lastFlush = 0u;
+  this->droppedSamples = 0u;
+
+  if (false == SD.begin(csPin))
+  {
+    Log.warning("SD card not available" CR);
+    return;
+  }
+
   uint64_t cardSize = SD.cardSize() / (1024 * 1024);
   Serial.printf("SD card size: %lluMB\n", cardSize);
+
+  // continue behind the last block, a partial block from before a reset stays as it is
+  File file = SD.open(DB_HISTORY_FILE);
+  this->blockIndex = CookLog::getBlockCount(file, SDCARD_COOKLOG_BLOCK_SIZE);
+  file.close();
+
+  this->block = new uint8_t[SDCARD_COOKLOG_BLOCK_SIZE];
+  this->encoder = new CookLogEncoder(this->block, SDCARD_COOKLOG_BLOCK_SIZE);
+  this->sampleQueue = xQueueCreate(SDCARD_QUEUE_LENGTH, sizeof(CookLogSample));
+
+  xTaskCreatePinnedToCore(SdCard::task, "SdCard::task", 4096, this, TASK_PRIORITY_SDCARD_TASK, NULL, 0);
+}
+
+// called from the system task, never blocks
+boolean SdCard::log(CookLogSample *sample)
+{
+  if (NULL == this->sampleQueue)
+    return false;
+
+  if (xQueueSend(this->sampleQueue, sample, 0) != pdTRUE)
+  {
+    this->droppedSamples++;
+    return false;
+  }
+
+  return true;
+}
+
+void SdCard::task(void *parameter)
+{
+  SdCard *sdCard = (SdCard *)parameter;
+  CookLogSample sample;
+
+  for (;;)
+  {
+    if (xQueueReceive(sdCard->sampleQueue, &sample, TASK_CYCLE_TIME_SDCARD_TASK) == pdTRUE)
+    {
+      sdCard->writeSample(&sample);
+    }
+
+    // write the current block from time to time, so not more than one interval is lost on power off
+    if (((millis() - sdCard->lastFlush) > SDCARD_FLUSH_INTERVAL) && (false == sdCard->encoder->isEmpty()))
+    {
+      sdCard->writeBlock();
+    }
+  }
+}
+
+void SdCard::writeSample(CookLogSample *sample)
+{
+  if (this->encoder->add(sample))
+    return;
+
+  // block is full or the series have changed
+  if (false == this->encoder->isEmpty())
+  {
+    this->writeBlock();
+    this->blockIndex++;
+  }
+
+  this->encoder->reset(sample->count, sample->unit);
+  this->encoder->add(sample);
+}
+
+boolean SdCard::writeBlock()
+{
+  this->encoder->finish();
+  this->lastFlush = millis();
+
+  File file = SD.open(DB_HISTORY_FILE, SD.exists(DB_HISTORY_FILE) ? "r+" : FILE_WRITE);
+
+  if (!file)
+  {
+    Log.warning("SD card: open %s failed" CR, DB_HISTORY_FILE);
+    return false;
+  }
+
+  boolean success = file.seek(this->blockIndex * SDCARD_COOKLOG_BLOCK_SIZE) &&
+                    (file.write(this->block, SDCARD_COOKLOG_BLOCK_SIZE) == SDCARD_COOKLOG_BLOCK_SIZE);
+  file.close();
+
+  return success;
 }
 
 File SdCard::getHistoryData()
@@ -38,3 +137,9 @@ File SdCard::getHistoryData()
   return SD.open(DB_HISTORY_FILE);
 }
 
+CookLogStream *SdCard::createLogStream(uint32_t from)
+{
+  CookLogStream *stream = new CookLogStream(SD, SDCARD_COOKLOG_BLOCK_SIZE, from);
+  stream->addFile(DB_HISTORY_FILE);
+  return stream;
+}
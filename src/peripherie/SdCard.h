@@ -21,15 +21,30 @@
 
 #include "Arduino.h"
 #include <FS.h>
+#include "CookLog.h"
+
+#define SDCARD_COOKLOG_BLOCK_SIZE 512u
 
 class SdCard
 {
 public:
   SdCard();
   SdCard(uint8_t csPin);
+  boolean log(CookLogSample *sample);
+  uint32_t getDroppedSamples() { return this->droppedSamples; };
 
   File getHistoryData();
+  CookLogStream *createLogStream(uint32_t from);
 
 private:
+  static void task(void *parameter);
+  void writeSample(CookLogSample *sample);
+  boolean writeBlock();
   uint8_t csPin;
+  QueueHandle_t sampleQueue;
+  uint8_t *block;
+  CookLogEncoder *encoder;
+  uint32_t blockIndex;
+  uint32_t lastFlush;
+  uint32_t droppedSamples;
 };
@@ -21,7 +21,7 @@
 #include "Pitmaster.h"
 #include "DbgPrint.h"
 #include "math.h"
-#include "ArduinoLog.h"
+#include "EventLog.h"
 
 #define PIDKIMAX 95 // ANTI WINDUP LIMIT MAX
 #define PIDKIMIN 0  // ANTI WINDUP LIMIT MIN
@@ -47,7 +47,6 @@
 #define ATOVERTEMP 30             // AUTOTUNE OVERTEMPERATURE LIMIT
 #define ATTIMELIMIT 120L * 60000L // AUTOTUNE TIMELIMIT
 
-#define MEDIAN_SIZE 10u
 #define PM_DEFAULT_DCOUNT 15u
 #define PM_DEFAULT_DCOUNT_MIN 1u
 #define PM_DEFAULT_DCOUNT_MAX 60u
@@ -90,15 +89,13 @@ Pitmaster::Pitmaster(uint8_t ioPin1, uint8_t channel1, uint8_t ioPin2, uint8_t c
     this->channel2 = channel2;
     this->initActuator = NOAR;
     this->globalIndex = this->globalIndexTracker++;
-    this->registeredCb = NULL;
     this->settingsChanged = false;
-    this->registeredCbUserData = NULL;
     this->cbValue = 0u;
-    this->medianValue = new MedianFilter<float>(MEDIAN_SIZE);
     this->ecount = PM_DEFAULT_DCOUNT;
     this->dCount = PM_DEFAULT_DCOUNT;
     this->edif = 0;
     this->jump = 0;
+    this->pidTerms = {0.0f, 0.0f, 0.0f};
 
     this->servoDcMin = PM_DEFAULT_SERVO_MIN_DUTY_CYCLE;
     this->servoDcMax = PM_DEFAULT_SERVO_MAX_DUTY_CYCLE;
@@ -235,29 +232,35 @@ void Pitmaster::setDCount(uint8_t dCount)
 
 void Pitmaster::registerCallback(PitmasterCallback_t callback, void *userData)
 {
-    this->registeredCb = callback;
-    this->registeredCbUserData = userData;
+    PitmasterCallbackDataType newCallbackData = {callback, userData};
+    this->registeredCb.push_back(newCallbackData);
 }
 
-void Pitmaster::unregisterCallback()
+void Pitmaster::unregisterCallback(PitmasterCallback_t callback)
 {
-    this->registeredCb = NULL;
+    for (auto it = this->registeredCb.begin(); it != this->registeredCb.end();)
+    {
+        if (it->cb == callback)
+            it = this->registeredCb.erase(it);
+        else
+            ++it;
+    }
 }
 
 void Pitmaster::handleCallbacks()
 {
-    if (this->registeredCb != NULL)
+    if (this->registeredCb.empty())
+        return;
+
+    if ((true == settingsChanged) || (cbValue != value))
     {
-        if (true == settingsChanged)
+        for (auto const &cbData : this->registeredCb)
         {
-            this->registeredCb(this, settingsChanged, this->registeredCbUserData);
-            settingsChanged = false;
-        }
-        else if (cbValue != value)
-        {
-            this->registeredCb(this, settingsChanged, this->registeredCbUserData);
-            cbValue = this->value;
+            cbData.cb(this, settingsChanged, cbData.userData);
         }
+
+        settingsChanged = false;
+        cbValue = this->value;
     }
 }
 
@@ -906,7 +909,7 @@ float Pitmaster::pidCalc()
     // see: http://rn-wissen.de/wiki/index.php/Regelungstechnik
     // see: http://www.ni.com/white-paper/3782/en/
 
-    float x = medianValue->AddValue(this->temperature->getValue()); // IST
+    float x = medianValue.addValue(this->temperature->getValue()); // IST
     //Serial.printf("GetMedianValue: %f\n", x);
     float w = this->targetTemperature; // SOLL
     
@@ -1028,6 +1031,8 @@ float Pitmaster::pidCalc()
         this->Ki_alt = 0;
     }
 
+    this->pidTerms = {p_out, i_out, d_out};
+
     // PID-Regler berechnen
     float y = p_out + i_out + d_out;
     y = constrain(y, PITMIN, PITMAX); // Auflösung am Ausgang ist begrenzt
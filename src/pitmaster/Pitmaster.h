@@ -21,10 +21,12 @@
 
 #include "Arduino.h"
 #include "temperature/TemperatureBase.h"
-#include "MedianFilterLib.h"
+#include "SlidingMedian.h"
+#include <vector>
 
 #define SERVOPULSMIN 550u
 #define SERVOPULSMAX 2250u
+#define PITMASTER_MEDIAN_SIZE 10u
 
 typedef struct TPitmasterProfile
 {
@@ -44,6 +46,14 @@ typedef struct TPitmasterProfile
   byte autotune;
 } PitmasterProfile;
 
+// output parts of the last PID calculation
+typedef struct
+{
+  float p;
+  float i;
+  float d;
+} PitmasterPidTerms;
+
 typedef struct TDutyCycleTest
 {
   unsigned long timer; // SHUTDOWN TIMER
@@ -80,6 +90,12 @@ typedef struct TOpenLid
 
 typedef void (*PitmasterCallback_t)(class Pitmaster *, boolean, void *);
 
+typedef struct PitmasterCallbackData
+{
+  PitmasterCallback_t cb;
+  void *userData;
+} PitmasterCallbackDataType;
+
 enum PitmasterType
 {
   pm_off = 0,
@@ -122,6 +138,7 @@ public:
   uint8_t getDCount() { return this->dCount; }
   boolean getOPLStatus();
   float getOPLTemperature();
+  PitmasterPidTerms getPidTerms() { return this->pidTerms; };
   uint8_t getGlobalIndex() { return this->globalIndex; };
   bool startDutyCycleTest(uint8_t actuator, uint8_t value);
   bool startAutoTune();
@@ -131,7 +148,7 @@ public:
   boolean isDutyCycleTestRunning();
   boolean isAutoTuneRunning();
   void registerCallback(PitmasterCallback_t callback, void *userData);
-  void unregisterCallback();
+  void unregisterCallback(PitmasterCallback_t callback);
   void handleCallbacks();
   static void setSupplyPin(uint8_t ioPin);
   void virtual update();
@@ -161,11 +178,10 @@ private:
   uint8_t channel1;
   uint8_t channel2;
   PitMasterActuator initActuator;
-  PitmasterCallback_t registeredCb;
+  std::vector<PitmasterCallbackDataType> registeredCb;
   boolean settingsChanged;
-  void *registeredCbUserData;
   float cbValue;
-  MedianFilter<float> *medianValue;
+  SlidingMedian<float, PITMASTER_MEDIAN_SIZE> medianValue;
 
   // all pitmasters objects will share one supply IO
   static uint8_t ioSupply;
@@ -176,6 +192,7 @@ private:
 
   float value;
 
+  PitmasterPidTerms pidTerms;
   float esum;   // PITMASTER I-PART DIFFERENZ SUM
   float elast;  // PITMASTER D-PART DIFFERENZ LAST
   float Ki_alt; // PITMASTER I-PART CACHE
@@ -21,7 +21,7 @@
 #include "PitmasterGrp.h"
 #include "system/SystemBase.h"
 #include "Settings.h"
-#include "ArduinoLog.h"
+#include "EventLog.h"
 
 PitmasterGrp::PitmasterGrp()
 {
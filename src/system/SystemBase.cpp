@@ -26,15 +26,23 @@
 #include "Constants.h"
 #include "RecoveryMode.h"
 #include "TaskConfig.h"
-#include "ArduinoLog.h"
+#include "EventLog.h"
+#include "TaskMonitor.h"
 
 #define STRINGIFY(s) #s
 
 #define CHECK_CYCLE(a, b) (!(a % b))
 #define ONCE_PER_SECOND_CYCLE (1000 / TASK_CYCLE_TIME_SYSTEM_TASK)
+#define COOKLOG_MIN_TIME 1577836800u // 01.01.2020, time is not synchronized before
 
 char SystemBase::serialNumber[13] = "";
 
+static TaskMonitor systemMonitor("SystemBase::task", TASK_CYCLE_TIME_SYSTEM_TASK);
+static TaskSection temperatureUpdateSection("temperature_update");
+static TaskSection temperatureRefreshSection("temperature_refresh");
+static TaskSection pitmasterSection("pitmaster");
+static TaskSection notificationSection("notification");
+
 SystemBase::SystemBase()
 {
   buzzer = NULL;
@@ -43,6 +51,7 @@ SystemBase::SystemBase()
   bluetooth = NULL;
   connect = NULL;
   sdCard = NULL;
+  spiffsHistory = NULL;
   deviceName = "undefined";
   cpuName = "esp32";
   language = "de";
@@ -55,8 +64,6 @@ SystemBase::SystemBase()
   initDone = false;
   disableTypeK = false;
   disableReceiver = false;
-  wireSemaHandle = xSemaphoreCreateMutex();
-  esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "NULL", &this->wirePmHandle);
 }
 
 void SystemBase::init()
@@ -69,7 +76,14 @@ void SystemBase::hwInit()
 
 void SystemBase::run()
 {
-  xTaskCreatePinnedToCore(SystemBase::task, "SystemBase::task", 3000, this, TASK_PRIORITY_SYSTEM_TASK, NULL, 1);
+  // boards without sd card keep the cook log on SPIFFS
+  if (NULL == sdCard)
+  {
+    spiffsHistory = new SpiffsHistory();
+  }
+
+  // SPIFFS writes of the standby and restart paths run in this task
+  xTaskCreatePinnedToCore(SystemBase::task, "SystemBase::task", 4096, this, TASK_PRIORITY_SYSTEM_TASK, NULL, 1);
 }
 
 void SystemBase::task(void *parameter)
@@ -79,12 +93,9 @@ void SystemBase::task(void *parameter)
 
   for (;;)
   {
-    //Serial.printf("SystemBase::task, highWaterMark: %d\n", uxTaskGetStackHighWaterMark(NULL));
-
-    uint32_t time = esp_timer_get_time();
+    systemMonitor.begin();
     system->update();
-    time = esp_timer_get_time() - time;
-    //printf("Performance: %dus\n", time);
+    systemMonitor.end();
 
     // Wait for the next cycle.
     vTaskDelayUntil(&xLastWakeTime, TASK_CYCLE_TIME_SYSTEM_TASK);
@@ -123,6 +134,11 @@ void SystemBase::update()
 
     if (battery->requestsStandby())
     {
+      if (spiffsHistory != NULL)
+        spiffsHistory->flush();
+
+      cloud.getBuffer()->flush();
+
       esp_sleep_enable_timer_wakeup(10);
       esp_deep_sleep_start();
     }
@@ -140,15 +156,31 @@ void SystemBase::update()
     }
   }
 
-  this->wireLock();
+  // the chips lock their bus themselves
+  temperatureUpdateSection.begin();
   temperatures.update();
-  this->wireRelease();
+  temperatureUpdateSection.end();
 
   if (CHECK_CYCLE(cycleCounter, ONCE_PER_SECOND_CYCLE))
   {
+    temperatureRefreshSection.begin();
     temperatures.refresh();
+    temperatureRefreshSection.end();
+
+    pitmasterSection.begin();
     pitmasters.update();
+    pitmasterSection.end();
+
+    CookLogSample sample;
+    if (getCookLogSample(&sample))
+    {
+      if (sdCard != NULL)
+        sdCard->log(&sample);
+      else if (spiffsHistory != NULL)
+        spiffsHistory->log(&sample);
+    }
 
+    notificationSection.begin();
     for (uint8_t i = 0; i < temperatures.count(); i++)
     {
       if (temperatures[i] != NULL)
@@ -164,6 +196,7 @@ void SystemBase::update()
         }
       }
     }
+    notificationSection.end();
 
     if (buzzer != NULL)
     {
@@ -250,24 +283,43 @@ boolean SystemBase::isInitDone()
 
 void SystemBase::restart()
 {
+  if (spiffsHistory != NULL)
+    spiffsHistory->flush();
+
+  cloud.getBuffer()->flush();
+
   WiFi.disconnect();
   delay(500);
   yield();
   ESP.restart();
 }
 
-void SystemBase::wireLock()
+boolean SystemBase::getCookLogSample(CookLogSample *sample)
 {
-  esp_pm_lock_acquire(this->wirePmHandle);
-  xSemaphoreTake(this->wireSemaHandle, portMAX_DELAY);
-}
+  time_t now = time(NULL);
 
-void SystemBase::wireRelease()
-{
-  xSemaphoreGive(this->wireSemaHandle);
-  esp_pm_lock_release(this->wirePmHandle);
+  if (now < COOKLOG_MIN_TIME)
+    return false;
+
+  sample->time = now;
+  sample->unit = (uint8_t)temperatures.getUnit();
+  sample->count = 0u;
+
+  for (uint8_t i = 0u; (i < temperatures.count()) && (sample->count < COOKLOG_MAX_SERIES); i++)
+  {
+    sample->values[sample->count++] = temperatures[i]->getValue();
+  }
+
+  for (uint8_t i = 0u; (i < pitmasters.count()) && ((sample->count + 1u) < COOKLOG_MAX_SERIES); i++)
+  {
+    sample->values[sample->count++] = pitmasters[i]->getValue();
+    sample->values[sample->count++] = pitmasters[i]->getTargetTemperature();
+  }
+
+  return true;
 }
 
+
 String SystemBase::getDeviceName()
 {
   return this->deviceName;
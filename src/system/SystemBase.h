@@ -34,6 +34,7 @@
 #include "Mqtt.h"
 #include "OtaUpdate.h"
 #include "Item.h"
+#include "SpiffsHistory.h"
 
 #define MAX_PITMASTERS 2u
 #define MAX_PITMASTERPROFILES 4u
@@ -55,9 +56,9 @@ public:
   Notification notification;
   Wlan wlan;
   SdCard *sdCard;
+  SpiffsHistory *spiffsHistory;
   void restart();
-  void wireLock();
-  void wireRelease();
+  boolean getCookLogSample(CookLogSample *sample);
   void run();
 
   String getDeviceName();
@@ -99,8 +100,6 @@ protected:
   boolean initDone;
   boolean disableTypeK;
   boolean disableReceiver;
-  SemaphoreHandle_t wireSemaHandle;
-  esp_pm_lock_handle_t wirePmHandle;
 
 private:
   static void task(void *parameter);
@@ -75,11 +75,11 @@ void SystemLinkV1::init()
   wlan.setHostName(DEFAULT_HOSTNAME + String(serialNumber));
 
   // initialize temperatures
-  this->wireLock();
-  temperatures.add(new TemperatureMax11613(0u, &Wire));
-  temperatures.add(new TemperatureMax11613(1u, &Wire));
-  temperatures.add(new TemperatureMax11613(2u, &Wire));
-  this->wireRelease();
+  TemperatureMax1161x *max11613 = new TemperatureMax1161x(MAX11613_ADDRESS, MAX11613_CHANNELS, &Wire);
+  temperatures.addChip(max11613);
+  temperatures.add(new TemperatureMax11613(0u, max11613));
+  temperatures.add(new TemperatureMax11613(1u, max11613));
+  temperatures.add(new TemperatureMax11613(2u, max11613));
 
   // add blutetooth feature
   bluetooth = new Bluetooth(BLE_UART_RX, BLE_UART_TX, BLE_RESET_PIN);
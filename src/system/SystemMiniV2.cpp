@@ -88,14 +88,16 @@ void SystemMiniV2::init()
   Wire.begin();
 
   // initialize temperatures
-  temperatures.add(new TemperatureMcp3208(0u, CS_MCP3208));
-  temperatures.add(new TemperatureMcp3208(1u, CS_MCP3208));
-  temperatures.add(new TemperatureMcp3208(2u, CS_MCP3208));
-  temperatures.add(new TemperatureMcp3208(3u, CS_MCP3208));
-  temperatures.add(new TemperatureMcp3208(4u, CS_MCP3208));
-  temperatures.add(new TemperatureMcp3208(5u, CS_MCP3208));
-  temperatures.add(new TemperatureMcp3208(6u, CS_MCP3208));
-  temperatures.add(new TemperatureMcp3208(7u, CS_MCP3208));
+  TemperatureMcp3208Chip *mcp3208 = new TemperatureMcp3208Chip(CS_MCP3208, MCP3208_MAX_CHANNELS);
+  temperatures.addChip(mcp3208);
+  temperatures.add(new TemperatureMcp3208(0u, mcp3208));
+  temperatures.add(new TemperatureMcp3208(1u, mcp3208));
+  temperatures.add(new TemperatureMcp3208(2u, mcp3208));
+  temperatures.add(new TemperatureMcp3208(3u, mcp3208));
+  temperatures.add(new TemperatureMcp3208(4u, mcp3208));
+  temperatures.add(new TemperatureMcp3208(5u, mcp3208));
+  temperatures.add(new TemperatureMcp3208(6u, mcp3208));
+  temperatures.add(new TemperatureMcp3208(7u, mcp3208));
 
   if (false == disableTypeK)
   {
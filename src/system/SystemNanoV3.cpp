@@ -97,16 +97,16 @@ void SystemNanoVx::init()
   wlan.setHostName(DEFAULT_HOSTNAME + String(serialNumber));
 
   // initialize temperatures
-  this->wireLock();
-  temperatures.add(new TemperatureMax11615(0u, &Wire));
-  temperatures.add(new TemperatureMax11615(1u, &Wire));
-  temperatures.add(new TemperatureMax11615(2u, &Wire));
-  temperatures.add(new TemperatureMax11615(3u, &Wire));
-  temperatures.add(new TemperatureMax11615(4u, &Wire));
-  temperatures.add(new TemperatureMax11615(5u, &Wire));
-  temperatures.add(new TemperatureMax11615(6u, &Wire));
-  temperatures.add(new TemperatureMax11615(7u, &Wire));
-  this->wireRelease();
+  TemperatureMax1161x *max11615 = new TemperatureMax1161x(MAX11615_ADDRESS, MAX11615_CHANNELS, &Wire);
+  temperatures.addChip(max11615);
+  temperatures.add(new TemperatureMax11615(0u, max11615));
+  temperatures.add(new TemperatureMax11615(1u, max11615));
+  temperatures.add(new TemperatureMax11615(2u, max11615));
+  temperatures.add(new TemperatureMax11615(3u, max11615));
+  temperatures.add(new TemperatureMax11615(4u, max11615));
+  temperatures.add(new TemperatureMax11615(5u, max11615));
+  temperatures.add(new TemperatureMax11615(6u, max11615));
+  temperatures.add(new TemperatureMax11615(7u, max11615));
 
   // add blutetooth feature
   bluetooth = new Bluetooth(&Serial2, BLE_RESET_PIN);
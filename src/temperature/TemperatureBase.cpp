@@ -20,6 +20,7 @@
 
 #include "TemperatureBase.h"
 #include "TemperatureGrp.h"
+#include "TemperatureLut.h"
 #include "Settings.h"
 
 #define LOWEST_VALUE -31
@@ -27,21 +28,19 @@
 #define DEFAULT_MIN_VALUE 10.0
 #define DEFAULT_MAX_VALUE 35.0
 #define MAX_COLORS 8u
-#define MEDIAN_SIZE 9u
 #define DEFAULT_CHANNEL_NAME "Kanal "
 
 const static String colors[MAX_COLORS] = {"#0C4C88", "#22B14C", "#EF562D", "#FFC100", "#A349A4", "#804000", "#5587A2", "#5C7148"};
 TemperatureCalculation_t TemperatureBase::typeFunctions[NUM_OF_TYPES] = {
-    TemperatureBase::calcTemperatureNTC, TemperatureBase::calcTemperatureNTC, TemperatureBase::calcTemperatureNTC,
-    TemperatureBase::calcTemperatureNTC, TemperatureBase::calcTemperatureNTC, TemperatureBase::calcTemperatureNTC,
-    TemperatureBase::calcTemperatureNTC, TemperatureBase::calcTemperatureNTC, TemperatureBase::calcTemperatureNTC,
-    TemperatureBase::calcTemperatureNTC, TemperatureBase::calcTemperatureNTC, TemperatureBase::calcTemperatureNTC,
-    TemperatureBase::calcTemperaturePTx, TemperatureBase::calcTemperaturePTx, TemperatureBase::calcTemperatureNTC,
+    TemperatureLut::calcTemperature, TemperatureLut::calcTemperature, TemperatureLut::calcTemperature,
+    TemperatureLut::calcTemperature, TemperatureLut::calcTemperature, TemperatureLut::calcTemperature,
+    TemperatureLut::calcTemperature, TemperatureLut::calcTemperature, TemperatureLut::calcTemperature,
+    TemperatureLut::calcTemperature, TemperatureLut::calcTemperature, TemperatureLut::calcTemperature,
+    TemperatureLut::calcTemperature, TemperatureLut::calcTemperature, TemperatureLut::calcTemperature,
     NULL, NULL};
 
 TemperatureBase::TemperatureBase()
 {
-  this->medianValue = new MedianFilterFloat(MEDIAN_SIZE);
   this->fixedSensor = false;
   this->loadDefaultValues(TemperatureGrp::count());
   this->settingsChanged = false;
@@ -50,10 +49,17 @@ TemperatureBase::TemperatureBase()
   this->calcTemperature = typeFunctions[0];
   this->acknowledgedAlarm = false;
   this->connected = false;
+  this->history = NULL;
+  this->historyFailed = false;
 }
 
 TemperatureBase::~TemperatureBase()
 {
+  // history might be streamed right now
+  TemperatureHistory::lock();
+  delete this->history;
+  this->history = NULL;
+  TemperatureHistory::unlock();
 }
 
 void TemperatureBase::loadDefaultValues(uint8_t index)
@@ -335,7 +341,7 @@ void TemperatureBase::refresh()
   int8_t preGradientSign = this->gradientSign;
 
   // get current
-  float currentVal = this->medianValue->getFiltered();
+  float currentVal = this->medianValue.getFiltered();
   float gradient = (isActive() == true) ? decimalPlace(currentVal) - decimalPlace(this->preValue) : 0;
   this->gradientSign = (0 == gradient) ? 0 : (0 < gradient) ? 1 : -1;
   this->currentGradient = (0 == gradient) ? 0 : gradient / abs(gradient);
@@ -371,6 +377,31 @@ float TemperatureBase::decimalPlace(float value)
   return (((int)value * 10.0) / 10.0);
 }
 
+void TemperatureBase::updateHistory()
+{
+  // allocate the history with the first active value only
+  if (NULL == this->history)
+  {
+    if ((false == isActive()) || this->historyFailed)
+      return;
+
+    TemperatureHistory *history = TemperatureHistory::create();
+
+    if (NULL == history)
+    {
+      this->historyFailed = true;
+      return;
+    }
+
+    // a /history stream reads the pointer under the lock
+    TemperatureHistory::lock();
+    this->history = history;
+    TemperatureHistory::unlock();
+  }
+
+  this->history->add(this->currentValue);
+}
+
 float TemperatureBase::getUnitValue(float value)
 {
   float convertedValue = value;
@@ -387,139 +418,3 @@ TemperatureUnit TemperatureBase::getUnit()
 {
   return this->currentUnit;
 }
-
-float TemperatureBase::calcTemperatureNTC(uint16_t rawValue, SensorType type)
-{
-
-  float Rmess = 47;
-  float a, b, c, Rn;
-
-  // kleine Abweichungen an GND verursachen Messfehler von wenigen Digitalwerten
-  // daher werden nur Messungen mit einem Digitalwert von mind. 10 ausgewertet,
-  // das entspricht 5 mV
-  if (rawValue < 10)
-    return INACTIVEVALUE; // Kanal ist mit GND gebrückt
-
-  switch (type)
-  {
-  case SensorType::Maverick: // 1000K/Maverik
-    Rn = 999.05;
-    a = 3.3537355e-03;
-    b = 2.2320379e-04;
-    c = 2.3380330e-06;
-    break;
-  case SensorType::FantastNeu: // Fantast-Neu
-    Rn = 220;
-    a = 0.00334519;
-    b = 0.000243825;
-    c = 0.00000261726;
-    break;
-  case SensorType::Fantast: // Fantast
-    Rn = 50.08;
-    a = 3.3558340e-03;
-    b = 2.5698192e-04;
-    c = 1.6391056e-06;
-    break;
-  case SensorType::iGrill2: // 100K/iGrill2
-    Rn = 100.075;
-    a = 3.3525233e-03;
-    b = 2.5293916e-04;
-    c = 2.7388783e-06;
-    break;
-  case SensorType::ET73: // ET-73
-    Rn = 200;
-    a = 0.00335672;
-    b = 0.000291888;
-    c = 0.00000439054;
-    break;
-  case SensorType::PERFEKTION: // PERFEKTION
-    Rn = 200.1;
-    a = 3.3561990e-03;
-    b = 2.4352911e-04;
-    c = 3.4519389e-06;
-    break;
-  case SensorType::_50K: // 50K
-    Rn = 50.0;
-    a = 3.35419603e-03;
-    b = 2.41943663e-04;
-    c = 2.77057578e-06;
-    break;
-  case SensorType::INKBIRD: // INKBIRD
-    Rn = 48.59;
-    a = 3.3552456e-03;
-    b = 2.5608666e-04;
-    c = 1.9317204e-06;
-    //Rn = 48.6; a = 3.35442124e-03; b = 2.56134397e-04; c = 1.9536396e-06;
-    //Rn = 48.94; a = 3.35438959e-03; b = 2.55353377e-04; c = 1.86726509e-06;
-    break;
-  case SensorType::NTC100K6A1B: // NTC 100K6A1B (lila Kopf)
-    Rn = 100;
-    a = 3.3544846e-03;
-    b = 2.4144443e-04;
-    c = 2.6788747e-06;
-    break;
-  case SensorType::Weber6743: // Weber_6743
-    Rn = 102.315;
-    a = 3.3558796e-03;
-    b = 2.7111149e-04;
-    c = 3.1838428e-06;
-    break;
-  case SensorType::Santos: // Santos
-    Rn = 200.82;
-    a = 3.3561093e-03;
-    b = 2.3552814e-04;
-    c = 2.1375541e-06;
-    break;
-  case SensorType::NTC5K3A1B: // NTC 5K3A1B (orange Kopf)
-    Rn = 5;
-    a = 0.0033555;
-    b = 0.0002570;
-    c = 0.00000243;
-    break;
-  case SensorType::ThermoWorks: // ThermoWorks
-    Rn = 97.31;
-    a = 3.3556417e-03;
-    b = 2.5191450e-04;
-    c = 2.3606960e-06;
-    break;
-  default:
-    return INACTIVEVALUE;
-  }
-
-  float Rt = Rmess * ((4096.0 / (4096 - rawValue)) - 1);
-  float v = log(Rt / Rn);
-  float erg = (1 / (a + b * v + c * v * v)) - 273.15;
-
-  return (erg > LOWEST_VALUE) ? erg : INACTIVEVALUE;
-}
-
-float TemperatureBase::calcTemperaturePTx(uint16_t rawValue, SensorType type)
-{
-  float a, b, Rpt, Rmess;
-
-  if (rawValue < 10)
-    return INACTIVEVALUE; // Kanal ist mit GND gebrückt
-
-  switch (type)
-  {
-  case SensorType::PT100: // PT100
-    Rpt = 0.1;
-    Rmess = 0.0998;
-    break;
-
-  case SensorType::PT1000: // PT1000
-    Rpt = 1.0;
-    Rmess = 0.9792;
-    break;
-
-  default:
-    return INACTIVEVALUE;
-  }
-
-  float Rt = Rmess * ((4096.0 / (4096 - rawValue)) - 1);
-  a = 3.9083e-03;
-  b = -5.775e-07;
-  float erg = (-1) * sqrt((Rt / (Rpt * b)) + ((a * a) / (4 * (b * b))) - 1 / (b)) - (a / (2 * b));
-
-  return (erg > LOWEST_VALUE) ? erg : INACTIVEVALUE;
-}
\ No newline at end of file
@@ -20,10 +20,12 @@
 #pragma once
 
 #include "Arduino.h"
-#include "MedianFilterFloat.h"
+#include "SlidingMedian.h"
+#include "TemperatureHistory.h"
 #include "TemperatureSensors.h"
 
 #define INACTIVEVALUE 999
+#define TEMPERATURE_MEDIAN_SIZE 9u
 
 #define TEMPERATURE_ADDRESS_INTERNAL "FF:FF:FF:00:00:00"
 #define TEMPERATURE_ADDRESS_TYPE_K "FF:FF:FF:00:01:00"
@@ -99,6 +101,8 @@ public:
   boolean isActive();
   void virtual refresh();
   void virtual update();
+  void updateHistory();
+  TemperatureHistory *getHistory() { return this->history; };
 
 protected:
   uint8_t localIndex;
@@ -106,7 +110,7 @@ protected:
   float preValue;
   int8_t currentGradient;
   int8_t gradientSign;
-  MedianFilterFloat *medianValue;
+  SlidingMedian<float, TEMPERATURE_MEDIAN_SIZE> medianValue;
   float minValue;
   float maxValue;
   SensorType type;
@@ -126,8 +130,8 @@ private:
   AlarmStatus cbAlarmStatus;
   boolean acknowledgedAlarm;
   float cbCurrentValue;
+  TemperatureHistory *history;
+  boolean historyFailed;
   float getUnitValue(float value);
   float decimalPlace(float value);
-  static float calcTemperatureNTC(uint16_t rawValue, SensorType type);
-  static float calcTemperaturePTx(uint16_t rawValue, SensorType type);
 };
\ No newline at end of file
@@ -23,6 +23,8 @@
 
 TemperatureBle::TemperatureBle()
 {
+  this->mac = 0u;
+  this->device = NULL;
 }
 
 TemperatureBle::TemperatureBle(String peerAddress, uint8_t index) : TemperatureBase()
@@ -31,15 +33,21 @@ TemperatureBle::TemperatureBle(String peerAddress, uint8_t index) : TemperatureB
   this->localIndex = index;
   this->type = SensorType::Ble;
   this->fixedSensor = true;
+  this->mac = BleDeviceMap::parseMac(peerAddress.c_str());
+  this->device = NULL;
 }
 
 void TemperatureBle::refresh()
 {
-  this->connected = Bluetooth::isDeviceConnected(this->address);
+  // the device can be added after the channel, so the handle is resolved here
+  if (NULL == this->device)
+    this->device = Bluetooth::getDeviceHandle(this->mac);
+
+  this->connected = Bluetooth::isDeviceConnected(this->device);
 
   if (this->connected)
   {
-    this->currentValue = Bluetooth::getSensorValue(this->address, this->localIndex);
+    this->currentValue = Bluetooth::getSensorValue(this->device, this->localIndex);
   }
   else
   {
@@ -21,10 +21,16 @@
 
 #include "TemperatureBase.h"
 
+struct BleDevice;
+
 class TemperatureBle : public TemperatureBase
 {
 public:
   TemperatureBle();
   TemperatureBle(String peerAddress, uint8_t index);
   void refresh();
+
+private:
+  uint64_t mac;
+  BleDevice *device;
 };
@@ -0,0 +1,33 @@
+/*************************************************** 
+    Copyright (C) 2020  Martin Koerner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    
+    HISTORY: Please refer Github History
+    
+****************************************************/
+#pragma once
+
+#include "Arduino.h"
+
+// Chip level acquisition of all channels of one ADC.
+// TemperatureGrp::update() calls acquire() once per cycle before the channels
+// pick up their raw value with getRawValue().
+class TemperatureChip
+{
+public:
+  virtual ~TemperatureChip(){};
+  virtual void acquire() = 0;
+  virtual uint16_t getRawValue(uint8_t index) = 0;
+};
@@ -23,6 +23,8 @@
 
 TemperatureConnect::TemperatureConnect()
 {
+  this->mac = 0u;
+  this->device = NULL;
 }
 
 TemperatureConnect::TemperatureConnect(String peerAddress, uint8_t index) : TemperatureBase()
@@ -31,15 +33,21 @@ TemperatureConnect::TemperatureConnect(String peerAddress, uint8_t index) : Temp
   this->localIndex = index;
   this->type = SensorType::Connect;
   this->fixedSensor = true;
+  this->mac = ConnectDeviceMap::parseMac(peerAddress.c_str());
+  this->device = NULL;
 }
 
 void TemperatureConnect::refresh()
 {
-  this->connected = Connect::isDeviceConnected(this->address);
+  // the device can be added after the channel, so the handle is resolved here
+  if (NULL == this->device)
+    this->device = Connect::getDeviceHandle(this->mac);
+
+  this->connected = Connect::isDeviceConnected(this->device);
 
   if (this->connected)
   {
-    this->currentValue = Connect::getTemperatureValue(this->address, this->localIndex);
+    this->currentValue = Connect::getTemperatureValue(this->device, this->localIndex);
   }
   else
   {
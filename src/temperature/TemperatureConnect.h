@@ -21,10 +21,16 @@
 
 #include "TemperatureBase.h"
 
+struct ConnectDevice;
+
 class TemperatureConnect : public TemperatureBase
 {
 public:
   TemperatureConnect();
   TemperatureConnect(String peerAddress, uint8_t index);
   void refresh();
+
+private:
+  uint64_t mac;
+  ConnectDevice *device;
 };
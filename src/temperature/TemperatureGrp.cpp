@@ -23,13 +23,14 @@
 #include "TemperatureConnect.h"
 #include "Settings.h"
 #include "bluetooth/Bluetooth.h"
-#include "ArduinoLog.h"
+#include "EventLog.h"
 
 std::vector<TemperatureBase *> TemperatureGrp::temperatures;
 
 TemperatureGrp::TemperatureGrp()
 {
   this->currentUnit = Celsius;
+  TemperatureHistory::init();
 }
 
 void TemperatureGrp::add(TemperatureBase *temperature)
@@ -37,6 +38,11 @@ void TemperatureGrp::add(TemperatureBase *temperature)
   temperatures.push_back(temperature);
 }
 
+void TemperatureGrp::addChip(TemperatureChip *chip)
+{
+  chips.push_back(chip);
+}
+
 void TemperatureGrp::add(uint8_t type, String address, uint8_t localIndex)
 {
   const auto isTemperature = [type, address, localIndex](TemperatureBase *t) {
@@ -131,6 +137,12 @@ void TemperatureGrp::update()
 {
   Log.verbose("TemperatureGrp::update()" CR);
 
+  // read all channels of each chip at once
+  for (uint8_t i = 0u; i < chips.size(); i++)
+  {
+    chips[i]->acquire();
+  }
+
   for (uint8_t i = 0u; i < count(); i++)
   {
     // get values form hardware
@@ -145,6 +157,7 @@ void TemperatureGrp::refresh()
   for (uint8_t i = 0u; i < count(); i++)
   {
     temperatures[i]->refresh();
+    temperatures[i]->updateHistory();
 
     boolean newValue = temperatures[i]->checkNewValue();
     boolean settingsChanged = temperatures[i]->checkNewSettings();
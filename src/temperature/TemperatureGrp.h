@@ -21,6 +21,7 @@
 
 #include "Arduino.h"
 #include "TemperatureBase.h"
+#include "TemperatureChip.h"
 
 typedef void (*TemperatureCallback_t)(uint8_t index, class TemperatureBase *, boolean, void *);
 
@@ -37,6 +38,7 @@ public:
   void update();
   void refresh();
   void add(TemperatureBase *temperature);
+  void addChip(TemperatureChip *chip);
   void add(uint8_t type, String address, uint8_t localIndex);
   void remove(uint8_t type, String address, uint8_t localIndex);
   void remove(uint8_t index);
@@ -58,6 +60,7 @@ public:
 
 private:
   static std::vector<TemperatureBase *> temperatures;
+  std::vector<TemperatureChip *> chips;
   std::vector<TemperatureCallbackDataType> registeredCb;
   TemperatureUnit currentUnit;
 };
\ No newline at end of file
@@ -0,0 +1,432 @@
+/*************************************************** 
+    Copyright (C) 2020  Martin Koerner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    
+    HISTORY: Please refer Github History
+    
+****************************************************/
+
+#include "TemperatureHistory.h"
+#include "TemperatureGrp.h"
+#include "EventLog.h"
+
+typedef struct
+{
+  uint16_t interval; // s
+  uint16_t samples;
+} HistoryTierConfig;
+
+static const HistoryTierConfig historyTierConfig[HISTORY_TIERS] = {{1u, 600u}, {10u, 720u}, {60u, 1440u}};
+
+SemaphoreHandle_t TemperatureHistory::mutex = NULL;
+uint8_t TemperatureHistory::heapCount = 0u;
+
+HistoryTier::HistoryTier()
+{
+  this->blocks = NULL;
+  this->blockCount = 0u;
+  this->interval = 0u;
+  this->firstSequence = 0u;
+  this->headSequence = 0u;
+  this->lastValue = HISTORY_INACTIVE_VALUE;
+  this->lastTime = 0u;
+}
+
+HistoryTier::~HistoryTier()
+{
+  free(this->blocks);
+}
+
+boolean HistoryTier::begin(uint16_t interval, uint16_t samples)
+{
+  size_t count = (samples + HISTORY_BLOCK_SAMPLES - 1u) / HISTORY_BLOCK_SAMPLES + 1u;
+  HistoryBlock *blocks = (HistoryBlock *)(psramFound() ? ps_calloc(count, sizeof(HistoryBlock)) : calloc(count, sizeof(HistoryBlock)));
+
+  if (NULL == blocks)
+    return false;
+
+  // blocks is checked by add() and next(), everything else has to be valid before
+  this->blockCount = count;
+  this->interval = interval;
+  this->blocks = blocks;
+
+  return true;
+}
+
+void HistoryTier::add(int16_t value)
+{
+  if (NULL == this->blocks)
+    return;
+
+  HistoryBlock *head = &this->blocks[this->headSequence % this->blockCount];
+
+  if ((head->count > 0u) && (head->count < HISTORY_BLOCK_SAMPLES))
+  {
+    value = append(head, value);
+  }
+  else
+  {
+    if (head->count > 0u)
+    {
+      // start a new block, drop the oldest one when the ring is full
+      this->headSequence++;
+      if ((this->headSequence - this->firstSequence) >= this->blockCount)
+        this->firstSequence++;
+
+      head = &this->blocks[this->headSequence % this->blockCount];
+    }
+
+    head->base = value;
+    head->count = 1u;
+    head->size = 0u;
+  }
+
+  this->lastValue = value;
+  this->lastTime = time(NULL);
+}
+
+// returns the stored value, it is approximated when the block has no space left for an escape
+int16_t HistoryTier::append(HistoryBlock *block, int16_t value)
+{
+  int16_t delta = value - this->lastValue;
+  boolean lastActive = (this->lastValue != HISTORY_INACTIVE_VALUE);
+  // every following sample of the block needs at least one byte
+  uint8_t reserve = HISTORY_BLOCK_SAMPLES - 1u - block->count;
+  uint8_t space = HISTORY_BLOCK_DATA_SIZE - block->size;
+
+  if (HISTORY_INACTIVE_VALUE == value)
+  {
+    block->data[block->size++] = HISTORY_CODE_INACTIVE;
+  }
+  else if (lastActive && (delta >= HISTORY_DELTA_MIN) && (delta <= INT8_MAX))
+  {
+    block->data[block->size++] = delta;
+  }
+  else if (space >= (3u + reserve))
+  {
+    block->data[block->size++] = HISTORY_CODE_ABSOLUTE;
+    block->data[block->size++] = value & 0xFF;
+    block->data[block->size++] = (value >> 8) & 0xFF;
+  }
+  else if (lastActive)
+  {
+    value = this->lastValue + constrain(delta, (int16_t)HISTORY_DELTA_MIN, (int16_t)INT8_MAX);
+    block->data[block->size++] = value - this->lastValue;
+  }
+  else
+  {
+    value = HISTORY_INACTIVE_VALUE;
+    block->data[block->size++] = HISTORY_CODE_INACTIVE;
+  }
+
+  block->count++;
+
+  return value;
+}
+
+void HistoryTier::rewind(HistoryCursor *cursor)
+{
+  cursor->sequence = this->firstSequence;
+  cursor->sample = 0u;
+  cursor->offset = 0u;
+  cursor->value = HISTORY_INACTIVE_VALUE;
+  cursor->gap = false;
+  cursor->lost = 0u;
+}
+
+boolean HistoryTier::next(HistoryCursor *cursor)
+{
+  if (NULL == this->blocks)
+    return false;
+
+  // the block of the cursor has been overwritten meanwhile, the lost samples
+  // are reported as gaps so the position of all following values stays right
+  if (cursor->sequence < this->firstSequence)
+  {
+    cursor->lost += ((this->firstSequence - cursor->sequence) * HISTORY_BLOCK_SAMPLES) - cursor->sample;
+    cursor->sequence = this->firstSequence;
+    cursor->sample = 0u;
+    cursor->offset = 0u;
+  }
+
+  if (cursor->lost > 0u)
+  {
+    cursor->lost--;
+    cursor->gap = true;
+    return true;
+  }
+
+  cursor->gap = false;
+  HistoryBlock *block = &this->blocks[cursor->sequence % this->blockCount];
+
+  if (cursor->sample >= block->count)
+  {
+    if (cursor->sequence >= this->headSequence)
+      return false;
+
+    cursor->sequence++;
+    cursor->sample = 0u;
+    cursor->offset = 0u;
+    block = &this->blocks[cursor->sequence % this->blockCount];
+  }
+
+  if (0u == cursor->sample)
+  {
+    cursor->value = block->base;
+  }
+  else
+  {
+    int8_t code = block->data[cursor->offset++];
+
+    if (HISTORY_CODE_INACTIVE == code)
+    {
+      cursor->value = HISTORY_INACTIVE_VALUE;
+    }
+    else if (HISTORY_CODE_ABSOLUTE == code)
+    {
+      cursor->value = (int16_t)((uint8_t)block->data[cursor->offset] | ((uint8_t)block->data[cursor->offset + 1u] << 8));
+      cursor->offset += 2u;
+    }
+    else
+    {
+      cursor->value += code;
+    }
+  }
+
+  cursor->sample++;
+
+  return true;
+}
+
+TemperatureHistory::TemperatureHistory()
+{
+  for (uint8_t i = 0u; i < HISTORY_TIERS; i++)
+  {
+    this->sum[i] = 0;
+    this->activeCount[i] = 0u;
+    this->sampleCount[i] = 0u;
+  }
+
+  if (false == psramFound())
+    heapCount++;
+}
+
+TemperatureHistory::~TemperatureHistory()
+{
+  if (false == psramFound())
+    heapCount--;
+}
+
+boolean TemperatureHistory::begin()
+{
+  boolean success = true;
+
+  for (uint8_t i = 0u; i < HISTORY_TIERS; i++)
+    success &= this->tiers[i].begin(historyTierConfig[i].interval, historyTierConfig[i].samples);
+
+  return success;
+}
+
+// returns a completely allocated history or NULL, publish it under lock()
+TemperatureHistory *TemperatureHistory::create()
+{
+  if ((false == psramFound()) && (heapCount >= HISTORY_MAX_HEAP_CHANNELS))
+  {
+    Log.notice("History: limit of %d channels without PSRAM reached" CR, HISTORY_MAX_HEAP_CHANNELS);
+    return NULL;
+  }
+
+  TemperatureHistory *history = new TemperatureHistory();
+
+  if (false == history->begin())
+  {
+    Log.error("History: no memory for channel history" CR);
+    delete history;
+    return NULL;
+  }
+
+  return history;
+}
+
+void TemperatureHistory::init()
+{
+  if (NULL == mutex)
+    mutex = xSemaphoreCreateMutex();
+}
+
+void TemperatureHistory::lock()
+{
+  xSemaphoreTake(mutex, portMAX_DELAY);
+}
+
+void TemperatureHistory::unlock()
+{
+  xSemaphoreGive(mutex);
+}
+
+// called once per second
+void TemperatureHistory::add(float value)
+{
+  boolean active = (INACTIVEVALUE != value);
+  int16_t deciValue = active ? (int16_t)roundf(value * 10.0f) : HISTORY_INACTIVE_VALUE;
+
+  lock();
+
+  for (uint8_t i = 0u; i < HISTORY_TIERS; i++)
+  {
+    this->sampleCount[i]++;
+
+    if (active)
+    {
+      this->sum[i] += deciValue;
+      this->activeCount[i]++;
+    }
+
+    // downsampling with the mean of all active samples
+    if (this->sampleCount[i] >= historyTierConfig[i].interval)
+    {
+      this->tiers[i].add((this->activeCount[i] > 0u) ? (int16_t)(this->sum[i] / this->activeCount[i]) : HISTORY_INACTIVE_VALUE);
+      this->sum[i] = 0;
+      this->activeCount[i] = 0u;
+      this->sampleCount[i] = 0u;
+    }
+  }
+
+  unlock();
+}
+
+HistoryTier *TemperatureHistory::getTier(uint8_t index)
+{
+  return (index < HISTORY_TIERS) ? &this->tiers[index] : NULL;
+}
+
+TemperatureHistoryStream::TemperatureHistoryStream(TemperatureGrp *temperatures)
+{
+  this->temperatures = temperatures;
+  this->state = StreamBegin;
+  this->channel = 0u;
+  this->tier = 0u;
+  this->firstValue = true;
+  this->pendingLength = 0u;
+  this->pendingIndex = 0u;
+}
+
+size_t TemperatureHistoryStream::read(uint8_t *buffer, size_t maxLen)
+{
+  size_t length = 0u;
+
+  TemperatureHistory::lock();
+
+  while (length < maxLen)
+  {
+    if (this->pendingIndex >= this->pendingLength)
+    {
+      if (StreamDone == this->state)
+        break;
+
+      this->pendingIndex = 0u;
+      this->pendingLength = 0u;
+      produce();
+      continue;
+    }
+
+    size_t copyLength = min((size_t)(this->pendingLength - this->pendingIndex), maxLen - length);
+    memcpy(&buffer[length], &this->pending[this->pendingIndex], copyLength);
+    this->pendingIndex += copyLength;
+    length += copyLength;
+  }
+
+  TemperatureHistory::unlock();
+
+  return length;
+}
+
+TemperatureHistory *TemperatureHistoryStream::getHistory()
+{
+  TemperatureBase *temperature = (this->channel < TemperatureGrp::count()) ? (*this->temperatures)[this->channel] : NULL;
+  return (temperature != NULL) ? temperature->getHistory() : NULL;
+}
+
+void TemperatureHistoryStream::produce()
+{
+  int length = 0;
+  HistoryTier *historyTier;
+  TemperatureHistory *history;
+
+  switch (this->state)
+  {
+  case StreamBegin:
+    length = snprintf(this->pending, sizeof(this->pending), "{\"unit\":\"%c\",\"channels\":[", (char)this->temperatures->getUnit());
+    this->state = StreamChannel;
+    break;
+  case StreamChannel:
+    if (this->channel >= TemperatureGrp::count())
+    {
+      length = snprintf(this->pending, sizeof(this->pending), "]}");
+      this->state = StreamDone;
+      break;
+    }
+    length = snprintf(this->pending, sizeof(this->pending), "%s{\"number\":%u,\"tiers\":[", (this->channel > 0u) ? "," : "", this->channel + 1u);
+    this->tier = 0u;
+    this->state = StreamTier;
+    break;
+  case StreamTier:
+    history = getHistory();
+    historyTier = (history != NULL) ? history->getTier(this->tier) : NULL;
+    if (NULL == historyTier)
+    {
+      length = snprintf(this->pending, sizeof(this->pending), "]}");
+      this->channel++;
+      this->state = StreamChannel;
+      break;
+    }
+    length = snprintf(this->pending, sizeof(this->pending), "%s{\"interval\":%u,\"values\":[", (this->tier > 0u) ? "," : "", historyTier->getInterval());
+    historyTier->rewind(&this->cursor);
+    this->firstValue = true;
+    this->state = StreamValues;
+    break;
+  case StreamValues:
+    history = getHistory();
+    historyTier = (history != NULL) ? history->getTier(this->tier) : NULL;
+    if ((historyTier != NULL) && historyTier->next(&this->cursor))
+    {
+      if (this->cursor.gap)
+      {
+        length = snprintf(this->pending, sizeof(this->pending), this->firstValue ? "null" : ",null");
+        this->firstValue = false;
+        break;
+      }
+
+      float value = INACTIVEVALUE;
+      if (this->cursor.value != HISTORY_INACTIVE_VALUE)
+      {
+        value = this->cursor.value / 10.0f;
+        value = (Fahrenheit == this->temperatures->getUnit()) ? (value * 1.8f) + 32.0f : value;
+      }
+      length = snprintf(this->pending, sizeof(this->pending), this->firstValue ? "%.1f" : ",%.1f", value);
+      this->firstValue = false;
+      break;
+    }
+    length = snprintf(this->pending, sizeof(this->pending), "],\"last\":%u}", (historyTier != NULL) ? historyTier->getLastTime() : 0u);
+    this->tier++;
+    this->state = StreamTier;
+    break;
+  default:
+    this->state = StreamDone;
+    break;
+  }
+
+  this->pendingLength = (length > 0) ? min(length, (int)sizeof(this->pending) - 1) : 0u;
+}
@@ -0,0 +1,132 @@
+/*************************************************** 
+    Copyright (C) 2020  Martin Koerner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    
+    HISTORY: Please refer Github History
+    
+****************************************************/
+#pragma once
+
+#include "Arduino.h"
+
+#define HISTORY_TIERS 3u
+#define HISTORY_BLOCK_SAMPLES 16u
+#define HISTORY_BLOCK_DATA_SIZE ((HISTORY_BLOCK_SAMPLES - 1u) * 2u)
+#define HISTORY_INACTIVE_VALUE 9990 // INACTIVEVALUE in 0.1°C
+// a history takes about 6 KB, without PSRAM only this many channels get one
+#define HISTORY_MAX_HEAP_CHANNELS 4u
+
+// codes in the delta stream, all other values are 8 bit deltas
+#define HISTORY_CODE_INACTIVE INT8_MIN
+#define HISTORY_CODE_ABSOLUTE (INT8_MIN + 1) // followed by the value as int16
+#define HISTORY_DELTA_MIN (INT8_MIN + 2)
+
+// Samples are stored in 0.1°C as a 16 bit base value followed by 8 bit deltas.
+// Every block holds HISTORY_BLOCK_SAMPLES samples, so the retention of a tier is fixed.
+// Inactive values and deltas that do not fit into 8 bit are escaped, the data is
+// sized for a flapping probe (inactive + absolute value for every 2nd sample).
+typedef struct
+{
+  int16_t base;
+  uint8_t count;
+  uint8_t size;
+  int8_t data[HISTORY_BLOCK_DATA_SIZE];
+} HistoryBlock;
+
+typedef struct
+{
+  uint32_t sequence;
+  uint8_t sample;
+  uint8_t offset;
+  int16_t value;
+  boolean gap;     // value has been overwritten before it was read
+  uint32_t lost;
+} HistoryCursor;
+
+class HistoryTier
+{
+public:
+  HistoryTier();
+  ~HistoryTier();
+  boolean begin(uint16_t interval, uint16_t samples);
+  void add(int16_t value);
+  uint16_t getInterval() { return this->interval; };
+  uint32_t getLastTime() { return this->lastTime; };
+  void rewind(HistoryCursor *cursor);
+  boolean next(HistoryCursor *cursor);
+
+private:
+  int16_t append(HistoryBlock *block, int16_t value);
+  HistoryBlock *blocks;
+  uint16_t blockCount;
+  uint16_t interval;
+  uint32_t firstSequence;
+  uint32_t headSequence;
+  int16_t lastValue;
+  uint32_t lastTime;
+};
+
+// 1s for 10min, 10s for 2h, 60s for 24h
+class TemperatureHistory
+{
+public:
+  TemperatureHistory();
+  ~TemperatureHistory();
+  boolean begin();
+  void add(float value);
+  HistoryTier *getTier(uint8_t index);
+  static TemperatureHistory *create();
+  static void init();
+  static void lock();
+  static void unlock();
+
+private:
+  HistoryTier tiers[HISTORY_TIERS];
+  int32_t sum[HISTORY_TIERS];
+  uint16_t activeCount[HISTORY_TIERS];
+  uint16_t sampleCount[HISTORY_TIERS];
+  static SemaphoreHandle_t mutex;
+  static uint8_t heapCount;
+};
+
+// JSON generator for chunked responses, only a few bytes are held in RAM
+class TemperatureHistoryStream
+{
+public:
+  TemperatureHistoryStream(class TemperatureGrp *temperatures);
+  size_t read(uint8_t *buffer, size_t maxLen);
+
+private:
+  enum StreamState
+  {
+    StreamBegin,
+    StreamChannel,
+    StreamTier,
+    StreamValues,
+    StreamDone
+  };
+
+  void produce();
+  TemperatureHistory *getHistory();
+  class TemperatureGrp *temperatures;
+  StreamState state;
+  uint8_t channel;
+  uint8_t tier;
+  boolean firstValue;
+  HistoryCursor cursor;
+  char pending[48];
+  uint8_t pendingLength;
+  uint8_t pendingIndex;
+};
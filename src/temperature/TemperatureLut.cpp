@@ -0,0 +1,267 @@
+/*************************************************** 
+    Copyright (C) 2020  Martin Koerner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    
+    HISTORY: Please refer Github History
+    
+****************************************************/
+
+#include "TemperatureLut.h"
+#include "TemperatureBase.h"
+
+#define LOWEST_VALUE -31
+#define LUT_MID_MASK ((1u << TEMPERATURE_LUT_SHIFT) - 1u)
+#define PTX_A 3.9083e-03
+#define PTX_B -5.775e-07
+
+enum LutCalculation
+{
+  LutNone,
+  LutNTC,
+  LutPTx
+};
+
+typedef struct
+{
+  LutCalculation calculation;
+  float rn;    // NTC: Rn, PTx: Rpt
+  float rmess; // Messwiderstand
+  float a;
+  float b;
+  float c;
+} LutCoefficients;
+
+typedef struct
+{
+  float values[TEMPERATURE_LUT_SIZE];
+} LutTable;
+
+// Reihenfolge muss SensorType entsprechen
+static constexpr LutCoefficients lutCoefficients[TEMPERATURE_LUT_TYPES] = {
+    {LutNTC, 999.05, 47.0, 3.3537355e-03, 2.2320379e-04, 2.3380330e-06},   // 1000K/Maverik
+    {LutNTC, 220.0, 47.0, 0.00334519, 0.000243825, 0.00000261726},        // Fantast-Neu
+    {LutNTC, 50.08, 47.0, 3.3558340e-03, 2.5698192e-04, 1.6391056e-06},    // Fantast
+    {LutNTC, 100.075, 47.0, 3.3525233e-03, 2.5293916e-04, 2.7388783e-06},  // 100K/iGrill2
+    {LutNTC, 200.0, 47.0, 0.00335672, 0.000291888, 0.00000439054},        // ET-73
+    {LutNTC, 200.1, 47.0, 3.3561990e-03, 2.4352911e-04, 3.4519389e-06},    // PERFEKTION
+    {LutNTC, 50.0, 47.0, 3.35419603e-03, 2.41943663e-04, 2.77057578e-06},  // 50K
+    {LutNTC, 48.59, 47.0, 3.3552456e-03, 2.5608666e-04, 1.9317204e-06},    // INKBIRD
+    {LutNTC, 100.0, 47.0, 3.3544846e-03, 2.4144443e-04, 2.6788747e-06},    // NTC 100K6A1B (lila Kopf)
+    {LutNTC, 102.315, 47.0, 3.3558796e-03, 2.7111149e-04, 3.1838428e-06},  // Weber_6743
+    {LutNTC, 200.82, 47.0, 3.3561093e-03, 2.3552814e-04, 2.1375541e-06},   // Santos
+    {LutNTC, 5.0, 47.0, 0.0033555, 0.0002570, 0.00000243},                // NTC 5K3A1B (orange Kopf)
+    {LutPTx, 0.1, 0.0998, PTX_A, PTX_B, 0.0},                             // PT100
+    {LutPTx, 1.0, 0.9792, PTX_A, PTX_B, 0.0},                             // PT1000
+    {LutNTC, 97.31, 47.0, 3.3556417e-03, 2.5191450e-04, 2.3606960e-06}};  // ThermoWorks
+
+// compile time generation of the tables, C++11 constexpr functions need to be single return statements
+template <uint16_t... I>
+struct LutSequence
+{
+};
+
+template <class A, class B>
+struct LutConcat;
+
+template <uint16_t... A, uint16_t... B>
+struct LutConcat<LutSequence<A...>, LutSequence<B...>>
+{
+  typedef LutSequence<A..., (uint16_t)(sizeof...(A) + B)...> type;
+};
+
+template <uint16_t N>
+struct LutMakeSequence
+{
+  typedef typename LutConcat<typename LutMakeSequence<N / 2u>::type, typename LutMakeSequence<N - N / 2u>::type>::type type;
+};
+
+template <>
+struct LutMakeSequence<0u>
+{
+  typedef LutSequence<> type;
+};
+
+template <>
+struct LutMakeSequence<1u>
+{
+  typedef LutSequence<0u> type;
+};
+
+static constexpr uint16_t lutRaw(uint16_t index)
+{
+  return (index < TEMPERATURE_LUT_LOW_END) ? index : (index < TEMPERATURE_LUT_HIGH_INDEX) ? TEMPERATURE_LUT_LOW_END + ((index - TEMPERATURE_LUT_LOW_END) << TEMPERATURE_LUT_SHIFT) : TEMPERATURE_LUT_HIGH_START + (index - TEMPERATURE_LUT_HIGH_INDEX);
+}
+
+static constexpr double lutResistance(uint16_t raw, const LutCoefficients &k)
+{
+  return k.rmess * ((4096.0 / (4096 - raw)) - 1);
+}
+
+static constexpr double lutLimit(double value)
+{
+  return (value > LOWEST_VALUE) ? value : INACTIVEVALUE;
+}
+
+static constexpr double lutNTC(double v, const LutCoefficients &k)
+{
+  return lutLimit((1 / ((double)k.a + (double)k.b * v + (double)k.c * v * v)) - 273.15);
+}
+
+static constexpr double lutPTxRadicand(double rt, const LutCoefficients &k)
+{
+  return (rt / ((double)k.rn * k.b)) + (((double)k.a * k.a) / (4 * ((double)k.b * k.b))) - 1 / (double)k.b;
+}
+
+static constexpr double lutPTx(double radicand, const LutCoefficients &k)
+{
+  return (radicand < 0.0) ? INACTIVEVALUE : lutLimit((-1) * sqrt(radicand) - ((double)k.a / (2 * (double)k.b)));
+}
+
+static constexpr float lutValue(uint16_t raw, const LutCoefficients &k)
+{
+  return ((raw < 10u) || (raw >= TEMPERATURE_LUT_ADC_RANGE)) ? INACTIVEVALUE : (LutNTC == k.calculation) ? (float)lutNTC(log(lutResistance(raw, k) / k.rn), k) : (LutPTx == k.calculation) ? (float)lutPTx(lutPTxRadicand(lutResistance(raw, k), k), k) : INACTIVEVALUE;
+}
+
+template <uint16_t... I>
+static constexpr LutTable lutBuild(const LutCoefficients &k, LutSequence<I...>)
+{
+  return LutTable{{lutValue(lutRaw(I), k)...}};
+}
+
+#define LUT_BUILD(sensor) lutBuild(lutCoefficients[(uint8_t)SensorType::sensor], LutMakeSequence<TEMPERATURE_LUT_SIZE>::type())
+
+// generated by the compiler, stored in flash
+static constexpr LutTable lutTables[TEMPERATURE_LUT_TYPES] = {
+    LUT_BUILD(Maverick), LUT_BUILD(FantastNeu), LUT_BUILD(Fantast), LUT_BUILD(iGrill2), LUT_BUILD(ET73),
+    LUT_BUILD(PERFEKTION), LUT_BUILD(_50K), LUT_BUILD(INKBIRD), LUT_BUILD(NTC100K6A1B), LUT_BUILD(Weber6743),
+    LUT_BUILD(Santos), LUT_BUILD(NTC5K3A1B), LUT_BUILD(PT100), LUT_BUILD(PT1000), LUT_BUILD(ThermoWorks)};
+
+float TemperatureLut::calcTemperature(uint16_t rawValue, SensorType type)
+{
+  uint8_t typeIndex = (uint8_t)type;
+
+  if ((typeIndex >= TEMPERATURE_LUT_TYPES) || (rawValue >= TEMPERATURE_LUT_ADC_RANGE))
+    return INACTIVEVALUE;
+
+  const float *values = lutTables[typeIndex].values;
+
+  if (rawValue < TEMPERATURE_LUT_LOW_END)
+    return values[rawValue];
+
+  if (rawValue >= TEMPERATURE_LUT_HIGH_START)
+    return values[TEMPERATURE_LUT_HIGH_INDEX + (rawValue - TEMPERATURE_LUT_HIGH_START)];
+
+  uint16_t index = TEMPERATURE_LUT_LOW_END + ((rawValue - TEMPERATURE_LUT_LOW_END) >> TEMPERATURE_LUT_SHIFT);
+  uint8_t fraction = (rawValue - TEMPERATURE_LUT_LOW_END) & LUT_MID_MASK;
+  float low = values[index];
+  float high = values[index + 1u];
+
+  // no interpolation across the LOWEST_VALUE limit
+  if ((INACTIVEVALUE == low) || (INACTIVEVALUE == high))
+    return calcTemperatureExact(rawValue, type);
+
+  return low + (high - low) * ((float)fraction / (1u << TEMPERATURE_LUT_SHIFT));
+}
+
+float TemperatureLut::calcTemperatureExact(uint16_t rawValue, SensorType type)
+{
+  uint8_t typeIndex = (uint8_t)type;
+
+  if (typeIndex >= TEMPERATURE_LUT_TYPES)
+    return INACTIVEVALUE;
+
+  switch (lutCoefficients[typeIndex].calculation)
+  {
+  case LutNTC:
+    return calcTemperatureNTC(rawValue, type);
+  case LutPTx:
+    return calcTemperaturePTx(rawValue, type);
+  default:
+    return INACTIVEVALUE;
+  }
+}
+
+float TemperatureLut::calcTemperatureNTC(uint16_t rawValue, SensorType type)
+{
+  const LutCoefficients &k = lutCoefficients[(uint8_t)type];
+
+  // kleine Abweichungen an GND verursachen Messfehler von wenigen Digitalwerten
+  // daher werden nur Messungen mit einem Digitalwert von mind. 10 ausgewertet,
+  // das entspricht 5 mV
+  if (rawValue < 10 || rawValue >= TEMPERATURE_LUT_ADC_RANGE)
+    return INACTIVEVALUE; // Kanal ist mit GND gebrückt
+
+  float Rt = k.rmess * ((4096.0 / (4096 - rawValue)) - 1);
+  float v = log(Rt / k.rn);
+  float erg = (1 / (k.a + k.b * v + k.c * v * v)) - 273.15;
+
+  return (erg > LOWEST_VALUE) ? erg : INACTIVEVALUE;
+}
+
+float TemperatureLut::calcTemperaturePTx(uint16_t rawValue, SensorType type)
+{
+  const LutCoefficients &k = lutCoefficients[(uint8_t)type];
+
+  if (rawValue < 10 || rawValue >= TEMPERATURE_LUT_ADC_RANGE)
+    return INACTIVEVALUE; // Kanal ist mit GND gebrückt
+
+  float Rt = k.rmess * ((4096.0 / (4096 - rawValue)) - 1);
+  float erg = (-1) * sqrt((Rt / (k.rn * k.b)) + ((k.a * k.a) / (4 * (k.b * k.b))) - 1 / (k.b)) - (k.a / (2 * k.b));
+
+  return (erg > LOWEST_VALUE) ? erg : INACTIVEVALUE;
+}
+
+void TemperatureLut::benchmark(Print *print)
+{
+  volatile float result;
+
+  for (uint8_t typeIndex = 0u; typeIndex < TEMPERATURE_LUT_TYPES; typeIndex++)
+  {
+    SensorType type = (SensorType)typeIndex;
+    float maxDeviation = 0.0f;
+    uint16_t maxDeviationRaw = 0u;
+
+    uint32_t exactTime = micros();
+    for (uint16_t raw = 0u; raw < TEMPERATURE_LUT_ADC_RANGE; raw++)
+      result = calcTemperatureExact(raw, type);
+    exactTime = micros() - exactTime;
+
+    uint32_t lutTime = micros();
+    for (uint16_t raw = 0u; raw < TEMPERATURE_LUT_ADC_RANGE; raw++)
+      result = calcTemperature(raw, type);
+    lutTime = micros() - lutTime;
+
+    for (uint16_t raw = 0u; raw < TEMPERATURE_LUT_ADC_RANGE; raw++)
+    {
+      float exact = calcTemperatureExact(raw, type);
+      float lut = calcTemperature(raw, type);
+
+      // only the range the sensors are used for
+      if ((INACTIVEVALUE == exact) || (exact > 500.0f))
+        continue;
+
+      if (fabs(exact - lut) > maxDeviation)
+      {
+        maxDeviation = fabs(exact - lut);
+        maxDeviationRaw = raw;
+      }
+    }
+
+    print->printf("%-12s exact: %6uus, lut: %6uus, max. deviation: %.4f°C (raw %u)\n",
+                  sensorTypeInfo[typeIndex].name, exactTime, lutTime, maxDeviation, maxDeviationRaw);
+  }
+
+  (void)result;
+}
@@ -0,0 +1,50 @@
+/*************************************************** 
+    Copyright (C) 2020  Martin Koerner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    
+    HISTORY: Please refer Github History
+    
+****************************************************/
+#pragma once
+
+#include "Arduino.h"
+#include "TemperatureSensors.h"
+
+#define TEMPERATURE_LUT_ADC_RANGE 4096u
+
+// The NTC and PTx curves are very steep at both ends of the ADC range,
+// so the table holds every raw value there and every 8th value in between.
+// Max. deviation to the Steinhart-Hart/Callendar-Van Dusen calculation is < 0.02°C.
+#define TEMPERATURE_LUT_LOW_END 256u
+#define TEMPERATURE_LUT_HIGH_START 3840u
+#define TEMPERATURE_LUT_SHIFT 3u
+#define TEMPERATURE_LUT_MID_COUNT ((TEMPERATURE_LUT_HIGH_START - TEMPERATURE_LUT_LOW_END) >> TEMPERATURE_LUT_SHIFT)
+#define TEMPERATURE_LUT_HIGH_INDEX (TEMPERATURE_LUT_LOW_END + TEMPERATURE_LUT_MID_COUNT)
+#define TEMPERATURE_LUT_SIZE (TEMPERATURE_LUT_HIGH_INDEX + (TEMPERATURE_LUT_ADC_RANGE - TEMPERATURE_LUT_HIGH_START) + 1u)
+
+// number of sensor types with an ADC based calculation (Maverick ... ThermoWorks)
+#define TEMPERATURE_LUT_TYPES ((uint8_t)SensorType::ThermoWorks + 1u)
+
+class TemperatureLut
+{
+public:
+  static float calcTemperature(uint16_t rawValue, SensorType type);
+  static float calcTemperatureExact(uint16_t rawValue, SensorType type);
+  static void benchmark(Print *print);
+
+private:
+  static float calcTemperatureNTC(uint16_t rawValue, SensorType type);
+  static float calcTemperaturePTx(uint16_t rawValue, SensorType type);
+};
@@ -19,7 +19,7 @@
 ****************************************************/
 #include "TemperatureMavRadio.h"
 #include "BBQ433SnifferV4.h"
-#include "ArduinoLog.h"
+#include "EventLog.h"
 
 #define RECEIVER_DETECTION_THRESHOLD 2u
 #define QUEUE_MAX_ITEM_NUM 1000u
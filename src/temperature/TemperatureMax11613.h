@@ -21,18 +21,17 @@
 #pragma once
 
 #include "TemperatureBase.h"
-#include "Wire.h"
+#include "TemperatureMax1161x.h"
 
 #define MAX11613_ADDRESS 0x34u
+#define MAX11613_CHANNELS 3u
 
 class TemperatureMax11613 : public TemperatureBase
 {
   public:
     TemperatureMax11613();
-    TemperatureMax11613(uint8_t index, TwoWire *twoWire);
+    TemperatureMax11613(uint8_t index, TemperatureMax1161x *chip);
     void update();
   private:
-    uint16_t readChip();
-    TwoWire *twoWire;
-    const uint8_t chipAddress = MAX11613_ADDRESS;
+    TemperatureMax1161x *chip;
 };
@@ -20,73 +20,23 @@
 ****************************************************/
 
 #include "TemperatureMax11615.h"
-#include "ArduinoLog.h"
-
-#define MAX1161X_SGL_DIF_BIT 0x01u
-#define MAX1161X_SCAN0_BIT 0x20u
-#define MAX1161X_SET_CSX(index) (index << 0x01u)
-
-union SplitTwoBytes {
-  uint16_t value;
-  struct
-  {
-    uint8_t lowByte;
-    uint8_t highByte;
-  };
-};
+#include "EventLog.h"
 
 TemperatureMax11615::TemperatureMax11615()
 {
 }
 
-TemperatureMax11615::TemperatureMax11615(uint8_t index, TwoWire *twoWire) : TemperatureBase()
+TemperatureMax11615::TemperatureMax11615(uint8_t index, TemperatureMax1161x *chip) : TemperatureBase()
 {
   this->address = TEMPERATURE_ADDRESS_INTERNAL;
   this->localIndex = index;
-  this->twoWire = twoWire;
-
-  // MAX11615
-  byte reg = 0xA0; // A0 = 10100000
-  // page 14
-  // 1: setup mode
-  // SEL:010 = Reference (Table 6)
-  // external(1)/internal(0) clock
-  // unipolar(0)/bipolar(1)
-  // 0: reset the configuration register to default
-  // 0: dont't care
-
-  this->twoWire->beginTransmission(this->chipAddress);
-  this->twoWire->write(reg);
-  byte error = this->twoWire->endTransmission();
-
-  if (error == 0) {
-    Log.trace("Add NTC: %X" CR, index);
-  }
+  this->chip = chip;
 }
 
 void TemperatureMax11615::update()
 {
   if (this->calcTemperature != NULL)
   {
-    this->medianValue->addValue(this->calcTemperature(this->readChip(), this->type));
+    this->medianValue.addValue(this->calcTemperature(this->chip->getRawValue(this->localIndex), this->type));
   }
 }
-
-uint16_t TemperatureMax11615::readChip()
-{
-  byte config;
-  SplitTwoBytes receive;
-
-  config = MAX1161X_SGL_DIF_BIT | MAX1161X_SCAN0_BIT | MAX1161X_SET_CSX(this->localIndex);
-
-  this->twoWire->beginTransmission(this->chipAddress);
-  this->twoWire->write(config);
-  this->twoWire->endTransmission();
-
-  this->twoWire->requestFrom(this->chipAddress, sizeof(receive));
-
-  receive.highByte = this->twoWire->read();
-  receive.lowByte = this->twoWire->read();
-
-  return receive.value & 4095;
-}
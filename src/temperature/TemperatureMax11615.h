@@ -20,19 +20,18 @@
 #pragma once
 
 #include "TemperatureBase.h"
-#include "Wire.h"
+#include "TemperatureMax1161x.h"
 
 #define MAX11615_ADDRESS 0x33u
+#define MAX11615_CHANNELS 8u
 
 class TemperatureMax11615 : public TemperatureBase
 {
 public:
   TemperatureMax11615();
-  TemperatureMax11615(uint8_t index, TwoWire *twoWire);
+  TemperatureMax11615(uint8_t index, TemperatureMax1161x *chip);
   void update();
 
 private:
-  uint16_t readChip();
-  TwoWire *twoWire;
-  const uint8_t chipAddress = MAX11615_ADDRESS;
+  TemperatureMax1161x *chip;
 };
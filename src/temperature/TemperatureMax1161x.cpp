@@ -0,0 +1,95 @@
+/*************************************************** 
+    Copyright (C) 2020  Martin Koerner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    
+    HISTORY: Please refer Github History
+    
+****************************************************/
+
+#include "TemperatureMax1161x.h"
+#include "EventLog.h"
+#include "BusLock.h"
+
+#define MAX1161X_SGL_DIF_BIT 0x01u
+#define MAX1161X_SCAN_AIN0_TO_CSX 0x00u
+#define MAX1161X_SET_CSX(index) (index << 0x01u)
+
+TemperatureMax1161x::TemperatureMax1161x(uint8_t chipAddress, uint8_t channelCount, TwoWire *twoWire)
+{
+  if (0u == channelCount)
+    Log.error("MAX1161x: invalid channel count 0, using 1" CR);
+
+  this->chipAddress = chipAddress;
+  // scan mode needs at least one channel (CSX = channelCount - 1)
+  this->channelCount = constrain(channelCount, (uint8_t)1u, (uint8_t)MAX1161X_MAX_CHANNELS);
+  this->twoWire = twoWire;
+
+  for (uint8_t i = 0u; i < MAX1161X_MAX_CHANNELS; i++)
+    this->rawValues[i] = 0u;
+
+  byte reg = 0xA0; // A0 = 10100000
+  // page 14
+  // 1: setup mode
+  // SEL:010 = Reference (Table 6)
+  // external(1)/internal(0) clock
+  // unipolar(0)/bipolar(1)
+  // 0: reset the configuration register to default
+  // 0: dont't care
+
+  gI2cBus.lock();
+  this->twoWire->beginTransmission(this->chipAddress);
+  this->twoWire->write(reg);
+  byte error = this->twoWire->endTransmission();
+  gI2cBus.release();
+
+  if (error == 0)
+  {
+    Log.trace("Add MAX1161x: %X, channels: %d" CR, this->chipAddress, this->channelCount);
+  }
+}
+
+void TemperatureMax1161x::acquire()
+{
+  // scan mode 00: convert AIN0 up to the selected channel, all results are read in one transfer
+  byte config = MAX1161X_SGL_DIF_BIT | MAX1161X_SCAN_AIN0_TO_CSX | MAX1161X_SET_CSX(this->channelCount - 1u);
+
+  gI2cBus.lock();
+  this->twoWire->beginTransmission(this->chipAddress);
+  this->twoWire->write(config);
+  this->twoWire->endTransmission();
+
+  uint8_t length = this->twoWire->requestFrom(this->chipAddress, (uint8_t)(this->channelCount * 2u));
+
+  for (uint8_t i = 0u; i < this->channelCount; i++)
+  {
+    if (length >= ((i + 1u) * 2u))
+    {
+      uint16_t value = this->twoWire->read() << 8;
+      value |= this->twoWire->read();
+      this->rawValues[i] = value & 4095;
+    }
+    else
+    {
+      // incomplete transfer, channel is handled as inactive
+      this->rawValues[i] = 0u;
+    }
+  }
+  gI2cBus.release();
+}
+
+uint16_t TemperatureMax1161x::getRawValue(uint8_t index)
+{
+  return (index < this->channelCount) ? this->rawValues[index] : 0u;
+}
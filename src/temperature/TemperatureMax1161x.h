@@ -0,0 +1,39 @@
+/*************************************************** 
+    Copyright (C) 2020  Martin Koerner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    
+    HISTORY: Please refer Github History
+    
+****************************************************/
+#pragma once
+
+#include "TemperatureChip.h"
+#include "Wire.h"
+
+#define MAX1161X_MAX_CHANNELS 12u
+
+class TemperatureMax1161x : public TemperatureChip
+{
+public:
+  TemperatureMax1161x(uint8_t chipAddress, uint8_t channelCount, TwoWire *twoWire);
+  void acquire();
+  uint16_t getRawValue(uint8_t index);
+
+private:
+  TwoWire *twoWire;
+  uint8_t chipAddress;
+  uint8_t channelCount;
+  uint16_t rawValues[MAX1161X_MAX_CHANNELS];
+};
@@ -20,7 +20,8 @@
 
 #include <SPI.h>
 #include "TemperatureMax31855.h"
-#include "ArduinoLog.h"
+#include "EventLog.h"
+#include "BusLock.h"
 
 #define MAX31855_FAULT_BITS 0x07u
 #define MAX31855_TEMPERATURE_MASK 0x1FFFu
@@ -29,6 +30,7 @@
 #define MAX31855_NEGATIVE_SIGN_BIT 0x2000u
 #define MAX31855_TEMPERATURE_UNIT 0.25
 #define MAX31855_TEMPERATURE_ADJ 1.0
+#define MAX31855_CONVERSION_TIME 100u // ms
 
 union SplitFourBytes
 {
@@ -53,11 +55,52 @@ TemperatureMax31855::TemperatureMax31855(uint8_t index, uint8_t csPin) : Tempera
   this->csPin = csPin;
   this->fixedSensor = true;
   this->type = SensorType::TypeK;
+  this->fault = Max31855NoFault;
+  this->conversionStart = 0u;
+  this->connected = false;
 }
 
 void TemperatureMax31855::update()
 {
-  this->medianValue->addValue(this->calcTemperatureTypeK(this->readChip()));
+  // a new conversion starts with CS high after each read, reading while it
+  // is running would abort it, so wait until it has completed
+  if ((millis() - this->conversionStart) < MAX31855_CONVERSION_TIME)
+    return;
+
+  uint32_t value = this->readChip();
+
+  this->checkFault(value & MAX31855_FAULT_BITS);
+
+  if (Max31855NoFault == this->fault)
+  {
+    this->medianValue.addValue(this->calcTemperatureTypeK(value));
+    // connected with the first valid conversion
+    this->connected = true;
+  }
+  else
+  {
+    this->medianValue.addValue(INACTIVEVALUE);
+  }
+}
+
+void TemperatureMax31855::checkFault(uint8_t newFault)
+{
+  if (newFault == this->fault)
+    return;
+
+  if (newFault & Max31855OpenCircuit)
+    Log.warning("Type K: thermocouple not connected" CR);
+  else if (newFault & Max31855ShortToGnd)
+    Log.warning("Type K: thermocouple short to GND" CR);
+  else if (newFault & Max31855ShortToVcc)
+    Log.warning("Type K: thermocouple short to VCC" CR);
+  else
+    Log.notice("Type K: thermocouple ok" CR);
+
+  // don't mix values from before and after the fault
+  this->medianValue.reset();
+  this->fault = newFault;
+  this->connected = (0u == (newFault & Max31855OpenCircuit));
 }
 
 boolean TemperatureMax31855::isBuiltIn()
@@ -89,20 +132,22 @@ uint32_t TemperatureMax31855::readChip()
 {
   SplitFourBytes receive;
 
+  gSpiBus.lock();
   SPI.beginTransaction(SPISettings(500000, MSBFIRST, SPI_MODE0));
   // write CS
   digitalWrite(csPin, LOW);
-  delay(1u);
 
   receive.byte3 = SPI.transfer(0u);
   receive.byte2 = SPI.transfer(0u);
   receive.byte1 = SPI.transfer(0u);
   receive.byte0 = SPI.transfer(0u);
 
-  // write CS
+  // write CS, starts the next conversion
   digitalWrite(csPin, HIGH);
+  this->conversionStart = millis();
 
   SPI.endTransaction();
+  gSpiBus.release();
 
   return receive.value;
 }
@@ -21,6 +21,14 @@
 
 #include "TemperatureBase.h"
 
+enum Max31855Fault
+{
+  Max31855NoFault = 0x00u,
+  Max31855OpenCircuit = 0x01u,
+  Max31855ShortToGnd = 0x02u,
+  Max31855ShortToVcc = 0x04u
+};
+
 class TemperatureMax31855 : public TemperatureBase
 {
 public:
@@ -28,9 +36,13 @@ public:
   TemperatureMax31855(uint8_t index, uint8_t csPin);
   void update();
   boolean isBuiltIn();
+  uint8_t getFault() { return this->fault; };
 
 private:
   uint32_t readChip();
   float calcTemperatureTypeK(uint32_t rawValue);
+  void checkFault(uint8_t newFault);
   uint8_t csPin;
+  uint8_t fault;
+  uint32_t conversionStart;
 };
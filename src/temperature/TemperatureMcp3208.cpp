@@ -20,60 +20,22 @@
 ****************************************************/
 
 #include "TemperatureMcp3208.h"
-#include <SPI.h>
-
-union SplitTwoBytes
-{
-  uint16_t value;
-  struct
-  {
-    uint8_t lowByte;
-    uint8_t highByte;
-  };
-};
 
 TemperatureMcp3208::TemperatureMcp3208()
 {
 }
 
-TemperatureMcp3208::TemperatureMcp3208(uint8_t index, uint8_t csPin) : TemperatureBase()
+TemperatureMcp3208::TemperatureMcp3208(uint8_t index, TemperatureMcp3208Chip *chip) : TemperatureBase()
 {
   this->address = TEMPERATURE_ADDRESS_INTERNAL;
   this->localIndex = index;
-  this->csPin = csPin;
+  this->chip = chip;
 }
 
 void TemperatureMcp3208::update()
 {
   if (this->calcTemperature != NULL)
   {
-    this->medianValue->addValue(this->calcTemperature(this->readChip(), this->type));
+    this->medianValue.addValue(this->calcTemperature(this->chip->getRawValue(this->localIndex), this->type));
   }
 }
-
-uint16_t TemperatureMcp3208::readChip()
-{
-  SplitTwoBytes receive;
-  SplitTwoBytes command;
-  command.value = 0x0400;
-
-  // set channel
-  command.value |= ((this->localIndex + 8u) << 6u);
-
-  SPI.beginTransaction(SPISettings(2000000, MSBFIRST, SPI_MODE0));
-  // write CS
-  digitalWrite(csPin, LOW);
-  // send first byte
-  SPI.transfer(command.highByte);
-  // send second byte and receive first 4 bits
-  receive.highByte = SPI.transfer(command.lowByte) & 0x0Fu;
-  // receive last 8 bits
-  receive.lowByte = SPI.transfer(0x00u);
-
-  // write CS
-  digitalWrite(csPin, HIGH);
-
-  SPI.endTransaction();
-
-  return receive.value;
-}
@@ -20,15 +20,15 @@
 #pragma once
 
 #include "TemperatureBase.h"
+#include "TemperatureMcp3208Chip.h"
 
 class TemperatureMcp3208 : public TemperatureBase
 {
 public:
   TemperatureMcp3208();
-  TemperatureMcp3208(uint8_t index, uint8_t csPin);
+  TemperatureMcp3208(uint8_t index, TemperatureMcp3208Chip *chip);
   void update();
 
 private:
-  uint16_t readChip();
-  uint8_t csPin;
+  TemperatureMcp3208Chip *chip;
 };
@@ -0,0 +1,135 @@
+/*************************************************** 
+    Copyright (C) 2020  Martin Koerner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    
+    HISTORY: Please refer Github History
+    
+****************************************************/
+
+#include "TemperatureMcp3208Chip.h"
+#include "EventLog.h"
+#include "BusLock.h"
+#include <SPI.h>
+#include <esp_heap_caps.h>
+
+#define MCP3208_CONVERSION_BYTES 3u
+#define MCP3208_START_SINGLE 0x0400u
+#define MCP3208_SET_CHANNEL(index) ((index) << 6u)
+
+TemperatureMcp3208Chip::TemperatureMcp3208Chip(uint8_t csPin, uint8_t channelCount, uint8_t oversampling)
+{
+  this->csPin = csPin;
+  this->channelCount = constrain(channelCount, (uint8_t)1u, (uint8_t)MCP3208_MAX_CHANNELS);
+  this->oversampling = max(oversampling, (uint8_t)1u);
+  this->txBuffer = NULL;
+  this->rxBuffer = NULL;
+  this->bufferSize = 0u;
+
+  for (uint8_t i = 0u; i < MCP3208_MAX_CHANNELS; i++)
+    this->rawValues[i] = 0u;
+
+  buildBuffers();
+}
+
+TemperatureMcp3208Chip::~TemperatureMcp3208Chip()
+{
+  freeBuffers();
+}
+
+void TemperatureMcp3208Chip::freeBuffers()
+{
+  if (this->txBuffer != NULL)
+    heap_caps_free(this->txBuffer);
+
+  if (this->rxBuffer != NULL)
+    heap_caps_free(this->rxBuffer);
+
+  this->txBuffer = NULL;
+  this->rxBuffer = NULL;
+  this->bufferSize = 0u;
+}
+
+void TemperatureMcp3208Chip::buildBuffers()
+{
+  freeBuffers();
+
+  uint16_t size = this->channelCount * this->oversampling * MCP3208_CONVERSION_BYTES;
+
+  // DMA capable memory, so the SPI driver does not need to copy the buffers
+  this->txBuffer = (uint8_t *)heap_caps_malloc(size, MALLOC_CAP_DMA);
+  this->rxBuffer = (uint8_t *)heap_caps_malloc(size, MALLOC_CAP_DMA);
+
+  if ((NULL == this->txBuffer) || (NULL == this->rxBuffer))
+  {
+    Log.error("MCP3208: no memory for %d bytes" CR, size);
+    freeBuffers();
+    return;
+  }
+
+  this->bufferSize = size;
+
+  // commands are static, build them once: one conversion of every channel per oversampling round
+  uint8_t *command = this->txBuffer;
+
+  for (uint8_t round = 0u; round < this->oversampling; round++)
+  {
+    for (uint8_t channel = 0u; channel < this->channelCount; channel++)
+    {
+      uint16_t value = MCP3208_START_SINGLE | MCP3208_SET_CHANNEL(channel + 8u);
+      *command++ = value >> 8;
+      *command++ = value & 0xFFu;
+      *command++ = 0x00u;
+    }
+  }
+}
+
+void TemperatureMcp3208Chip::acquire()
+{
+  if (0u == this->bufferSize)
+    return;
+
+  gSpiBus.lock();
+  SPI.beginTransaction(SPISettings(2000000, MSBFIRST, SPI_MODE0));
+
+  // a falling CS edge starts the next conversion, so CS is toggled for every conversion
+  for (uint16_t offset = 0u; offset < this->bufferSize; offset += MCP3208_CONVERSION_BYTES)
+  {
+    digitalWrite(this->csPin, LOW);
+    SPI.transferBytes(&this->txBuffer[offset], &this->rxBuffer[offset], MCP3208_CONVERSION_BYTES);
+    digitalWrite(this->csPin, HIGH);
+  }
+
+  SPI.endTransaction();
+  gSpiBus.release();
+
+  // decimation: mean of all conversions of a channel
+  for (uint8_t channel = 0u; channel < this->channelCount; channel++)
+  {
+    uint32_t sum = 0u;
+
+    for (uint8_t round = 0u; round < this->oversampling; round++)
+    {
+      const uint8_t *receive = &this->rxBuffer[((round * this->channelCount) + channel) * MCP3208_CONVERSION_BYTES];
+      sum += ((receive[1] & 0x0Fu) << 8) | receive[2];
+    }
+
+    this->rawValues[channel] = (sum + (this->oversampling / 2u)) / this->oversampling;
+  }
+}
+
+uint16_t TemperatureMcp3208Chip::getRawValue(uint8_t index)
+{
+  return (index < this->channelCount) ? this->rawValues[index] : 0u;
+}
@@ -0,0 +1,48 @@
+/*************************************************** 
+    Copyright (C) 2020  Martin Koerner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    
+    HISTORY: Please refer Github History
+    
+****************************************************/
+#pragma once
+
+#include "TemperatureChip.h"
+
+#define MCP3208_MAX_CHANNELS 8u
+#define MCP3208_DEFAULT_OVERSAMPLING 1u
+
+// Oversampling applies to all channels of the chip and is fixed at construction,
+// the DMA buffers are built once and never change while the temperature task reads them.
+class TemperatureMcp3208Chip : public TemperatureChip
+{
+public:
+  TemperatureMcp3208Chip(uint8_t csPin, uint8_t channelCount, uint8_t oversampling = MCP3208_DEFAULT_OVERSAMPLING);
+  ~TemperatureMcp3208Chip();
+  void acquire();
+  uint16_t getRawValue(uint8_t index);
+  uint8_t getOversampling() { return this->oversampling; };
+
+private:
+  void buildBuffers();
+  void freeBuffers();
+  uint8_t csPin;
+  uint8_t channelCount;
+  uint8_t oversampling;
+  uint16_t bufferSize;
+  uint8_t *txBuffer;
+  uint8_t *rxBuffer;
+  uint16_t rawValues[MCP3208_MAX_CHANNELS];
+};